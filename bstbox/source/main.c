@@ -1,4 +1,4 @@
-#include "avl_tree.h"
+#include "bst_engine.h"
 #include "bt_box.h"
 #include "bstbox_input.h"
 
@@ -19,44 +19,31 @@
 #define FLAG_SIDES      (FLAG_LEFT | FLAG_RIGHT)
 #define FLAG_CLOSED     (FLAG_TOP | FLAG_LEFT | FLAG_RIGHT | FLAG_BOTTOM)
 
+// Boxes of the current tree kept between prints, so that changes of a few values only re-measure
+// the boxes near them. Null when the tree changed as a whole.
+static BTBox* layout = NULL;
+
 #pragma region Function Declarations
 
-void create_random_tree(AVLNode** root, char* input);
-void insert_nodes(AVLNode** root, char* input);
-void delete_nodes(AVLNode** root, char* input);
-void print_tree(AVLNode* root);
-void reset_current_tree(AVLNode** root);
-void export_to_file(AVLNode* root, char* input);
-void import_from_file(AVLNode** root, char* input);
-int verify_tree_content(AVLNode* root);
+void create_random_tree(BSTree* tree, char* input);
+void insert_nodes(BSTree* tree, char* input);
+void delete_nodes(BSTree* tree, char* input);
+void find_nodes(BSTree* tree, char* input);
+void switch_engine(BSTree* tree, char* input);
+void print_stats(BSTree* tree);
+void print_tree(BSTree* tree);
+void update_layout(BSTree* tree, const int* values, int len);
+void discard_layout();
+void reset_current_tree(BSTree* tree);
+void export_to_file(BSTree* tree, char* input);
+void import_from_file(BSTree* tree, char* input);
+int verify_tree_content(BSTree* tree);
 char* print_action_menu();
 void print_frame(const char* text, int mask);
 int rand_range(int min, int max);
 
 #pragma endregion
 
-#define DEFINE_TREE_CONVERTER(__TYPE_S__, __TYPE_D__) \
-__TYPE_D__* convert_##__TYPE_S__##_to_##__TYPE_D__(__TYPE_S__ *tree) { \
-    if (tree == NULL) { \
-        return NULL; \
-    } \
-    __TYPE_D__ *btNode = NULL, *left = NULL, *right = NULL; \
-    if (tree->left) { \
-        left = convert_##__TYPE_S__##_to_##__TYPE_D__(tree->left); \
-    } \
-    if (tree->right) { \
-        right = convert_##__TYPE_S__##_to_##__TYPE_D__(tree->right); \
-    } \
-    btNode = (__TYPE_D__*)malloc(sizeof(__TYPE_D__)); \
-    btNode->value = tree->value; \
-    btNode->left = left; \
-    btNode->right = right; \
-    return btNode; \
-}
-
-DEFINE_TREE_CONVERTER(AVLNode, BTNode);
-DEFINE_TREE_CONVERTER(BTNode, AVLNode);
-
 /**
  Binary Tree Visualization
          ┏━━━┓         
@@ -67,8 +54,11 @@ DEFINE_TREE_CONVERTER(BTNode, AVLNode);
    ┗━━━┛       ┗━━━┛
  */
 int main(int argc, char* argv[]) {
-    AVLNode* tree = NULL;  // Pointer to the main tree object of the program.
+    BSTree tree;           // The main tree object of the program.
     char* input = NULL;    // Pointer to hold user input.
+    if (!bst_init(&tree, &bst_avl_engine)) {
+        return 1;
+    }
     while (1) {
         free(input); // Free input after each iteration.
         input = print_action_menu();
@@ -88,8 +78,20 @@ int main(int argc, char* argv[]) {
                 delete_nodes(&tree, input);
             break;
 
+            case 'F': case 'f':
+                find_nodes(&tree, input);
+            break;
+
+            case 'B': case 'b':
+                switch_engine(&tree, input);
+            break;
+
+            case 'S': case 's':
+                print_stats(&tree);
+            break;
+
             case 'V': case 'v':
-                print_tree(tree);
+                print_tree(&tree);
             break;
 
             case 'R': case 'r':
@@ -97,7 +99,7 @@ int main(int argc, char* argv[]) {
             break;
 
             case 'E': case 'e':
-                export_to_file(tree, input);
+                export_to_file(&tree, input);
             break;
 
             case 'M': case 'm':
@@ -110,7 +112,8 @@ int main(int argc, char* argv[]) {
 
 clean_up:
     free(input);
-    avl_free_tree(&tree);
+    discard_layout();
+    bst_free_tree(&tree);
 
     return 0;
 }
@@ -119,9 +122,9 @@ clean_up:
  * @brief First receive from user a number for node count, then generate random integers for node values.
  * 
  * Randomized values range around -500 -> 500.
- * @param root Tree's root node, will be deleted and re-allocated before insertion.
+ * @param tree The tree, will be cleared before insertion.
  */
-void create_random_tree(AVLNode** root, char* input) {
+void create_random_tree(BSTree* tree, char* input) {
     static const int MAX_RAND_VALUE = 1000;
     int nodeCount = atoi(input + 2);    // Skip the first two characters, which are 'C' and a space.
     printf("Creating tree with %d random nodes:", nodeCount);
@@ -137,77 +140,169 @@ void create_random_tree(AVLNode** root, char* input) {
     }
     printf("\n");
     
-    avl_free_tree(root); // Free the existing tree before creating a new one.
-    avl_insert_nodes(root, randValues, nodeCount);
+    // Replace the existing tree, in a single pass if the engine can.
+    if (!bst_build(tree, randValues, nodeCount)) {
+        printf("Not enough memory to create the tree.\n");
+    }
+    discard_layout();
 
     free(randValues);
-    print_tree(*root);
+    print_tree(tree);
 }
 
 /**
  * @brief Prompt user to enter a sequence of nodes to insert to the current tree.
  * 
- * @param root Tree's root node, will be allocated before insertion if null.
+ * @param tree The tree to insert into.
  */
-void insert_nodes(AVLNode** root, char* input) {
+void insert_nodes(BSTree* tree, char* input) {
     size_t size = 0;
     int* ints = bstbox_read_ints(input + 2, &size); // Skip the first two characters, which are 'I' and a space.
     printf("Inserting %lu integers.\n", size);
-    avl_insert_nodes(root, ints, size);
+    bst_insert_nodes(tree, ints, size);
+    update_layout(tree, ints, size);
     free(ints);
-    print_tree(*root);
+    print_tree(tree);
 }
 
 /**
  * @brief Prompt user to key in a number of integers to delete from the current tree.
  * 
  * The last node can also be deleted.
- * @param root Tree's root node, will be null if all nodes are deleted.
+ * @param tree The tree, whose root will be null if all nodes are deleted.
  */
-void delete_nodes(AVLNode** root, char* input) {
-    if (!verify_tree_content(*root)) {
+void delete_nodes(BSTree* tree, char* input) {
+    if (!verify_tree_content(tree)) {
         return;
     }
     size_t size = 0;
     int* ints = bstbox_read_ints(input + 2, &size);
     printf("Removing %lu integers.\n", size);
-    for (int i = 0; i < size; ++i) {
-        avl_remove_node(root, ints[i]);
+    int removed = bst_remove_nodes(tree, ints, size);
+    printf("Removed %d of them.\n", removed);
+    update_layout(tree, ints, size);
+    free(ints);
+    print_tree(tree);
+}
+
+/**
+ * @brief Look up a number of integers in the current tree and tell which of them exist.
+ *
+ * @param tree The tree to search.
+ */
+void find_nodes(BSTree* tree, char* input) {
+    if (!verify_tree_content(tree)) {
+        return;
     }
+    size_t size = 0;
+    int* ints = bstbox_read_ints(input + 2, &size);
+    int* found = (int*)malloc((size ? size : 1) * sizeof(int));
+    if (found) {
+        bst_find_values(tree, ints, size, found);
+        update_layout(tree, ints, size); // Lookups move nodes of self-adjusting trees.
+        printf("Found:");
+        for (int i = 0; i < size; ++i) {
+            if (found[i]) {
+                printf(" %d", ints[i]);
+            }
+        }
+        printf("\nNot found:");
+        for (int i = 0; i < size; ++i) {
+            if (!found[i]) {
+                printf(" %d", ints[i]);
+            }
+        }
+        printf("\n");
+    }
+    free(found);
     free(ints);
-    print_tree(*root);
+}
+
+/**
+ * @brief Switch the balancing method of the current tree, which keeps its values.
+ *
+ * Without a name, the available methods are listed.
+ * @param tree The tree to rebuild with the chosen method.
+ */
+void switch_engine(BSTree* tree, char* input) {
+    char c, name[strlen(input) + 1];
+    const BSTEngine* engine = NULL;
+    if (sscanf(input, "%c %s", &c, name) == 2) {
+        engine = bst_find_engine(name);
+    }
+    if (!engine) {
+        printf("Balancing methods:");
+        for (int i = 0; bst_get_engine(i); ++i) {
+            printf(" %s", bst_get_engine(i)->name);
+        }
+        printf("\nCurrent method: %s\n", tree->engine->name);
+        return;
+    }
+    if (!bst_switch_engine(tree, engine)) {
+        printf("Not enough memory to switch to %s.\n", engine->name);
+        return;
+    }
+    printf("Balancing with %s.\n", engine->name);
+    discard_layout();
+    print_tree(tree);
+}
+
+/**
+ * @brief Print how many comparisons and rotations the tree did since the last time, then reset them.
+ *
+ * @param tree The tree whose counters to print.
+ */
+void print_stats(BSTree* tree) {
+    printf("Balancing method: %s\n", tree->engine->name);
+    printf("Comparisons: %lld\n", tree->stats.comparisons);
+    printf("Rotations: %lld\n", tree->stats.rotations);
+    bst_reset_stats(tree);
 }
 
 /**
  * @brief Use BSTBox implementation to print the tree content to console output.
  * 
- * @param root Tree's root node.
+ * @param tree The tree to print.
  */
-void print_tree(AVLNode* root) {
-    if (!verify_tree_content(root)) {
+void print_tree(BSTree* tree) {
+    if (!verify_tree_content(tree)) {
         return;
     }
 
-    BTNode* btRoot = convert_AVLNode_to_BTNode(root);
-    BTBox* treeBox = btbox_create_tree(btRoot);
+    update_layout(tree, NULL, 0);
 
     printf("\n");
     print_frame("CURRENT TREE", FLAG_CLOSED);
 
     printf("\n");
-    btbox_print(stdout, treeBox);
+    btbox_print(stdout, layout);
+}
 
-    btbox_free_tree(treeBox);
-    btbox_free_node(btRoot);
+/**
+ * @brief Bring the kept boxes up to date after values were inserted, removed or looked up.
+ *
+ * Boxes are created if there are none, and only re-measured where the tree changed.
+ * @param values The changed values, which may be none.
+ */
+void update_layout(BSTree* tree, const int* values, int len) {
+    layout = bst_update_box(tree, layout, values, len);
+}
+
+/**
+ * @brief Free the kept boxes after the tree changed as a whole, they are created again on the next print.
+ */
+void discard_layout() {
+    btbox_free_tree(layout);
+    layout = NULL;
 }
 
 /**
  * @brief Prompt user to put in the text file's name to store tree content as presented on console UI.
  * 
- * @param root Tree's root node.
+ * @param tree The tree to export.
  */
-void export_to_file(AVLNode* root, char* input) {
-    if (!verify_tree_content(root)) {
+void export_to_file(BSTree* tree, char* input) {
+    if (!verify_tree_content(tree)) {
         return;
     }
 
@@ -222,26 +317,26 @@ void export_to_file(AVLNode* root, char* input) {
         return;
     }
 
-    BTNode *btRoot = convert_AVLNode_to_BTNode(root);
-    BTBox* box = btbox_create_tree(btRoot);
+    update_layout(tree, NULL, 0);
 
-    btbox_print(file, box); // Print the tree into output file stream instead of console output stream.
+    btbox_print(file, layout); // Print the tree into output file stream instead of console output stream.
 
     printf("File exported successfully at %s\n", fileName);
 
     fclose(file);
-    btbox_free_tree(box);
-    btbox_free_node(btRoot);
 }
 
 /**
  * @brief Delete all nodes from the tree and set to null.
  * 
- * @param root Tree's root node.
+ * @param tree The tree to reset.
  */
-void reset_current_tree(AVLNode** root) {
-    avl_free_tree(root);
-    verify_tree_content(*root);
+void reset_current_tree(BSTree* tree) {
+    if (!bst_build(tree, NULL, 0)) {
+        printf("Not enough memory to reset the tree.\n");
+    }
+    discard_layout();
+    verify_tree_content(tree);
 }
 
 /**
@@ -250,8 +345,8 @@ void reset_current_tree(AVLNode** root) {
  * This is to check before some tree's operations.
  * @return True If tree contains nodes, otherwise False.
  */
-int verify_tree_content(AVLNode* root) {
-    if (!root) {
+int verify_tree_content(BSTree* tree) {
+    if (!bst_get_root(tree)) {
         printf("\n");
         print_frame("TREE IS EMPTY.", FLAG_CLOSED);
         return 0;
@@ -273,10 +368,13 @@ char* print_action_menu() {
         "    > [C]reate a binary search tree from random nodes.\n"
         "    > [I]nsert nodes to current tree.\n"
         "    > [D]elete nodes from current tree.\n"
+        "    > [F]ind nodes in current tree.\n"
+        "    > Switch [B]alancing: avl rb treap splay wavl buffered bplus.\n"
+        "    > [S]how comparison and rotation counts.\n"
         "    > [V]iew current tree.\n"
         "    > [R]eset current tree.\n"
         "    > [E]xport to text file.\n"
-        "    > I[M]port from text file.\n"
+        "    > I[M]port from text file, \"keep\" keeps a balanced shape.\n"
         "    > [Q]uit.\n"
         "Please enter your choice: [LETTER] [SPACE] [ARGUMENTS] [ENTER]\n"
         "Example: \"I 1 2 3\" to insert 3 nodes, \"E tree.txt\" to export to file.\n",
@@ -350,9 +448,17 @@ int rand_range(int min, int max) {
     return min + (rand() % (max - min + 1));
 }
 
-void import_from_file(AVLNode** root, char* input) {
-    char c, fileName[strlen(input)];
-    sscanf(input, "%c %s", &c, fileName);
+/**
+ * @brief Replace the current tree by one read from a text file exported before.
+ *
+ * The tree is rebuilt balanced, unless "keep" follows the file's name and its shape is already valid.
+ * @param tree The tree to replace.
+ */
+void import_from_file(BSTree* tree, char* input) {
+    char c, fileName[strlen(input)], mode[strlen(input)];
+    mode[0] = '\0';
+    sscanf(input, "%c %s %s", &c, fileName, mode);
+    int keepShape = strcmp(mode, "keep") == 0;
     printf("Reading tree content from file \"%s\"\n", fileName);
 
     FILE *file = fopen(fileName, "r");
@@ -362,14 +468,27 @@ void import_from_file(AVLNode** root, char* input) {
     }
 
     BTNode *btRoot = btbox_restore_tree(file);
-    AVLNode *avlRoot = convert_BTNode_to_AVLNode(btRoot);
-    avl_update_tree_height(avlRoot);
-    AVLNode *temp = *root;
-    *root = avlRoot;
+    int imported = bst_import(tree, btRoot, &btbox_node_accessor, keepShape);
+    discard_layout();
+    switch (imported) {
+        case BST_IMPORT_SHAPE_KEPT:
+            printf("Kept the tree's shape, it is already balanced.\n");
+        break;
+
+        case BST_IMPORT_REBUILT:
+            printf(keepShape ? "Could not keep the tree's shape, rebuilt it balanced.\n" : "Rebuilt the tree balanced.\n");
+        break;
+
+        case BST_IMPORT_UNORDERED:
+            printf("The tree's values are not in BST order, sorted them into a balanced tree.\n");
+        break;
+
+        default:
+            printf("Not enough memory to import the tree.\n");
+    }
 
-    print_tree(*root);
+    print_tree(tree);
 
     fclose(file);
     btbox_free_node(btRoot);
-    avl_free_tree(&temp); // Free the old tree after replacing it with the new one.
-}
\ No newline at end of file
+}
@@ -24,7 +24,7 @@ gcc -Werror \
     bstbox/source/*.c tree/source/*.c tools/source/*.c \
     -Itree/include -Itools/include \
     -o $OUTPUT_FILE \
-    -lm
+    -lm -lpthread
 
 if [[ $? -eq 0 ]]; then
     echo "Build succeeded. Output file: $OUTPUT_FILE"
@@ -6,7 +6,7 @@ fi
 
 g++ -g \
     tree/source/*.c tools/source/*.c \
-    tools/test/*.cpp tree/test/avl/*.cpp tree/test/btbox/*.cpp \
+    tools/test/*.cpp tree/test/avl/*.cpp tree/test/bst/*.cpp tree/test/btbox/*.cpp \
     -Itree/include -Itools/include \
     -o build/treetest \
     -lfmt -lgtest -lpthread
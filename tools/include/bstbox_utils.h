@@ -2,6 +2,11 @@
 #define _BSTBOX_UTILS_H_
 
 char* bstbox_to_string(int value);
+char* bstbox_interval_to_string(int low, int high);
+int bstbox_int_width(int value);
+int bstbox_format_int(char* buffer, int value);
+int bstbox_interval_width(int low, int high);
+int bstbox_format_interval(char* buffer, int low, int high);
 
 static inline int bstbox_is_numeric(char c) {
     return (c >= '0' && c <= '9') || c == '-';
@@ -3,19 +3,95 @@
 #include <string.h>
 #include <stdio.h>
 
+// Two digits of every number below 100, so that formatting writes two digits per division.
+static const char DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
 char* bstbox_to_string(int value) {
-    const int max = 11;
-    char* buffer = (char*)malloc(max + 1); // 32 bits int can be represented in 11 digits + 1 for null terminator
+    char* buffer = (char*)malloc(bstbox_int_width(value) + 1);
     if (buffer == NULL) {
         return NULL;
     }
-    int actual = snprintf(buffer, max + 1, "%d", value);
-    if (actual < max) {
-        char* temp = (char*)realloc(buffer, actual + 1);
-        if (temp && temp != buffer) {
-            buffer = temp;
-        }
-    }
+    buffer[bstbox_format_int(buffer, value)] = '\0';
+    return buffer;
+}
 
+char* bstbox_interval_to_string(int low, int high) {
+    char* buffer = (char*)malloc(bstbox_interval_width(low, high) + 1);
+    if (buffer == NULL) {
+        return NULL;
+    }
+    buffer[bstbox_format_interval(buffer, low, high)] = '\0';
     return buffer;
 }
+
+/**
+ * @return Number of characters of the value in decimal, with its sign.
+ */
+int bstbox_int_width(int value) {
+    unsigned magnitude = value < 0 ? 0u - (unsigned)value : (unsigned)value;
+    int width = value < 0 ? 2 : 1;
+    while (magnitude >= 10) {
+        magnitude /= 10;
+        ++width;
+    }
+    return width;
+}
+
+/**
+ * @brief Write the value in decimal without terminator, e.g. straight into a line being printed.
+ * @param buffer Receives bstbox_int_width(value) characters.
+ * @return Number of characters written.
+ */
+int bstbox_format_int(char* buffer, int value) {
+    int width = bstbox_int_width(value);
+    unsigned magnitude = value < 0 ? 0u - (unsigned)value : (unsigned)value;
+    char* end = buffer + width;
+    while (magnitude >= 100) {
+        const char* pair = DIGIT_PAIRS + 2 * (magnitude % 100);
+        magnitude /= 100;
+        *--end = pair[1];
+        *--end = pair[0];
+    }
+    if (magnitude >= 10) {
+        *--end = DIGIT_PAIRS[2 * magnitude + 1];
+        *--end = DIGIT_PAIRS[2 * magnitude];
+    } else {
+        *--end = (char)('0' + magnitude);
+    }
+    if (value < 0) {
+        *--end = '-';
+    }
+    return width;
+}
+
+/**
+ * @return Number of characters of the interval written as "[low, high]".
+ */
+int bstbox_interval_width(int low, int high) {
+    return bstbox_int_width(low) + bstbox_int_width(high) + 4;
+}
+
+/**
+ * @brief Write the interval as "[low, high]" without terminator.
+ * @return Number of characters written.
+ */
+int bstbox_format_interval(char* buffer, int low, int high) {
+    char* end = buffer;
+    *end++ = '[';
+    end += bstbox_format_int(end, low);
+    *end++ = ',';
+    *end++ = ' ';
+    end += bstbox_format_int(end, high);
+    *end++ = ']';
+    return (int)(end - buffer);
+}
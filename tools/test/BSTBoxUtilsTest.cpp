@@ -26,3 +26,29 @@ TEST(UtilsTest, ToString_ValidInput) {
     free(result);
 }
 
+TEST(UtilsTest, IntervalToString_ValidInput) {
+    char *result = bstbox_interval_to_string(3, 9);
+    EXPECT_STREQ(result, "[3, 9]");
+    free(result);
+
+    result = bstbox_interval_to_string(-2147483647 - 1, 2147483647);
+    EXPECT_STREQ(result, "[-2147483648, 2147483647]");
+    free(result);
+}
+
+
+TEST(UtilsTest, FormatInt_MatchesPrintf) {
+    const int values[] = { 0, 7, -7, 10, 99, -100, 101, 4096, -65535, 123456789, 2147483647, -2147483647 - 1 };
+    for (int value : values) {
+        char expected[16];
+        char actual[16] = { 0 };
+        int width = snprintf(expected, sizeof(expected), "%d", value);
+        EXPECT_EQ(width, bstbox_int_width(value));
+        EXPECT_EQ(width, bstbox_format_int(actual, value));
+        EXPECT_STREQ(expected, actual);
+    }
+
+    char interval[32] = { 0 };
+    EXPECT_EQ(bstbox_interval_width(-2, 40), bstbox_format_interval(interval, -2, 40));
+    EXPECT_STREQ("[-2, 40]", interval);
+}
@@ -0,0 +1,51 @@
+#ifndef AVL_BUFFER_H
+#define AVL_BUFFER_H
+
+#include "avl_tree.h"
+#include "bst_engine.h"
+
+// Default number of pending changes a buffered tree collects before applying them.
+#define AVL_BUFFER_CAPACITY 1024
+
+/**
+ * @brief Change waiting in the buffer of an AVLBufferedTree.
+ */
+typedef struct AVLBufferEntry {
+    int value;
+
+    // 1 to insert the value, 0 to remove it.
+    int insert;
+} AVLBufferEntry;
+
+/**
+ * @brief AVL tree collecting insertions and deletions in a small sorted buffer.
+ *
+ * Changes are applied to the tree in batches when the buffer is full or when the tree itself
+ * is read, e.g. to be printed, so bursts of writes do not rebalance the tree value by value.
+ * Lookups are answered from the buffer first, then from the tree.
+ */
+typedef struct AVLBufferedTree {
+    // The tree holding changes applied so far.
+    AVLTree tree;
+
+    // Pending changes by increasing value, at most one per value.
+    AVLBufferEntry* entries;
+    int len;
+    int capacity;
+} AVLBufferedTree;
+
+extern const BSTEngine bst_buffered_engine;
+
+#pragma region Functions Declarations
+
+int avl_buffered_init(AVLBufferedTree* buffered, int capacity);
+void avl_buffered_free(AVLBufferedTree* buffered);
+void avl_buffered_insert(AVLBufferedTree* buffered, int value);
+void avl_buffered_remove(AVLBufferedTree* buffered, int value);
+int avl_buffered_contains(AVLBufferedTree* buffered, int value);
+void avl_buffered_flush(AVLBufferedTree* buffered);
+AVLNode* avl_buffered_get_root(AVLBufferedTree* buffered);
+
+#pragma endregion
+
+#endif
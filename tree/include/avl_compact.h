@@ -0,0 +1,72 @@
+#ifndef AVL_COMPACT_H
+#define AVL_COMPACT_H
+
+#include <stdint.h>
+
+#include "bt_box.h"
+
+// Index standing for a missing child. Slot 0 of the node array is never used by a node.
+#define AVL_COMPACT_NULL 0
+
+/**
+ * @brief 12-byte AVL node living in the array of an AVLCompactTree.
+ *
+ * Children are referenced by 32-bit indices into the tree's node array. The two highest bits
+ * of [left] hold the balance factor (right height - left height, stored plus one),
+ * leaving 30 bits for the index.
+ */
+typedef struct AVLCompactNode {
+    // Each node has an integer value.
+    int value;
+
+    // Packed balance factor and index of the left child.
+    uint32_t left;
+
+    // Index of the right child.
+    uint32_t right;
+} AVLCompactNode;
+
+/**
+ * @brief AVL tree whose nodes are stored in one growable array.
+ *
+ * Compared to AVLNode, a node takes half of the memory and children stay valid when the array
+ * is moved by growing. Node pointers, however, are invalidated by any insertion.
+ */
+typedef struct AVLCompactTree {
+    // Node array, where nodes[0] is reserved for AVL_COMPACT_NULL.
+    AVLCompactNode* nodes;
+
+    // Index of the root node, AVL_COMPACT_NULL if the tree is empty.
+    uint32_t root;
+
+    // Number of array slots in use, including reserved and released ones.
+    uint32_t used;
+
+    // Number of slots allocated for the array.
+    uint32_t capacity;
+
+    // Released slots waiting to be reused, chained through their right child.
+    uint32_t freeList;
+
+    // Number of values in the tree.
+    int size;
+} AVLCompactTree;
+
+#pragma region Functions Declarations
+
+void avl_compact_init(AVLCompactTree* tree);
+void avl_compact_free_tree(AVLCompactTree* tree);
+int avl_compact_insert_node(AVLCompactTree* tree, int value);
+void avl_compact_insert_nodes(AVLCompactTree* tree, const int* values, const int len);
+int avl_compact_remove_node(AVLCompactTree* tree, int value);
+AVLCompactNode* avl_compact_find_node(AVLCompactTree* tree, int value);
+int avl_compact_contains(AVLCompactTree* tree, int value);
+AVLCompactNode* avl_compact_lower_bound(AVLCompactTree* tree, int value);
+AVLCompactNode* avl_compact_upper_bound(AVLCompactTree* tree, int value);
+AVLCompactNode* avl_compact_get_root(AVLCompactTree* tree);
+int avl_compact_get_height(AVLCompactTree* tree);
+BTNodeAccessor avl_compact_accessor(AVLCompactTree* tree);
+
+#pragma endregion
+
+#endif
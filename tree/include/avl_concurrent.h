@@ -0,0 +1,87 @@
+#ifndef AVL_CONCURRENT_H
+#define AVL_CONCURRENT_H
+
+#include <pthread.h>
+
+#include "avl_tree.h"
+
+// Number of reader threads a concurrent tree can register.
+#define AVL_CONCURRENT_MAX_READERS 64
+
+/**
+ * @brief Node of a concurrent tree, whose fields are read without locks.
+ *
+ * [version] is odd while a writer changes the node's value or moves values out of its
+ * subtree. Readers check that it stays the same across every step they take from the node.
+ */
+typedef struct AVLConcurrentNode {
+    // The plain node, first so that the two types can be cast to each other.
+    AVLNode node;
+
+    // Change counter, odd while a change is in progress.
+    unsigned int version;
+
+    // Epoch when the node was unlinked, it is only freed after readers of that epoch are gone.
+    unsigned long long retireEpoch;
+
+    // Next node waiting to be freed.
+    struct AVLConcurrentNode* nextRetired;
+} AVLConcurrentNode;
+
+/**
+ * @brief Epoch announced by a reader thread, alone on its cache line.
+ */
+typedef struct AVLReaderSlot {
+    // Epoch observed when the current lookup started, zero while idle.
+    unsigned long long epoch;
+
+    char padding[64 - sizeof(unsigned long long)];
+} AVLReaderSlot;
+
+/**
+ * @brief AVL tree allowing lookups from many threads while insertions and deletions run.
+ *
+ * Lookups take no locks and write nothing shared: they validate node versions along the
+ * way and start over if a writer got in the way. Writers are serialized by a mutex.
+ * Removed nodes are kept until every lookup that might still see them has finished.
+ */
+typedef struct AVLConcurrentTree {
+    // Sentinel above the root, whose right child is the root.
+    AVLConcurrentNode holder;
+
+    // Taken by insertions and deletions.
+    pthread_mutex_t writeLock;
+
+    // Node storage, only accessed by the writer holding the lock.
+    AVLNodePool pool;
+
+    // Removed nodes not yet given back to the pool, the most recent first.
+    AVLConcurrentNode* retired;
+    int retiredCount;
+
+    // Current epoch, advanced each time retired nodes are reclaimed.
+    unsigned long long epoch;
+
+    // Number of registered readers and their slots.
+    int readerCount;
+    AVLReaderSlot readers[AVL_CONCURRENT_MAX_READERS];
+
+    // Number of values in the tree.
+    int size;
+} AVLConcurrentTree;
+
+#pragma region Functions Declarations
+
+void avl_concurrent_init(AVLConcurrentTree* tree);
+void avl_concurrent_free_tree(AVLConcurrentTree* tree);
+int avl_concurrent_add_reader(AVLConcurrentTree* tree);
+
+int avl_concurrent_insert_node(AVLConcurrentTree* tree, int value);
+int avl_concurrent_remove_node(AVLConcurrentTree* tree, int value);
+
+int avl_concurrent_contains(AVLConcurrentTree* tree, int reader, int value);
+int avl_concurrent_lower_bound(AVLConcurrentTree* tree, int reader, int value, int* result);
+
+#pragma endregion
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef AVL_ITERATOR_H
+#define AVL_ITERATOR_H
+
+#include "avl_tree.h"
+
+// Ancestors an iterator keeps, more than any AVL tree of int values can be deep.
+#define AVL_ITERATOR_DEPTH 64
+
+/**
+ * @brief In-order walk over a tree, forward or reverse, optionally limited to a range of values.
+ *
+ * Pending ancestors are kept in a fixed stack, so a walk needs neither recursion nor the heap
+ * and each step is O(1) amortized. The tree must not change while it is walked.
+ */
+typedef struct AVLIterator {
+    // Root of the walked tree, to find the way back if the stack ever overflows.
+    AVLNode* root;
+
+    // Nodes still to be visited, along with their subtrees on the walk's side, the next one on top.
+    AVLNode* stack[AVL_ITERATOR_DEPTH];
+    int depth;
+
+    // Set if ancestors were dropped from the bottom of a full stack.
+    int truncated;
+
+    // Last node returned.
+    AVLNode* current;
+
+    // Values visited are within [low, high].
+    int low;
+    int high;
+
+    // Nonzero to visit values in decreasing order.
+    int reverse;
+} AVLIterator;
+
+#pragma region Functions Declarations
+
+void avl_iterator_init(AVLIterator* iterator, AVLNode* root, int reverse);
+void avl_iterator_range(AVLIterator* iterator, AVLNode* root, int low, int high, int reverse);
+AVLNode* avl_iterator_next(AVLIterator* iterator);
+
+AVLNode* avl_successor(AVLNode* root, int value);
+AVLNode* avl_predecessor(AVLNode* root, int value);
+
+#pragma endregion
+
+#endif
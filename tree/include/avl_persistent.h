@@ -0,0 +1,29 @@
+#ifndef AVL_PERSISTENT_H
+#define AVL_PERSISTENT_H
+
+#include "avl_tree.h"
+
+/**
+ * @brief Node shared between versions of a persistent tree.
+ *
+ * A node is referenced by its parents in every version containing it, and by the version
+ * handle if it is a root. It is freed once none of them is left.
+ */
+typedef struct AVLPersistentNode {
+    // The plain node, first so that versions can be read with the avl_* lookups and printed.
+    AVLNode node;
+
+    // Number of parents and version handles referencing the node.
+    int refCount;
+} AVLPersistentNode;
+
+#pragma region Functions Declarations
+
+AVLNode* avl_persistent_insert_node(AVLNode* root, int value);
+AVLNode* avl_persistent_remove_node(AVLNode* root, int value);
+AVLNode* avl_persistent_retain(AVLNode* root);
+void avl_persistent_release(AVLNode* root);
+
+#pragma endregion
+
+#endif
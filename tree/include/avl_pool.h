@@ -0,0 +1,42 @@
+#ifndef AVL_POOL_H
+#define AVL_POOL_H
+
+struct AVLNode;
+struct AVLPoolPage;
+
+/**
+ * @brief Memory pool handing out AVL nodes from contiguous pages.
+ *
+ * Pages double from 64 up to 65536 nodes, so small pools own few pages, while past the cap
+ * a pool holding n nodes owns about n / 65536 pages, each released by one call to free.
+ * Released nodes are kept in a free list for reuse.
+ */
+typedef struct AVLNodePool {
+    // Allocated pages, the newest one first.
+    struct AVLPoolPage* pages;
+
+    // Released nodes waiting to be reused, chained through their left child.
+    struct AVLNode* freeList;
+
+    // Number of nodes already handed out from the newest page.
+    int pageUsed;
+
+    // Number of nodes the newest page can hold.
+    int pageCapacity;
+
+    // Size in bytes of each node, which may embed an AVLNode with extra data behind it.
+    int nodeSize;
+} AVLNodePool;
+
+#pragma region Functions Declarations
+
+void avl_pool_init(AVLNodePool* pool, int nodeSize);
+struct AVLNode* avl_pool_alloc(AVLNodePool* pool);
+void avl_pool_release(AVLNodePool* pool, struct AVLNode* node);
+void avl_pool_release_list(AVLNodePool* pool, struct AVLNode* first, struct AVLNode* last);
+void avl_pool_merge(AVLNodePool* pool, AVLNodePool* other);
+void avl_pool_free(AVLNodePool* pool);
+
+#pragma endregion
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef AVL_SNAPSHOT_H
+#define AVL_SNAPSHOT_H
+
+#include "avl_tree.h"
+
+// Slot standing for a missing result. Slot 0 of the key array is never used by a key.
+#define AVL_SNAPSHOT_NONE 0
+
+/**
+ * @brief Read-only copy of an AVL tree's values in Eytzinger (BFS) order.
+ *
+ * The root is at slot 1 and the children of slot k are at slots 2k and 2k + 1, so there are no
+ * pointers to chase and the first levels of every lookup share the same few cache lines.
+ * Lookups return slots, whose values are read from [keys].
+ */
+typedef struct AVLSnapshot {
+    // Values by slot, of [size] + 1 entries where keys[0] is unused.
+    int* keys;
+
+    // Number of values.
+    int size;
+} AVLSnapshot;
+
+#pragma region Functions Declarations
+
+void avl_snapshot_build(AVLSnapshot* snapshot, AVLNode* root);
+void avl_snapshot_build_sorted(AVLSnapshot* snapshot, const int* values, const int len);
+void avl_snapshot_free(AVLSnapshot* snapshot);
+
+int avl_snapshot_find(const AVLSnapshot* snapshot, int value);
+int avl_snapshot_contains(const AVLSnapshot* snapshot, int value);
+int avl_snapshot_lower_bound(const AVLSnapshot* snapshot, int value);
+int avl_snapshot_upper_bound(const AVLSnapshot* snapshot, int value);
+void avl_snapshot_find_values(const AVLSnapshot* snapshot, const int* values, const int len, int* results);
+
+int avl_snapshot_first(const AVLSnapshot* snapshot);
+int avl_snapshot_next(const AVLSnapshot* snapshot, int slot);
+int avl_snapshot_rank(const AVLSnapshot* snapshot, int value);
+int avl_snapshot_count_range(const AVLSnapshot* snapshot, int low, int high);
+
+#pragma endregion
+
+#endif
@@ -1,6 +1,10 @@
 #ifndef AVL_TREE_H
 #define AVL_TREE_H
 
+#include "avl_pool.h"
+#include "bst_stats.h"
+#include "bt_box.h"
+
 /**
  * @brief AVL Binary Search Tree using node height for balancing factor.
  */
@@ -19,16 +23,169 @@ typedef struct AVLNode {
     struct AVLNode* right;
 } AVLNode;
 
+// Augmentations a tree handle can maintain on its nodes, combined as bit flags.
+#define AVL_AUGMENT_NONE        0x00
+#define AVL_AUGMENT_AGGREGATES  0x01
+#define AVL_AUGMENT_INTERVALS   0x02
+
+// Default share of the tree, in percent, from which batch deletion rebuilds the tree instead of removing keys one by one.
+#define AVL_REBUILD_PERCENT 25
+
+/**
+ * @brief Node of a tree with AVL_AUGMENT_AGGREGATES, carrying summaries of its subtree.
+ *
+ * Summaries are kept up to date through insertion, deletion and rotations, which makes
+ * order statistics and range aggregates answerable in O(log n).
+ */
+typedef struct AVLAggregateNode {
+    // The plain node, first so that the two types can be cast to each other.
+    AVLNode node;
+
+    // Number of nodes in the subtree.
+    int count;
+
+    // Smallest and largest values in the subtree.
+    int min;
+    int max;
+
+    // Sum of all values in the subtree.
+    long long sum;
+} AVLAggregateNode;
+
+/**
+ * @brief Interval of a node in a tree with AVL_AUGMENT_INTERVALS, whose value is the interval's low end.
+ *
+ * Each node keeps the largest high end of its subtree, so that stabbing and overlap queries
+ * skip subtrees ending before the queried range.
+ */
+typedef struct AVLInterval {
+    // High end of the node's interval [value, high], equal to the value for values inserted as points.
+    int high;
+
+    // Largest high end in the subtree.
+    int maxHigh;
+} AVLInterval;
+
+/**
+ * @brief Handle of an AVL tree whose nodes are served from its own pool.
+ *
+ * Nodes removed from the tree are recycled by later insertions, and the whole tree
+ * is released by freeing the pool's pages instead of visiting every node.
+ */
+typedef struct AVLTree {
+    // Root node, or null if the tree is empty.
+    AVLNode* root;
+
+    // Storage of all nodes in the tree.
+    AVLNodePool pool;
+
+    // AVL_AUGMENT_* flags selecting the data maintained on the nodes.
+    int augments;
+
+    // Counters of insertions and deletions, null unless the caller wants them.
+    BSTStats* stats;
+
+    // Changed on every modification, so that cursors notice when their path is outdated.
+    unsigned version;
+
+    // Batch deletions of at least this share of the tree, in percent, rebuild it in O(n).
+    int rebuildPercent;
+
+    // Counts rebuilds and replacements of the whole tree, which may move any node, so that
+    // layouts kept of the tree know to start over.
+    unsigned rebuilds;
+} AVLTree;
+
+// Levels a cursor can record, more than any AVL tree of int values can be deep.
+#define AVL_CURSOR_DEPTH 64
+
+/**
+ * @brief Finger into a tree handle, remembering the path to the last position it was moved to.
+ *
+ * Searches start from that position, which makes sorted and nearly sorted sequences of
+ * operations cheap. Changes made to the tree by other means send the next search back to the root.
+ */
+typedef struct AVLCursor {
+    AVLTree* tree;
+
+    // Links from the root down to the position, with exclusive bounds of the values below each link.
+    AVLNode** links[AVL_CURSOR_DEPTH];
+    long long low[AVL_CURSOR_DEPTH];
+    long long high[AVL_CURSOR_DEPTH];
+    int depth;
+
+    // Version of the tree the links belong to.
+    unsigned version;
+} AVLCursor;
+
+/**
+ * @return The node with its subtree summaries, only valid for trees with AVL_AUGMENT_AGGREGATES.
+ */
+static inline AVLAggregateNode* avl_aggregate(AVLNode* node) {
+    return (AVLAggregateNode*)node;
+}
+
+/**
+ * @return The node's interval, stored after the other augmentations, only valid for trees with AVL_AUGMENT_INTERVALS.
+ */
+static inline AVLInterval* avl_interval(const AVLTree* tree, AVLNode* node) {
+    size_t offset = (tree->augments & AVL_AUGMENT_AGGREGATES) ? sizeof(AVLAggregateNode) : sizeof(AVLNode);
+    return (AVLInterval*)((char*)node + offset);
+}
+
 #pragma region Functions Declarations
 
 AVLNode* avl_create_tree(const int* values, const int len);
+AVLNode* avl_build_tree(const int* values, const int len);
+AVLNode* avl_build_sorted_tree(const int* values, const int len);
 AVLNode* avl_create_node(int value);
 int avl_insert_node(AVLNode** root, int value);
 void avl_insert_nodes(AVLNode** root, const int* values, const int len);
 int avl_remove_node(AVLNode** root, int value);
+int avl_remove_nodes(AVLNode** root, const int* values, const int len);
 void avl_free_tree(AVLNode** root);
 void avl_update_tree_height(AVLNode *root);
 
+AVLNode* avl_find_node(AVLNode* root, int value);
+int avl_contains(AVLNode* root, int value);
+AVLNode* avl_lower_bound(AVLNode* root, int value);
+AVLNode* avl_upper_bound(AVLNode* root, int value);
+void avl_find_nodes(AVLNode* root, const int* values, const int len, AVLNode** results);
+
+void avl_tree_init(AVLTree* tree);
+void avl_tree_init_augmented(AVLTree* tree, int augments);
+AVLNode* avl_tree_create_node(AVLTree* tree, int value);
+int avl_tree_insert_node(AVLTree* tree, int value);
+void avl_tree_insert_nodes(AVLTree* tree, const int* values, const int len);
+int avl_tree_build(AVLTree* tree, const int* values, const int len);
+int avl_tree_build_sorted(AVLTree* tree, const int* values, const int len);
+int avl_tree_remove_node(AVLTree* tree, int value);
+int avl_tree_remove_nodes(AVLTree* tree, const int* values, const int len);
+void avl_tree_clear(AVLTree* tree);
+int avl_tree_import_shape(AVLTree* tree, const void* root, const BTNodeAccessor* accessor, int len);
+
+int avl_tree_rank(AVLTree* tree, int value);
+AVLNode* avl_tree_select(AVLTree* tree, int index);
+int avl_tree_count_range(AVLTree* tree, int low, int high);
+long long avl_tree_range_sum(AVLTree* tree, int low, int high);
+
+int avl_tree_insert_interval(AVLTree* tree, int low, int high);
+int avl_tree_stab(AVLTree* tree, int point, void (*visit)(int low, int high, void* context), void* context);
+int avl_tree_overlap(AVLTree* tree, int low, int high, void (*visit)(int low, int high, void* context), void* context);
+BTNodeAccessor avl_tree_interval_accessor(AVLTree* tree);
+
+AVLNode* avl_tree_join(AVLTree* tree, AVLNode* left, AVLNode* node, AVLNode* right);
+AVLNode* avl_tree_split(AVLTree* tree, AVLNode* root, int value, AVLNode** left, AVLNode** right);
+int avl_tree_union(AVLTree* tree, AVLTree* other, int threads);
+int avl_tree_intersection(AVLTree* tree, AVLTree* other, int threads);
+int avl_tree_difference(AVLTree* tree, AVLTree* other, int threads);
+
+void avl_cursor_init(AVLCursor* cursor, AVLTree* tree);
+AVLNode* avl_cursor_get(AVLCursor* cursor);
+AVLNode* avl_cursor_find(AVLCursor* cursor, int value);
+int avl_cursor_insert(AVLCursor* cursor, int value);
+int avl_cursor_remove(AVLCursor* cursor);
+
 #pragma endregion
 
 #endif
\ No newline at end of file
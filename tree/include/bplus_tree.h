@@ -0,0 +1,60 @@
+#ifndef BPLUS_TREE_H
+#define BPLUS_TREE_H
+
+#include "bst_engine.h"
+
+// Keys per node, so that the key count and the keys of a node fill one 64-byte cache line.
+#define BPLUS_MAX_KEYS 15
+
+// Keys of every node except the root, at least half full.
+#define BPLUS_MIN_KEYS (BPLUS_MAX_KEYS / 2)
+
+/**
+ * @brief B+tree node. Values are the keys of leaves, keys of inner nodes route searches.
+ */
+typedef struct BPlusNode {
+    // Number of keys in use, then the keys in ascending order, all in the node's first cache line.
+    int count;
+    int keys[BPLUS_MAX_KEYS];
+
+    // Inner nodes: count + 1 children, where keys[i] is greater than every value under children[i]
+    // and not greater than any value under children[i + 1]. All null in leaves.
+    struct BPlusNode* children[BPLUS_MAX_KEYS + 1];
+
+    // Leaves: the leaf holding the next greater values, or null for the last leaf.
+    struct BPlusNode* next;
+} BPlusNode;
+
+/**
+ * @brief In-memory B+tree, whose wide nodes need a few cache lines per level where binary trees need one per node.
+ *
+ * Node splits, merges and moves of a key to a sibling are counted as rotations,
+ * comparisons count every key a search compares with.
+ */
+typedef struct BPlusTree {
+    // Root node, or null if the tree is empty.
+    BPlusNode* root;
+
+    // Number of levels, 0 if the tree is empty and 1 if the root is a leaf.
+    int height;
+
+    // Counters to write to, or null.
+    BSTStats* stats;
+} BPlusTree;
+
+extern const BSTEngine bst_bplus_engine;
+
+#pragma region Functions Declarations
+
+void bplus_tree_init(BPlusTree* tree, BSTStats* stats);
+int bplus_tree_insert_node(BPlusTree* tree, int value);
+int bplus_tree_remove_node(BPlusTree* tree, int value);
+int bplus_tree_contains(BPlusTree* tree, int value);
+int bplus_tree_build(BPlusTree* tree, const int* values, int len);
+int bplus_tree_import_shape(BPlusTree* tree, const void* root, const BTNodeAccessor* accessor, int len);
+int bplus_tree_range(BPlusTree* tree, int low, int high, void (*visit)(int value, void* context), void* context);
+void bplus_tree_clear(BPlusTree* tree);
+
+#pragma endregion
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef BST_ENGINE_H
+#define BST_ENGINE_H
+
+#include "bst_stats.h"
+#include "bt_box.h"
+
+/**
+ * @brief Operations of a balancing method, over a tree handle of the engine's own type.
+ *
+ * Engines count their work into the BSTStats given at creation.
+ */
+typedef struct BSTEngine {
+    // Short name to select the engine with, e.g. "avl".
+    const char* name;
+
+    // Allocate an empty tree handle, or return null if out of memory.
+    void* (*create)(BSTStats* stats);
+
+    // Delete the handle with all of its nodes.
+    void (*destroy)(void* tree);
+
+    // Return 1 if the value is inserted or removed, 0 if it already exists or is not found.
+    int (*insert)(void* tree, int value);
+    int (*remove)(void* tree, int value);
+
+    // Return 1 if the value is in the tree. Self-adjusting engines may restructure the tree.
+    int (*contains)(void* tree, int value);
+
+    // Return the root node, read through [accessor].
+    const void* (*get_root)(void* tree);
+
+    // Reads nodes for iteration and rendering.
+    BTNodeAccessor accessor;
+
+    // Optional, replace the content by the given values in any order, with duplicates.
+    // Return 1 if succeeded, 0 if out of memory with the content unchanged.
+    int (*build)(void* tree, const int* values, int len);
+
+    // Optional, set found[i] to whether values[i] is in the tree.
+    void (*find_values)(void* tree, const int* values, int len, int* found);
+
+    // Optional, insert values in any order, skipping those already in the tree.
+    void (*insert_values)(void* tree, const int* values, int len);
+
+    // Optional, remove values in any order and return how many were in the tree.
+    int (*remove_values)(void* tree, const int* values, int len);
+
+    // Optional, replace the content by a copy of [root]'s tree, whose values are known to be in order.
+    // Return 1 if the copy satisfies the engine's balance rules, otherwise 0 and the tree is empty.
+    int (*import_shape)(void* tree, const void* root, const BTNodeAccessor* accessor, int len);
+
+    // Set if operations may reshape the tree away from the paths to the values they change, e.g.
+    // splaying each value of a batch in turn. Boxes are then created again instead of updated.
+    int reshapesAnywhere;
+
+    // Optional, return a count changed whenever the tree is rebuilt as a whole, e.g. by a large
+    // batch removal. Boxes kept from before a rebuild are then created again instead of updated.
+    unsigned (*get_rebuilds)(void* tree);
+} BSTEngine;
+
+/**
+ * @brief Binary search tree whose balancing method can be chosen and changed at runtime.
+ *
+ * The handle owns the counters its engine writes to, so it must not be moved once initialized.
+ */
+typedef struct BSTree {
+    // The balancing method in use.
+    const BSTEngine* engine;
+
+    // Engine's own tree handle.
+    void* impl;
+
+    // Work done by the engine since the counters were last reset.
+    BSTStats stats;
+
+    // The engine's rebuild count when boxes were last created, see bst_update_box.
+    unsigned boxedRebuilds;
+} BSTree;
+
+// Results of bst_import.
+#define BST_IMPORT_FAILED       -1
+#define BST_IMPORT_SHAPE_KEPT   0
+#define BST_IMPORT_REBUILT      1
+#define BST_IMPORT_UNORDERED    2
+
+extern const BSTEngine bst_avl_engine;
+extern const BSTEngine bst_rb_engine;
+extern const BSTEngine bst_treap_engine;
+extern const BSTEngine bst_splay_engine;
+extern const BSTEngine bst_wavl_engine;
+
+#pragma region Functions Declarations
+
+const BSTEngine* bst_find_engine(const char* name);
+const BSTEngine* bst_get_engine(int index);
+
+int bst_init(BSTree* tree, const BSTEngine* engine);
+void bst_free_tree(BSTree* tree);
+int bst_switch_engine(BSTree* tree, const BSTEngine* engine);
+void bst_reset_stats(BSTree* tree);
+
+int bst_insert_node(BSTree* tree, int value);
+void bst_insert_nodes(BSTree* tree, const int* values, const int len);
+int bst_remove_node(BSTree* tree, int value);
+int bst_remove_nodes(BSTree* tree, const int* values, const int len);
+int bst_contains(BSTree* tree, int value);
+void bst_find_values(BSTree* tree, const int* values, const int len, int* found);
+int bst_build(BSTree* tree, const int* values, const int len);
+int bst_import(BSTree* tree, const void* root, const BTNodeAccessor* accessor, int keepShape);
+
+const void* bst_get_root(BSTree* tree);
+void bst_for_each(BSTree* tree, void (*visit)(int value, void* context), void* context);
+int bst_count_nodes(BSTree* tree);
+int bst_collect_values(BSTree* tree, int* values);
+BTBox* bst_create_box(BSTree* tree);
+void bst_print(FILE* file, BSTree* tree);
+BTBox* bst_update_box(BSTree* tree, BTBox* box, const int* values, const int len);
+
+#pragma endregion
+
+#endif
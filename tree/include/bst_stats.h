@@ -0,0 +1,15 @@
+#ifndef BST_STATS_H
+#define BST_STATS_H
+
+/**
+ * @brief Work counted by a balanced tree while it runs operations, to compare balancing methods.
+ */
+typedef struct BSTStats {
+    // Value comparisons made while searching, one per visited node.
+    long long comparisons;
+
+    // Single rotations, a double rotation counts as two.
+    long long rotations;
+} BSTStats;
+
+#endif
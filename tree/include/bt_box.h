@@ -8,6 +8,8 @@
 /**
  * @brief Contain calculation results for printing. 
  * BSTBox node replicates the binary tree structure it prints.
+ * Nodes with several keys are drawn as one wide box, split by a line between keys, whose
+ * outer children hang from its sides and inner children from the lines between keys.
  *
  * Origin
  *  (0,0) ╭┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄┄╮
@@ -29,8 +31,6 @@ typedef struct BTBox {
     int value;
     struct BTBox* left;
     struct BTBox* right;
-    // Display value in string.
-    char* valueString;
     // Total width of the entire tree, covering nodes of all levels underneath.
     int width;
     // Total height of the tree
@@ -41,6 +41,19 @@ typedef struct BTBox {
     int boxWidth;
     // Offset inside parent of the right child
     int rightOffset;
+    // Number of keys shown in the box, more than 1 for multi-key nodes, e.g. of B-trees.
+    int keyCount;
+    // Multi-key nodes only: all keys in order with [value] being the first one, and keyCount + 1
+    // children with their offsets inside parent. [left] and [right] are the outermost children.
+    int* keys;
+    struct BTBox** children;
+    int* childOffsets;
+    // Set for nodes of interval trees, whose box shows the interval [value, high].
+    int isInterval;
+    int high;
+    // Set if the node needs measuring, because it is new or the layout below it changed.
+    // Every ancestor of a node to measure is set too, so clean subtrees keep their measures.
+    int dirty;
 } BTBox;
 
 /**
@@ -50,14 +63,57 @@ typedef struct BTNode {
     int value;
     struct BTNode* left;
     struct BTNode* right;
+
+    // Multi-key nodes only, with keyCount > 1: all keys in order with [value] being the first one,
+    // and keyCount + 1 children, or null if the node is a leaf. [left] and [right] are null then.
+    int keyCount;
+    int* keys;
+    struct BTNode** children;
 } BTNode;
 
+/**
+ * Read access to nodes of any binary tree type, so that the tree can be printed without
+ * copying it into BTNode first.
+ */
+typedef struct BTNodeAccessor {
+    // Return the left or right child of a node, or null if there is none.
+    const void* (*left)(const void* node, const void* context);
+    const void* (*right)(const void* node, const void* context);
+
+    // Return the value of a node.
+    int (*value)(const void* node, const void* context);
+
+    // Passed to every callback, e.g. the array holding index-linked nodes.
+    const void* context;
+
+    // Optional, for trees whose nodes hold several keys. Return the number of keys of a node,
+    // one of its keys, or one of its key count + 1 children, null for leaves. Nodes with one key
+    // are drawn as binary nodes. Accessors with these callbacks may leave [left] and [right] null.
+    int (*key_count)(const void* node, const void* context);
+    int (*key)(const void* node, int index, const void* context);
+    const void* (*child)(const void* node, int index, const void* context);
+
+    // Set if only the keys of leaves are values, while keys of inner nodes just route searches
+    // and repeat some of them, as in B+trees.
+    int leafValues;
+
+    // Optional, for interval trees. Return the high end of the node's interval, whose low end
+    // is the node's value. Boxes then show "[low, high]".
+    int (*high)(const void* node, const void* context);
+} BTNodeAccessor;
+
+// Reads BTNode trees, e.g. those restored from a file.
+extern const BTNodeAccessor btbox_node_accessor;
+
 // Function declarations
 BTNode* btbox_create_node(int value);
 BTBox* btbox_create_tree(BTNode* tree);
+BTBox* btbox_create_tree_with(const void* tree, const BTNodeAccessor* accessor);
+BTBox* btbox_update_tree_with(BTBox* box, const void* tree, const BTNodeAccessor* accessor, const int* values, int len);
 void btbox_free_tree(BTBox* root);
 void btbox_free_node(BTNode *node);
 void btbox_print(FILE* file, BTBox* node);
+void btbox_print_with(FILE* file, const void* tree, const BTNodeAccessor* accessor);
 BTNode* btbox_restore_tree(FILE* file);
 
 #endif
\ No newline at end of file
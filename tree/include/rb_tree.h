@@ -0,0 +1,43 @@
+#ifndef RB_TREE_H
+#define RB_TREE_H
+
+#include "bst_engine.h"
+
+/**
+ * @brief Red-black tree node, with a link to its parent for bottom-up fixing.
+ */
+typedef struct RBNode {
+    // Each node has an integer value.
+    int value;
+
+    // 1 for red, 0 for black. Missing children count as black.
+    int red;
+
+    struct RBNode* left;
+    struct RBNode* right;
+    struct RBNode* parent;
+} RBNode;
+
+/**
+ * @brief Red-black tree, where no red node has a red child and every path from a node down
+ * to a missing child passes the same number of black nodes.
+ */
+typedef struct RBTree {
+    // Root node, or null if the tree is empty.
+    RBNode* root;
+
+    // Counters to write to, or null.
+    BSTStats* stats;
+} RBTree;
+
+#pragma region Functions Declarations
+
+void rb_tree_init(RBTree* tree, BSTStats* stats);
+int rb_tree_insert_node(RBTree* tree, int value);
+int rb_tree_remove_node(RBTree* tree, int value);
+RBNode* rb_tree_find_node(RBTree* tree, int value);
+void rb_tree_clear(RBTree* tree);
+
+#pragma endregion
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef SPLAY_TREE_H
+#define SPLAY_TREE_H
+
+#include "bst_engine.h"
+
+/**
+ * @brief Splay tree node, without any balancing data.
+ */
+typedef struct SplayNode {
+    // Each node has an integer value.
+    int value;
+
+    struct SplayNode* left;
+    struct SplayNode* right;
+} SplayNode;
+
+/**
+ * @brief Self-adjusting tree moving every accessed value to the root, which makes
+ * frequently accessed values fast to reach. Operations take O(log n) amortized time.
+ */
+typedef struct SplayTree {
+    // Root node, or null if the tree is empty.
+    SplayNode* root;
+
+    // Counters to write to, or null.
+    BSTStats* stats;
+} SplayTree;
+
+#pragma region Functions Declarations
+
+void splay_tree_init(SplayTree* tree, BSTStats* stats);
+int splay_tree_insert_node(SplayTree* tree, int value);
+int splay_tree_remove_node(SplayTree* tree, int value);
+SplayNode* splay_tree_find_node(SplayTree* tree, int value);
+void splay_tree_clear(SplayTree* tree);
+
+#pragma endregion
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef TREAP_H
+#define TREAP_H
+
+#include "bst_engine.h"
+
+/**
+ * @brief Treap node, ordered by value as a search tree and by priority as a max-heap.
+ */
+typedef struct TreapNode {
+    // Each node has an integer value.
+    int value;
+
+    // Random priority, not less than the priorities of the children.
+    unsigned int priority;
+
+    struct TreapNode* left;
+    struct TreapNode* right;
+} TreapNode;
+
+/**
+ * @brief Treap, whose random priorities keep the expected depth logarithmic.
+ */
+typedef struct Treap {
+    // Root node, or null if the treap is empty.
+    TreapNode* root;
+
+    // State of the priority generator.
+    unsigned int seed;
+
+    // Counters to write to, or null.
+    BSTStats* stats;
+} Treap;
+
+#pragma region Functions Declarations
+
+void treap_init(Treap* treap, unsigned int seed, BSTStats* stats);
+int treap_insert_node(Treap* treap, int value);
+int treap_remove_node(Treap* treap, int value);
+TreapNode* treap_find_node(Treap* treap, int value);
+void treap_clear(Treap* treap);
+
+#pragma endregion
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef WAVL_TREE_H
+#define WAVL_TREE_H
+
+#include "bst_engine.h"
+
+/**
+ * @brief Weak AVL tree node, balanced by rank instead of height.
+ */
+typedef struct WAVLNode {
+    // Each node has an integer value.
+    int value;
+
+    // Rank, where missing children count as -1. Leaves have rank 0, and every node
+    // is ranked 1 or 2 above each of its children.
+    int rank;
+
+    struct WAVLNode* left;
+    struct WAVLNode* right;
+} WAVLNode;
+
+/**
+ * @brief Weak AVL tree, equal to an AVL tree while only insertions happen.
+ * Deletions take at most two rotations, unlike AVL trees which may rotate on every level.
+ */
+typedef struct WAVLTree {
+    // Root node, or null if the tree is empty.
+    WAVLNode* root;
+
+    // Counters to write to, or null.
+    BSTStats* stats;
+} WAVLTree;
+
+#pragma region Functions Declarations
+
+void wavl_tree_init(WAVLTree* tree, BSTStats* stats);
+int wavl_tree_insert_node(WAVLTree* tree, int value);
+int wavl_tree_remove_node(WAVLTree* tree, int value);
+WAVLNode* wavl_tree_find_node(WAVLTree* tree, int value);
+void wavl_tree_clear(WAVLTree* tree);
+
+#pragma endregion
+
+#endif
@@ -0,0 +1,297 @@
+#include "avl_buffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#pragma region Function Declarations
+static void record(AVLBufferedTree* buffered, int value, int insert);
+static int find_entry(AVLBufferedTree* buffered, int value);
+static void discard(AVLBufferedTree* buffered);
+
+static void* engine_create(BSTStats* stats);
+static void engine_destroy(void* tree);
+static int engine_insert(void* tree, int value);
+static int engine_remove(void* tree, int value);
+static int engine_contains(void* tree, int value);
+static const void* engine_get_root(void* tree);
+static int engine_build(void* tree, const int* values, int len);
+static void engine_insert_values(void* tree, const int* values, int len);
+static int engine_remove_values(void* tree, const int* values, int len);
+static int engine_import_shape(void* tree, const void* root, const BTNodeAccessor* accessor, int len);
+static unsigned engine_get_rebuilds(void* tree);
+static const void* get_left(const void* node, const void* context);
+static const void* get_right(const void* node, const void* context);
+static int get_value(const void* node, const void* context);
+#pragma endregion
+
+const BSTEngine bst_buffered_engine = {
+    "buffered",
+    engine_create,
+    engine_destroy,
+    engine_insert,
+    engine_remove,
+    engine_contains,
+    engine_get_root,
+    { get_left, get_right, get_value, NULL },
+    engine_build,
+    NULL,
+    engine_insert_values,
+    engine_remove_values,
+    engine_import_shape,
+    0,
+    engine_get_rebuilds,
+};
+
+/**
+ * @brief Initialize an empty buffered tree.
+ * @param capacity Number of changes to collect before applying them, at least 1.
+ * @return 1 if succeeded, 0 if out of memory.
+ */
+int avl_buffered_init(AVLBufferedTree* buffered, int capacity) {
+    avl_tree_init(&buffered->tree);
+    buffered->len = 0;
+    buffered->capacity = capacity > 0 ? capacity : 1;
+    buffered->entries = (AVLBufferEntry*)malloc(sizeof(AVLBufferEntry) * buffered->capacity);
+    return buffered->entries != NULL;
+}
+
+/**
+ * @brief Delete the tree and pending changes, the tree must be initialized again to be used.
+ */
+void avl_buffered_free(AVLBufferedTree* buffered) {
+    avl_tree_clear(&buffered->tree);
+    free(buffered->entries);
+    buffered->entries = NULL;
+    buffered->len = 0;
+}
+
+/**
+ * @brief Insert a value once the buffer is applied, a pending change of the same value is replaced.
+ */
+void avl_buffered_insert(AVLBufferedTree* buffered, int value) {
+    record(buffered, value, 1);
+}
+
+/**
+ * @brief Remove a value once the buffer is applied, a pending change of the same value is replaced.
+ */
+void avl_buffered_remove(AVLBufferedTree* buffered, int value) {
+    record(buffered, value, 0);
+}
+
+/**
+ * @return 1 if the value is in the tree including pending changes, otherwise 0.
+ */
+int avl_buffered_contains(AVLBufferedTree* buffered, int value) {
+    int index = find_entry(buffered, value);
+    if (index < buffered->len && buffered->entries[index].value == value) {
+        return buffered->entries[index].insert;
+    }
+    BSTStats* stats = buffered->tree.stats;
+    for (AVLNode* node = buffered->tree.root; node; node = value < node->value ? node->left : node->right) {
+        if (stats) {
+            ++stats->comparisons;
+        }
+        if (value == node->value) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Apply pending changes to the tree.
+ *
+ * The buffer is sorted already, so removals and insertions each go to the tree as one batch.
+ */
+void avl_buffered_flush(AVLBufferedTree* buffered) {
+    if (buffered->len == 0) {
+        return;
+    }
+    int* values = (int*)malloc(sizeof(int) * buffered->len);
+    if (!values) {
+        // Apply the changes one by one.
+        for (int i = 0; i < buffered->len; ++i) {
+            AVLBufferEntry* entry = &buffered->entries[i];
+            if (entry->insert) {
+                avl_tree_insert_node(&buffered->tree, entry->value);
+            } else {
+                avl_tree_remove_node(&buffered->tree, entry->value);
+            }
+        }
+        buffered->len = 0;
+        return;
+    }
+
+    // Each value has one change, so removals and insertions can be applied in any order.
+    int count = 0;
+    for (int i = 0; i < buffered->len; ++i) {
+        if (!buffered->entries[i].insert) {
+            values[count++] = buffered->entries[i].value;
+        }
+    }
+    avl_tree_remove_nodes(&buffered->tree, values, count);
+
+    count = 0;
+    for (int i = 0; i < buffered->len; ++i) {
+        if (buffered->entries[i].insert) {
+            values[count++] = buffered->entries[i].value;
+        }
+    }
+    avl_tree_insert_nodes(&buffered->tree, values, count);
+
+    free(values);
+    buffered->len = 0;
+}
+
+/**
+ * @brief Apply pending changes and return the tree's root, e.g. to print or walk the tree.
+ */
+AVLNode* avl_buffered_get_root(AVLBufferedTree* buffered) {
+    avl_buffered_flush(buffered);
+    return buffered->tree.root;
+}
+
+/**
+ * @brief Add a change to the buffer in value order, applying the buffer first if it is full.
+ */
+void record(AVLBufferedTree* buffered, int value, int insert) {
+    int index = find_entry(buffered, value);
+    if (index < buffered->len && buffered->entries[index].value == value) {
+        buffered->entries[index].insert = insert;
+        return;
+    }
+    if (buffered->len == buffered->capacity) {
+        avl_buffered_flush(buffered);
+        index = 0;
+    }
+    memmove(buffered->entries + index + 1, buffered->entries + index, sizeof(AVLBufferEntry) * (buffered->len - index));
+    buffered->entries[index].value = value;
+    buffered->entries[index].insert = insert;
+    ++buffered->len;
+}
+
+/**
+ * @return Index of the first entry whose value is not less than [value].
+ */
+int find_entry(AVLBufferedTree* buffered, int value) {
+    // Nearly sorted streams append at the end, which is checked first.
+    BSTStats* stats = buffered->tree.stats;
+    int len = buffered->len;
+    if (len == 0) {
+        return 0;
+    }
+    if (stats) {
+        ++stats->comparisons;
+    }
+    if (buffered->entries[len - 1].value < value) {
+        return len;
+    }
+    int low = 0;
+    int high = len - 1;
+    while (low < high) {
+        if (stats) {
+            ++stats->comparisons;
+        }
+        int mid = low + (high - low) / 2;
+        if (buffered->entries[mid].value < value) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief Drop pending changes, when the tree's content is replaced anyway.
+ */
+void discard(AVLBufferedTree* buffered) {
+    buffered->len = 0;
+}
+
+#pragma region Engine
+
+void* engine_create(BSTStats* stats) {
+    AVLBufferedTree* buffered = (AVLBufferedTree*)malloc(sizeof(AVLBufferedTree));
+    if (buffered && !avl_buffered_init(buffered, AVL_BUFFER_CAPACITY)) {
+        free(buffered);
+        return NULL;
+    }
+    if (buffered) {
+        buffered->tree.stats = stats;
+    }
+    return buffered;
+}
+
+void engine_destroy(void* tree) {
+    avl_buffered_free((AVLBufferedTree*)tree);
+    free(tree);
+}
+
+int engine_insert(void* tree, int value) {
+    // Single changes report whether they change the content, which takes a lookup.
+    if (avl_buffered_contains((AVLBufferedTree*)tree, value)) {
+        return 0;
+    }
+    avl_buffered_insert((AVLBufferedTree*)tree, value);
+    return 1;
+}
+
+int engine_remove(void* tree, int value) {
+    if (!avl_buffered_contains((AVLBufferedTree*)tree, value)) {
+        return 0;
+    }
+    avl_buffered_remove((AVLBufferedTree*)tree, value);
+    return 1;
+}
+
+int engine_contains(void* tree, int value) {
+    return avl_buffered_contains((AVLBufferedTree*)tree, value);
+}
+
+const void* engine_get_root(void* tree) {
+    return avl_buffered_get_root((AVLBufferedTree*)tree);
+}
+
+int engine_build(void* tree, const int* values, int len) {
+    if (!avl_tree_build(&((AVLBufferedTree*)tree)->tree, values, len)) {
+        return 0;
+    }
+    discard((AVLBufferedTree*)tree);
+    return 1;
+}
+
+void engine_insert_values(void* tree, const int* values, int len) {
+    for (int i = 0; i < len; ++i) {
+        avl_buffered_insert((AVLBufferedTree*)tree, values[i]);
+    }
+}
+
+int engine_remove_values(void* tree, const int* values, int len) {
+    avl_buffered_flush((AVLBufferedTree*)tree);
+    return avl_tree_remove_nodes(&((AVLBufferedTree*)tree)->tree, values, len);
+}
+
+int engine_import_shape(void* tree, const void* root, const BTNodeAccessor* accessor, int len) {
+    discard((AVLBufferedTree*)tree);
+    return avl_tree_import_shape(&((AVLBufferedTree*)tree)->tree, root, accessor, len);
+}
+
+unsigned engine_get_rebuilds(void* tree) {
+    return ((AVLBufferedTree*)tree)->tree.rebuilds;
+}
+
+const void* get_left(const void* node, const void* context) {
+    return ((const AVLNode*)node)->left;
+}
+
+const void* get_right(const void* node, const void* context) {
+    return ((const AVLNode*)node)->right;
+}
+
+int get_value(const void* node, const void* context) {
+    return ((const AVLNode*)node)->value;
+}
+
+#pragma endregion
@@ -0,0 +1,418 @@
+#include "avl_compact.h"
+
+#include <stdlib.h>
+
+#define INDEX_MASK 0x3FFFFFFFu
+#define BALANCE_SHIFT 30
+#define MIN_CAPACITY 64
+
+// AVL trees with 30-bit node indices are at most 44 levels deep.
+#define MAX_DEPTH 48
+
+#pragma region Function Declarations
+static uint32_t create_node(AVLCompactTree* tree, int value);
+static void release_node(AVLCompactTree* tree, uint32_t index);
+static uint32_t rotate_left(AVLCompactNode* nodes, uint32_t root);
+static uint32_t rotate_right(AVLCompactNode* nodes, uint32_t root);
+static uint32_t rebalance(AVLCompactNode* nodes, uint32_t root, int balance, int* lowered);
+static void relink(AVLCompactTree* tree, const uint32_t* path, const unsigned char* directions, int depth, uint32_t child);
+
+static const void* get_accessor_left(const void* node, const void* context);
+static const void* get_accessor_right(const void* node, const void* context);
+static int get_accessor_value(const void* node, const void* context);
+
+static inline uint32_t get_left(const AVLCompactNode* node) {
+    return node->left & INDEX_MASK;
+}
+
+// Replace the left child, keeping the balance factor packed with it.
+static inline void set_left(AVLCompactNode* node, uint32_t index) {
+    node->left = (node->left & ~INDEX_MASK) | index;
+}
+
+static inline int get_balance(const AVLCompactNode* node) {
+    return (int)(node->left >> BALANCE_SHIFT) - 1;
+}
+
+static inline void set_balance(AVLCompactNode* node, int balance) {
+    node->left = get_left(node) | ((uint32_t)(balance + 1) << BALANCE_SHIFT);
+}
+
+// Return the left child if [right] is zero, otherwise the right child.
+static inline uint32_t get_child(const AVLCompactNode* node, int right) {
+    return right ? node->right : get_left(node);
+}
+
+static inline void set_child(AVLCompactNode* node, int right, uint32_t index) {
+    if (right) {
+        node->right = index;
+    } else {
+        set_left(node, index);
+    }
+}
+
+#pragma endregion
+
+/**
+ * @brief Initialize an empty tree, the node array is allocated on the first insertion.
+ */
+void avl_compact_init(AVLCompactTree* tree) {
+    tree->nodes = NULL;
+    tree->root = AVL_COMPACT_NULL;
+    tree->used = 1; // Slot 0 is reserved for AVL_COMPACT_NULL.
+    tree->capacity = 0;
+    tree->freeList = AVL_COMPACT_NULL;
+    tree->size = 0;
+}
+
+/**
+ * @brief Delete the node array at once, the tree is empty and reusable afterwards.
+ */
+void avl_compact_free_tree(AVLCompactTree* tree) {
+    free(tree->nodes);
+    avl_compact_init(tree);
+}
+
+/**
+ * @brief Take a slot for a new node without children, growing the array if needed.
+ * @return Index of the node, or AVL_COMPACT_NULL if the array cannot grow.
+ */
+uint32_t create_node(AVLCompactTree* tree, int value) {
+    uint32_t index = tree->freeList;
+    if (index != AVL_COMPACT_NULL) {
+        tree->freeList = tree->nodes[index].right;
+    } else {
+        if (tree->used >= tree->capacity) {
+            uint32_t capacity = tree->capacity ? tree->capacity * 2 : MIN_CAPACITY;
+            if (capacity > INDEX_MASK + 1) {
+                capacity = INDEX_MASK + 1;
+            }
+            if (capacity <= tree->used) {
+                return AVL_COMPACT_NULL;
+            }
+            AVLCompactNode* nodes = (AVLCompactNode*)realloc(tree->nodes, (size_t)capacity * sizeof(AVLCompactNode));
+            if (!nodes) {
+                return AVL_COMPACT_NULL;
+            }
+            tree->nodes = nodes;
+            tree->capacity = capacity;
+        }
+        index = tree->used++;
+    }
+
+    AVLCompactNode* node = tree->nodes + index;
+    node->value = value;
+    node->left = AVL_COMPACT_NULL;
+    node->right = AVL_COMPACT_NULL;
+    set_balance(node, 0);
+    return index;
+}
+
+/**
+ * @brief Keep a removed node's slot for later insertions.
+ */
+void release_node(AVLCompactTree* tree, uint32_t index) {
+    tree->nodes[index].right = tree->freeList;
+    tree->freeList = index;
+}
+
+/**
+ * @brief Insert a value to the tree.
+ *
+ * Balance factors are adjusted bottom-up along the descent path, which stops at the first
+ * node whose height does not change. At most one single or double rotation is needed.
+ * @return 1 if the value is inserted, 0 if it already exists.
+ */
+int avl_compact_insert_node(AVLCompactTree* tree, int value) {
+    uint32_t path[MAX_DEPTH];
+    unsigned char directions[MAX_DEPTH];
+    int depth = 0;
+
+    uint32_t current = tree->root;
+    while (current != AVL_COMPACT_NULL) {
+        const AVLCompactNode* node = tree->nodes + current;
+        if (value == node->value) {
+            return 0;
+        }
+        path[depth] = current;
+        directions[depth] = value > node->value;
+        current = get_child(node, directions[depth++]);
+    }
+
+    uint32_t index = create_node(tree, value);
+    if (index == AVL_COMPACT_NULL) {
+        return 0;
+    }
+    relink(tree, path, directions, depth, index);
+    ++tree->size;
+
+    AVLCompactNode* nodes = tree->nodes;
+    for (int i = depth - 1; i >= 0; --i) {
+        AVLCompactNode* node = nodes + path[i];
+        int balance = get_balance(node) + (directions[i] ? 1 : -1);
+        if (balance == 0) {
+            // The shorter side caught up, the subtree height is unchanged.
+            set_balance(node, 0);
+            break;
+        }
+        if (balance == 1 || balance == -1) {
+            // The subtree got higher, continue with the parent.
+            set_balance(node, balance);
+            continue;
+        }
+        int lowered = 0;
+        relink(tree, path, directions, i, rebalance(nodes, path[i], balance, &lowered));
+        break; // A rotation after insertion restores the previous height.
+    }
+    return 1;
+}
+
+/**
+ * @brief Insert multiple values to the tree, in the given order.
+ */
+void avl_compact_insert_nodes(AVLCompactTree* tree, const int* values, const int len) {
+    for (int i = 0; i < len; ++i) {
+        avl_compact_insert_node(tree, values[i]);
+    }
+}
+
+/**
+ * @brief Remove a value from the tree.
+ *
+ * A node with two children takes over the maximum value of its left subtree, whose node is
+ * removed instead. Rebalancing goes up until a subtree keeps its height.
+ * @return 1 if the value is removed, 0 if it is not found.
+ */
+int avl_compact_remove_node(AVLCompactTree* tree, int value) {
+    uint32_t path[MAX_DEPTH];
+    unsigned char directions[MAX_DEPTH];
+    int depth = 0;
+    AVLCompactNode* nodes = tree->nodes;
+
+    uint32_t current = tree->root;
+    while (current != AVL_COMPACT_NULL && nodes[current].value != value) {
+        path[depth] = current;
+        directions[depth] = value > nodes[current].value;
+        current = get_child(nodes + current, directions[depth++]);
+    }
+    if (current == AVL_COMPACT_NULL) {
+        return 0;
+    }
+
+    uint32_t target = current;
+    if (get_left(nodes + current) != AVL_COMPACT_NULL && nodes[current].right != AVL_COMPACT_NULL) {
+        path[depth] = current;
+        directions[depth++] = 0;
+        target = get_left(nodes + current);
+        while (nodes[target].right != AVL_COMPACT_NULL) {
+            path[depth] = target;
+            directions[depth++] = 1;
+            target = nodes[target].right;
+        }
+        nodes[current].value = nodes[target].value;
+    }
+
+    // The removed node has at most one child, which takes its place.
+    uint32_t child = get_left(nodes + target);
+    relink(tree, path, directions, depth, child != AVL_COMPACT_NULL ? child : nodes[target].right);
+    release_node(tree, target);
+    --tree->size;
+
+    for (int i = depth - 1; i >= 0; --i) {
+        AVLCompactNode* node = nodes + path[i];
+        int balance = get_balance(node) - (directions[i] ? 1 : -1);
+        if (balance == 1 || balance == -1) {
+            // The subtree was balanced, its height is unchanged.
+            set_balance(node, balance);
+            break;
+        }
+        if (balance == 0) {
+            // The higher side got lower, so did the subtree.
+            set_balance(node, 0);
+            continue;
+        }
+        int lowered = 0;
+        relink(tree, path, directions, i, rebalance(nodes, path[i], balance, &lowered));
+        if (!lowered) {
+            break;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Restore balance of a subtree whose root got a balance factor of -2 or 2.
+ * @param nodes Node array.
+ * @param root Index of the subtree's root.
+ * @param balance The root's new balance factor, which cannot be stored in the node.
+ * @param lowered Set to 1 if the subtree is one level lower than before the rotation.
+ * @return Index of the new root of the subtree.
+ */
+uint32_t rebalance(AVLCompactNode* nodes, uint32_t root, int balance, int* lowered) {
+    *lowered = 1;
+    if (balance > 0) {
+        uint32_t child = nodes[root].right;
+        int childBalance = get_balance(nodes + child);
+        if (childBalance >= 0) {
+            rotate_left(nodes, root);
+            // A balanced child only happens on removal, then the height does not change.
+            set_balance(nodes + root, childBalance == 0 ? 1 : 0);
+            set_balance(nodes + child, childBalance == 0 ? -1 : 0);
+            *lowered = childBalance != 0;
+            return child;
+        }
+        uint32_t grandChild = get_left(nodes + child);
+        int grandChildBalance = get_balance(nodes + grandChild);
+        nodes[root].right = rotate_right(nodes, child);
+        rotate_left(nodes, root);
+        set_balance(nodes + root, grandChildBalance > 0 ? -1 : 0);
+        set_balance(nodes + child, grandChildBalance < 0 ? 1 : 0);
+        set_balance(nodes + grandChild, 0);
+        return grandChild;
+    }
+
+    // Similar implementation on the other side.
+    uint32_t child = get_left(nodes + root);
+    int childBalance = get_balance(nodes + child);
+    if (childBalance <= 0) {
+        rotate_right(nodes, root);
+        set_balance(nodes + root, childBalance == 0 ? -1 : 0);
+        set_balance(nodes + child, childBalance == 0 ? 1 : 0);
+        *lowered = childBalance != 0;
+        return child;
+    }
+    uint32_t grandChild = nodes[child].right;
+    int grandChildBalance = get_balance(nodes + grandChild);
+    set_left(nodes + root, rotate_left(nodes, child));
+    rotate_right(nodes, root);
+    set_balance(nodes + root, grandChildBalance < 0 ? 1 : 0);
+    set_balance(nodes + child, grandChildBalance > 0 ? -1 : 0);
+    set_balance(nodes + grandChild, 0);
+    return grandChild;
+}
+
+/**
+ * @brief Left rotation, the right child becomes the subtree's root. Balance factors are left to the caller.
+ * @return Index of the new root.
+ */
+uint32_t rotate_left(AVLCompactNode* nodes, uint32_t root) {
+    uint32_t child = nodes[root].right;
+    nodes[root].right = get_left(nodes + child);
+    set_left(nodes + child, root);
+    return child;
+}
+
+/**
+ * @brief Similar to left rotation.
+ * @ref rotate_left
+ */
+uint32_t rotate_right(AVLCompactNode* nodes, uint32_t root) {
+    uint32_t child = get_left(nodes + root);
+    set_left(nodes + root, nodes[child].right);
+    nodes[child].right = root;
+    return child;
+}
+
+/**
+ * @brief Attach [child] where the path goes from its node at [depth] - 1, or as the root if [depth] is zero.
+ */
+void relink(AVLCompactTree* tree, const uint32_t* path, const unsigned char* directions, int depth, uint32_t child) {
+    if (depth == 0) {
+        tree->root = child;
+    } else {
+        set_child(tree->nodes + path[depth - 1], directions[depth - 1], child);
+    }
+}
+
+/**
+ * @brief Find the node holding a value.
+ * @return The node, or null if the value is not in the tree. Invalidated by the next insertion.
+ */
+AVLCompactNode* avl_compact_find_node(AVLCompactTree* tree, int value) {
+    AVLCompactNode* node = avl_compact_lower_bound(tree, value);
+    return node && node->value == value ? node : NULL;
+}
+
+/**
+ * @return 1 if the value is in the tree, otherwise 0.
+ */
+int avl_compact_contains(AVLCompactTree* tree, int value) {
+    return avl_compact_find_node(tree, value) != NULL;
+}
+
+/**
+ * @brief Find the node holding the smallest value which is not less than [value].
+ * @return The node, or null if all values are less than [value].
+ */
+AVLCompactNode* avl_compact_lower_bound(AVLCompactTree* tree, int value) {
+    uint32_t candidate = AVL_COMPACT_NULL;
+    uint32_t current = tree->root;
+    while (current != AVL_COMPACT_NULL) {
+        const AVLCompactNode* node = tree->nodes + current;
+        int goLeft = value <= node->value;
+        candidate = goLeft ? current : candidate;
+        current = goLeft ? get_left(node) : node->right;
+    }
+    return candidate != AVL_COMPACT_NULL ? tree->nodes + candidate : NULL;
+}
+
+/**
+ * @brief Find the node holding the smallest value which is greater than [value].
+ * @return The node, or null if no value is greater than [value].
+ */
+AVLCompactNode* avl_compact_upper_bound(AVLCompactTree* tree, int value) {
+    uint32_t candidate = AVL_COMPACT_NULL;
+    uint32_t current = tree->root;
+    while (current != AVL_COMPACT_NULL) {
+        const AVLCompactNode* node = tree->nodes + current;
+        int goLeft = value < node->value;
+        candidate = goLeft ? current : candidate;
+        current = goLeft ? get_left(node) : node->right;
+    }
+    return candidate != AVL_COMPACT_NULL ? tree->nodes + candidate : NULL;
+}
+
+/**
+ * @return The root node, or null if the tree is empty.
+ */
+AVLCompactNode* avl_compact_get_root(AVLCompactTree* tree) {
+    return tree->root != AVL_COMPACT_NULL ? tree->nodes + tree->root : NULL;
+}
+
+/**
+ * @brief Compute the tree's height by following the higher child from the root, in O(log n).
+ */
+int avl_compact_get_height(AVLCompactTree* tree) {
+    int height = 0;
+    uint32_t current = tree->root;
+    while (current != AVL_COMPACT_NULL) {
+        const AVLCompactNode* node = tree->nodes + current;
+        current = get_balance(node) < 0 ? get_left(node) : node->right;
+        ++height;
+    }
+    return height;
+}
+
+/**
+ * @brief Callbacks letting the BTBox renderer read the tree's nodes directly.
+ *
+ * Pass avl_compact_get_root(tree) as the root node. Valid until the next insertion.
+ */
+BTNodeAccessor avl_compact_accessor(AVLCompactTree* tree) {
+    BTNodeAccessor accessor = { get_accessor_left, get_accessor_right, get_accessor_value, tree };
+    return accessor;
+}
+
+const void* get_accessor_left(const void* node, const void* context) {
+    uint32_t index = get_left((const AVLCompactNode*)node);
+    return index != AVL_COMPACT_NULL ? ((const AVLCompactTree*)context)->nodes + index : NULL;
+}
+
+const void* get_accessor_right(const void* node, const void* context) {
+    uint32_t index = ((const AVLCompactNode*)node)->right;
+    return index != AVL_COMPACT_NULL ? ((const AVLCompactTree*)context)->nodes + index : NULL;
+}
+
+int get_accessor_value(const void* node, const void* context) {
+    return ((const AVLCompactNode*)node)->value;
+}
@@ -0,0 +1,411 @@
+#include "avl_concurrent.h"
+
+#include <string.h>
+
+// AVL trees with less than 2^44 nodes are never deeper, counting the holder.
+#define MAX_DEPTH 64
+
+// Number of retired nodes collected before trying to reclaim them.
+#define RECLAIM_THRESHOLD 128
+
+#pragma region Function Declarations
+static AVLConcurrentNode* create_node(AVLConcurrentTree* tree, int value);
+static void retire_node(AVLConcurrentTree* tree, AVLConcurrentNode* node);
+static void reclaim_nodes(AVLConcurrentTree* tree);
+static void rebalance_path(AVLConcurrentNode** path, const unsigned char* directions, int depth);
+static AVLConcurrentNode* balance(AVLConcurrentNode* parent, int direction, AVLConcurrentNode* root);
+static AVLConcurrentNode* rotate_left(AVLConcurrentNode* parent, int direction, AVLConcurrentNode* root);
+static AVLConcurrentNode* rotate_right(AVLConcurrentNode* parent, int direction, AVLConcurrentNode* root);
+static void update_height(AVLConcurrentNode* node);
+static void enter_epoch(AVLConcurrentTree* tree, int reader);
+static void exit_epoch(AVLConcurrentTree* tree, int reader);
+static int find(AVLConcurrentTree* tree, int value, int* result);
+
+static inline AVLConcurrentNode* get_child(AVLConcurrentNode* node, int right) {
+    return (AVLConcurrentNode*)__atomic_load_n(right ? &node->node.right : &node->node.left, __ATOMIC_SEQ_CST);
+}
+
+// Publish a child link, the child's fields are visible to readers before the link is.
+static inline void set_child(AVLConcurrentNode* node, int right, AVLConcurrentNode* child) {
+    __atomic_store_n(right ? &node->node.right : &node->node.left, (AVLNode*)child, __ATOMIC_SEQ_CST);
+}
+
+static inline int get_value(AVLConcurrentNode* node) {
+    return __atomic_load_n(&node->node.value, __ATOMIC_SEQ_CST);
+}
+
+static inline unsigned int get_version(AVLConcurrentNode* node) {
+    return __atomic_load_n(&node->version, __ATOMIC_SEQ_CST);
+}
+
+// Make readers passing through the node wait and start over, until end_change.
+static inline void begin_change(AVLConcurrentNode* node) {
+    __atomic_store_n(&node->version, node->version + 1, __ATOMIC_SEQ_CST);
+}
+
+static inline void end_change(AVLConcurrentNode* node) {
+    __atomic_store_n(&node->version, node->version + 1, __ATOMIC_SEQ_CST);
+}
+
+static inline int get_height(AVLConcurrentNode* node) {
+    return node ? node->node.height : 0;
+}
+#pragma endregion
+
+/**
+ * @brief Initialize an empty tree without readers.
+ */
+void avl_concurrent_init(AVLConcurrentTree* tree) {
+    memset(tree, 0, sizeof(AVLConcurrentTree));
+    pthread_mutex_init(&tree->writeLock, NULL);
+    avl_pool_init(&tree->pool, sizeof(AVLConcurrentNode));
+    tree->epoch = 1;
+}
+
+/**
+ * @brief Delete all nodes, retired or not. No thread may use the tree anymore.
+ */
+void avl_concurrent_free_tree(AVLConcurrentTree* tree) {
+    avl_pool_free(&tree->pool);
+    pthread_mutex_destroy(&tree->writeLock);
+    tree->holder.node.right = NULL;
+    tree->retired = NULL;
+    tree->retiredCount = 0;
+    tree->size = 0;
+}
+
+/**
+ * @brief Register a reader thread, each thread doing lookups needs its own id.
+ * @return Reader id to pass to lookups, or -1 if all AVL_CONCURRENT_MAX_READERS slots are taken.
+ */
+int avl_concurrent_add_reader(AVLConcurrentTree* tree) {
+    int reader = __atomic_fetch_add(&tree->readerCount, 1, __ATOMIC_SEQ_CST);
+    return reader < AVL_CONCURRENT_MAX_READERS ? reader : -1;
+}
+
+/**
+ * @brief Check whether a value is in the tree, without blocking writers.
+ * @param reader Id of the calling thread, from avl_concurrent_add_reader.
+ * @return 1 if the value is in the tree, otherwise 0.
+ */
+int avl_concurrent_contains(AVLConcurrentTree* tree, int reader, int value) {
+    enter_epoch(tree, reader);
+    int result;
+    int found = find(tree, value, &result) && result == value;
+    exit_epoch(tree, reader);
+    return found;
+}
+
+/**
+ * @brief Find the smallest value which is not less than [value], without blocking writers.
+ * @param reader Id of the calling thread, from avl_concurrent_add_reader.
+ * @param result Receives the value found.
+ * @return 1 if a value is found, 0 if all values are less than [value].
+ */
+int avl_concurrent_lower_bound(AVLConcurrentTree* tree, int reader, int value, int* result) {
+    enter_epoch(tree, reader);
+    int found = find(tree, value, result);
+    exit_epoch(tree, reader);
+    return found;
+}
+
+/**
+ * @brief Lower bound search validating each step from a node to its child.
+ *
+ * A step is taken with the node's version read before its value and link, then the child's
+ * version is read and the link and the node's version are checked again. If both are intact,
+ * the child was in place when its version was read and the search may go on from there.
+ * Any failed check starts the search over from the root.
+ */
+int find(AVLConcurrentTree* tree, int value, int* result) {
+retry:;
+    AVLConcurrentNode* parent = &tree->holder;
+    unsigned int parentVersion = get_version(parent);
+    int direction = 1;
+    int found = 0;
+    while (1) {
+        AVLConcurrentNode* node = get_child(parent, direction);
+        if (!node) {
+            if (get_version(parent) != parentVersion) {
+                goto retry;
+            }
+            return found;
+        }
+        unsigned int version = get_version(node);
+        if ((version & 1) || get_child(parent, direction) != node || get_version(parent) != parentVersion) {
+            goto retry;
+        }
+
+        int nodeValue = get_value(node);
+        if (nodeValue >= value) {
+            *result = nodeValue;
+            found = 1;
+            if (nodeValue == value) {
+                if (get_version(node) != version) {
+                    goto retry;
+                }
+                return 1;
+            }
+        }
+        direction = nodeValue < value;
+        parent = node;
+        parentVersion = version;
+    }
+}
+
+/**
+ * @brief Start a lookup by announcing the current epoch.
+ *
+ * The epoch is read again after being announced, so a reclamation either sees the
+ * announcement or has already advanced the epoch, which makes the lookup start over with it.
+ */
+void enter_epoch(AVLConcurrentTree* tree, int reader) {
+    unsigned long long epoch;
+    do {
+        epoch = __atomic_load_n(&tree->epoch, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&tree->readers[reader].epoch, epoch, __ATOMIC_SEQ_CST);
+    } while (__atomic_load_n(&tree->epoch, __ATOMIC_SEQ_CST) != epoch);
+}
+
+void exit_epoch(AVLConcurrentTree* tree, int reader) {
+    __atomic_store_n(&tree->readers[reader].epoch, 0, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Insert a value to the tree, waiting for other writers.
+ * @return 1 if the value is inserted, 0 if it already exists, -1 if out of memory.
+ */
+int avl_concurrent_insert_node(AVLConcurrentTree* tree, int value) {
+    AVLConcurrentNode* path[MAX_DEPTH];
+    unsigned char directions[MAX_DEPTH];
+    int depth = 0;
+
+    pthread_mutex_lock(&tree->writeLock);
+    AVLConcurrentNode* node = &tree->holder;
+    int direction = 1;
+    while (node) {
+        if (depth > 0 && value == node->node.value) {
+            pthread_mutex_unlock(&tree->writeLock);
+            return 0;
+        }
+        path[depth] = node;
+        directions[depth++] = direction;
+        node = (AVLConcurrentNode*)(direction ? node->node.right : node->node.left);
+        direction = node && value > node->node.value;
+    }
+
+    AVLConcurrentNode* created = create_node(tree, value);
+    if (!created) {
+        pthread_mutex_unlock(&tree->writeLock);
+        return -1;
+    }
+    // Growing a subtree moves no value out of it, so no version changes.
+    set_child(path[depth - 1], directions[depth - 1], created);
+    ++tree->size;
+    rebalance_path(path, directions, depth);
+    pthread_mutex_unlock(&tree->writeLock);
+    return 1;
+}
+
+/**
+ * @brief Remove a value from the tree, waiting for other writers.
+ *
+ * Like avl_remove_node, a node with a left child takes over the maximum value of its left
+ * subtree. That value leaves the subtrees of the nodes in between, so they are marked as
+ * changing until the maximum's node is unlinked.
+ * @return 1 if the value is removed, 0 if it is not found.
+ */
+int avl_concurrent_remove_node(AVLConcurrentTree* tree, int value) {
+    AVLConcurrentNode* path[MAX_DEPTH];
+    unsigned char directions[MAX_DEPTH];
+    int depth = 0;
+
+    pthread_mutex_lock(&tree->writeLock);
+    AVLConcurrentNode* node = &tree->holder;
+    int direction = 1;
+    while (node && (depth == 0 || node->node.value != value)) {
+        path[depth] = node;
+        directions[depth++] = direction;
+        node = (AVLConcurrentNode*)(direction ? node->node.right : node->node.left);
+        direction = node && value > node->node.value;
+    }
+    if (!node) {
+        pthread_mutex_unlock(&tree->writeLock);
+        return 0;
+    }
+
+    AVLConcurrentNode* left = (AVLConcurrentNode*)node->node.left;
+    if (!left) {
+        set_child(path[depth - 1], directions[depth - 1], (AVLConcurrentNode*)node->node.right);
+        retire_node(tree, node);
+    } else {
+        int first = depth;
+        path[depth] = node;
+        directions[depth++] = 0;
+        AVLConcurrentNode* max = left;
+        while (max->node.right) {
+            path[depth] = max;
+            directions[depth++] = 1;
+            max = (AVLConcurrentNode*)max->node.right;
+        }
+        for (int i = first; i < depth; ++i) {
+            begin_change(path[i]);
+        }
+        __atomic_store_n(&node->node.value, max->node.value, __ATOMIC_SEQ_CST);
+        set_child(path[depth - 1], directions[depth - 1], (AVLConcurrentNode*)max->node.left);
+        for (int i = first; i < depth; ++i) {
+            end_change(path[i]);
+        }
+        retire_node(tree, max);
+    }
+    --tree->size;
+    rebalance_path(path, directions, depth);
+
+    if (tree->retiredCount >= RECLAIM_THRESHOLD) {
+        reclaim_nodes(tree);
+    }
+    pthread_mutex_unlock(&tree->writeLock);
+    return 1;
+}
+
+/**
+ * @brief Allocate a leaf node from the pool.
+ * @return The node, or null if out of memory.
+ */
+AVLConcurrentNode* create_node(AVLConcurrentTree* tree, int value) {
+    AVLConcurrentNode* node = (AVLConcurrentNode*)avl_pool_alloc(&tree->pool);
+    if (!node) {
+        return NULL;
+    }
+    node->node.value = value;
+    node->node.height = 1;
+    node->node.left = NULL;
+    node->node.right = NULL;
+    node->version = 0;
+    node->retireEpoch = 0;
+    node->nextRetired = NULL;
+    return node;
+}
+
+/**
+ * @brief Keep an unlinked node until no lookup can reach it anymore.
+ */
+void retire_node(AVLConcurrentTree* tree, AVLConcurrentNode* node) {
+    node->retireEpoch = __atomic_load_n(&tree->epoch, __ATOMIC_SEQ_CST);
+    node->nextRetired = tree->retired;
+    tree->retired = node;
+    ++tree->retiredCount;
+}
+
+/**
+ * @brief Give retired nodes back to the pool once the lookups which could see them are over.
+ *
+ * The epoch is advanced first, lookups starting from then on cannot reach any node retired
+ * so far. A node retired in an epoch older than every announced one is therefore unreachable.
+ */
+void reclaim_nodes(AVLConcurrentTree* tree) {
+    unsigned long long oldest = __atomic_add_fetch(&tree->epoch, 1, __ATOMIC_SEQ_CST);
+    int readerCount = __atomic_load_n(&tree->readerCount, __ATOMIC_SEQ_CST);
+    if (readerCount > AVL_CONCURRENT_MAX_READERS) {
+        readerCount = AVL_CONCURRENT_MAX_READERS;
+    }
+    for (int i = 0; i < readerCount; ++i) {
+        unsigned long long epoch = __atomic_load_n(&tree->readers[i].epoch, __ATOMIC_SEQ_CST);
+        if (epoch && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+
+    AVLConcurrentNode** link = &tree->retired;
+    while (*link) {
+        AVLConcurrentNode* node = *link;
+        if (node->retireEpoch < oldest) {
+            *link = node->nextRetired;
+            avl_pool_release(&tree->pool, &node->node);
+            --tree->retiredCount;
+        } else {
+            link = &node->nextRetired;
+        }
+    }
+}
+
+/**
+ * @brief Update heights and rebalance nodes on the path bottom-up, stopping once a subtree keeps its height.
+ * @param path Nodes from the holder down, each one entered from the previous one through [directions].
+ */
+void rebalance_path(AVLConcurrentNode** path, const unsigned char* directions, int depth) {
+    for (int i = depth - 1; i > 0; --i) {
+        AVLConcurrentNode* node = path[i];
+        int oldHeight = node->node.height;
+        update_height(node);
+        AVLConcurrentNode* root = balance(path[i - 1], directions[i - 1], node);
+        if (root->node.height == oldHeight) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Rotate the subtree at [root] if its children's heights differ by more than one.
+ * @param parent Node linking to [root] through [direction].
+ * @return Root of the subtree afterwards.
+ */
+AVLConcurrentNode* balance(AVLConcurrentNode* parent, int direction, AVLConcurrentNode* root) {
+    AVLConcurrentNode* left = (AVLConcurrentNode*)root->node.left;
+    AVLConcurrentNode* right = (AVLConcurrentNode*)root->node.right;
+    int balanceFactor = get_height(right) - get_height(left);
+    if (balanceFactor < -1) {
+        if (get_height((AVLConcurrentNode*)left->node.right) > get_height((AVLConcurrentNode*)left->node.left)) {
+            rotate_left(root, 0, left);
+        }
+        return rotate_right(parent, direction, root);
+    }
+    if (balanceFactor > 1) {
+        if (get_height((AVLConcurrentNode*)right->node.left) > get_height((AVLConcurrentNode*)right->node.right)) {
+            rotate_right(root, 1, right);
+        }
+        return rotate_left(parent, direction, root);
+    }
+    return root;
+}
+
+/**
+ * @brief Left rotation relinking nodes, the right child takes the place of [root].
+ *
+ * [root] loses its right child and that child's right subtree, so it is marked as changing
+ * until the new root is linked to [parent]. The nodes' values do not move.
+ * @return The new root.
+ */
+AVLConcurrentNode* rotate_left(AVLConcurrentNode* parent, int direction, AVLConcurrentNode* root) {
+    AVLConcurrentNode* child = (AVLConcurrentNode*)root->node.right;
+    begin_change(root);
+    set_child(root, 1, (AVLConcurrentNode*)child->node.left);
+    set_child(child, 0, root);
+    set_child(parent, direction, child);
+    end_change(root);
+    update_height(root);
+    update_height(child);
+    return child;
+}
+
+/**
+ * @brief Similar to left rotation.
+ * @ref rotate_left
+ */
+AVLConcurrentNode* rotate_right(AVLConcurrentNode* parent, int direction, AVLConcurrentNode* root) {
+    AVLConcurrentNode* child = (AVLConcurrentNode*)root->node.left;
+    begin_change(root);
+    set_child(root, 0, (AVLConcurrentNode*)child->node.right);
+    set_child(child, 1, root);
+    set_child(parent, direction, child);
+    end_change(root);
+    update_height(root);
+    update_height(child);
+    return child;
+}
+
+void update_height(AVLConcurrentNode* node) {
+    int left = get_height((AVLConcurrentNode*)node->node.left);
+    int right = get_height((AVLConcurrentNode*)node->node.right);
+    node->node.height = 1 + (left > right ? left : right);
+}
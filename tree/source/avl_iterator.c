@@ -0,0 +1,124 @@
+#include "avl_iterator.h"
+
+#include <limits.h>
+#include <string.h>
+
+#pragma region Function Declarations
+static void seek(AVLIterator* iterator, int value, int inclusive);
+static void push(AVLIterator* iterator, AVLNode* node);
+#pragma endregion
+
+/**
+ * @brief Start a walk over all values of a tree.
+ * @param reverse Nonzero to start from the largest value and walk down.
+ */
+void avl_iterator_init(AVLIterator* iterator, AVLNode* root, int reverse) {
+    avl_iterator_range(iterator, root, INT_MIN, INT_MAX, reverse);
+}
+
+/**
+ * @brief Start a walk over values within [low, high] in O(log n), the first node is returned by the next step.
+ * @param reverse Nonzero to start from the largest value in range and walk down.
+ */
+void avl_iterator_range(AVLIterator* iterator, AVLNode* root, int low, int high, int reverse) {
+    iterator->root = root;
+    iterator->current = NULL;
+    iterator->low = low;
+    iterator->high = high;
+    iterator->reverse = reverse;
+    seek(iterator, reverse ? high : low, 1);
+}
+
+/**
+ * @brief Step to the next node of the walk.
+ * @return The node, or null once the walk is over.
+ */
+AVLNode* avl_iterator_next(AVLIterator* iterator) {
+    if (iterator->depth == 0) {
+        // Only a walk through a degenerate tree gets here before its end, resume after the last value.
+        if (!iterator->truncated || !iterator->current) {
+            return NULL;
+        }
+        seek(iterator, iterator->current->value, 0);
+        if (iterator->depth == 0) {
+            return NULL;
+        }
+    }
+
+    AVLNode* node = iterator->stack[--iterator->depth];
+    if (iterator->reverse ? node->value < iterator->low : node->value > iterator->high) {
+        iterator->depth = 0;
+        iterator->truncated = 0;
+        return NULL;
+    }
+
+    // Values between this node and the next pending ancestor are in the subtree on the walk's side.
+    AVLNode* child = iterator->reverse ? node->left : node->right;
+    while (child) {
+        push(iterator, child);
+        child = iterator->reverse ? child->right : child->left;
+    }
+    iterator->current = node;
+    return node;
+}
+
+/**
+ * @brief Fill the stack with nodes from the root down to [value], keeping those which are still to be visited.
+ * @param inclusive Nonzero to visit a node holding [value] too.
+ */
+void seek(AVLIterator* iterator, int value, int inclusive) {
+    iterator->depth = 0;
+    iterator->truncated = 0;
+    AVLNode* node = iterator->root;
+    while (node) {
+        if (inclusive && node->value == value) {
+            // Further values are in the subtree on the walk's side, which is pushed when the node is visited.
+            push(iterator, node);
+            break;
+        }
+        if (iterator->reverse ? node->value < value : node->value > value) {
+            push(iterator, node);
+            node = iterator->reverse ? node->right : node->left;
+        } else {
+            node = iterator->reverse ? node->left : node->right;
+        }
+    }
+}
+
+/**
+ * @brief Push a pending node, dropping the bottom half of the stack if it is full.
+ *
+ * Dropped ancestors are found again by a search from the root when the stack runs empty.
+ */
+void push(AVLIterator* iterator, AVLNode* node) {
+    if (iterator->depth == AVL_ITERATOR_DEPTH) {
+        int kept = AVL_ITERATOR_DEPTH / 2;
+        memmove(iterator->stack, iterator->stack + AVL_ITERATOR_DEPTH - kept, kept * sizeof(AVLNode*));
+        iterator->depth = kept;
+        iterator->truncated = 1;
+    }
+    iterator->stack[iterator->depth++] = node;
+}
+
+/**
+ * @brief Find the node holding the smallest value which is greater than [value].
+ * @return The node, or null if [value] is not less than the tree's maximum.
+ */
+AVLNode* avl_successor(AVLNode* root, int value) {
+    return avl_upper_bound(root, value);
+}
+
+/**
+ * @brief Find the node holding the largest value which is less than [value].
+ * @return The node, or null if [value] is not greater than the tree's minimum.
+ */
+AVLNode* avl_predecessor(AVLNode* root, int value) {
+    AVLNode* candidate = NULL;
+    AVLNode* node = root;
+    while (node) {
+        int goRight = node->value < value;
+        candidate = goRight ? node : candidate;
+        node = goRight ? node->right : node->left;
+    }
+    return candidate;
+}
@@ -0,0 +1,306 @@
+#include "avl_persistent.h"
+
+#include <stdlib.h>
+
+// Versions are always balanced, so they are never deeper than this.
+#define MAX_DEPTH 64
+
+#pragma region Function Declarations
+static AVLNode* create_node(int value, AVLNode* left, AVLNode* right);
+static AVLNode* own_node(AVLNode* node);
+static int own_link(AVLNode** link);
+static int rebalance_path(AVLNode*** links, int depth);
+static int balance(AVLNode* root);
+static AVLNode* discard_version(AVLNode* newRoot, AVLNode* root);
+static void rotate_left(AVLNode* root);
+static void rotate_right(AVLNode* root);
+static void update_height(AVLNode* node);
+
+static inline int* get_ref_count(AVLNode* node) {
+    return &((AVLPersistentNode*)node)->refCount;
+}
+
+static inline int get_height(AVLNode* node) {
+    return node ? node->height : 0;
+}
+#pragma endregion
+
+/**
+ * @brief Create a version with [value] inserted, in O(log n) time and memory.
+ *
+ * Nodes on the path to the new leaf are copied, every other subtree is shared with [root].
+ * @param root A version, which stays valid and unchanged. Null for the empty tree.
+ * @return The new version, to be released by the caller. It is [root] retained again
+ *         if the value already exists or memory runs out, avl_contains tells which.
+ */
+AVLNode* avl_persistent_insert_node(AVLNode* root, int value) {
+    if (avl_find_node(root, value)) {
+        return avl_persistent_retain(root);
+    }
+
+    AVLNode** links[MAX_DEPTH];
+    int depth = 0;
+    // The new version takes its own reference to the root, so that the root gets copied.
+    AVLNode* newRoot = avl_persistent_retain(root);
+    AVLNode** link = &newRoot;
+    while (*link) {
+        if (!own_link(link)) {
+            return discard_version(newRoot, root);
+        }
+        links[depth++] = link;
+        link = value < (*link)->value ? &(*link)->left : &(*link)->right;
+    }
+
+    *link = create_node(value, NULL, NULL);
+    if (!*link || !rebalance_path(links, depth)) {
+        return discard_version(newRoot, root);
+    }
+    return newRoot;
+}
+
+/**
+ * @brief Create a version with [value] removed, in O(log n) time and memory.
+ * @param root A version, which stays valid and unchanged.
+ * @return The new version, to be released by the caller. It is [root] retained again
+ *         if the value is not found or memory runs out, avl_contains tells which.
+ */
+AVLNode* avl_persistent_remove_node(AVLNode* root, int value) {
+    if (!avl_find_node(root, value)) {
+        return avl_persistent_retain(root);
+    }
+
+    AVLNode** links[MAX_DEPTH];
+    int depth = 0;
+    AVLNode* newRoot = avl_persistent_retain(root);
+    AVLNode** link = &newRoot;
+    if (!own_link(link)) {
+        return discard_version(newRoot, root);
+    }
+    while ((*link)->value != value) {
+        links[depth++] = link;
+        link = value < (*link)->value ? &(*link)->left : &(*link)->right;
+        if (!own_link(link)) {
+            return discard_version(newRoot, root);
+        }
+    }
+
+    AVLNode* node = *link;
+    AVLNode* removed;
+    if (!node->left) {
+        // The parent takes over the node's reference to its right child.
+        *link = node->right;
+        node->right = NULL;
+        removed = node;
+    } else {
+        // Same as avl_remove_node, the maximum of the left subtree replaces the value.
+        links[depth++] = link;
+        AVLNode** maxLink = &node->left;
+        if (!own_link(maxLink)) {
+            return discard_version(newRoot, root);
+        }
+        while ((*maxLink)->right) {
+            links[depth++] = maxLink;
+            maxLink = &(*maxLink)->right;
+            if (!own_link(maxLink)) {
+                return discard_version(newRoot, root);
+            }
+        }
+        removed = *maxLink;
+        node->value = removed->value;
+        *maxLink = removed->left;
+        removed->left = NULL;
+    }
+    avl_persistent_release(removed);
+
+    if (!rebalance_path(links, depth)) {
+        return discard_version(newRoot, root);
+    }
+    return newRoot;
+}
+
+/**
+ * @brief Drop a version whose building ran out of memory.
+ *
+ * Every step keeps the reference counts right, so the partly built version is released like any other.
+ * @return [root] retained again, in place of the new version.
+ */
+AVLNode* discard_version(AVLNode* newRoot, AVLNode* root) {
+    avl_persistent_release(newRoot);
+    return avl_persistent_retain(root);
+}
+
+/**
+ * @brief Take another reference to a version, e.g. to keep it as a snapshot.
+ * @return [root] itself.
+ */
+AVLNode* avl_persistent_retain(AVLNode* root) {
+    if (root) {
+        __atomic_add_fetch(get_ref_count(root), 1, __ATOMIC_RELAXED);
+    }
+    return root;
+}
+
+/**
+ * @brief Drop a reference to a version, freeing the nodes no other version shares.
+ */
+void avl_persistent_release(AVLNode* root) {
+    AVLNode* stack[MAX_DEPTH * 2];
+    int depth = 0;
+    if (root && __atomic_sub_fetch(get_ref_count(root), 1, __ATOMIC_ACQ_REL) == 0) {
+        stack[depth++] = root;
+    }
+    while (depth) {
+        AVLNode* node = stack[--depth];
+        AVLNode* children[2] = { node->left, node->right };
+        free(node);
+        for (int i = 0; i < 2; ++i) {
+            if (children[i] && __atomic_sub_fetch(get_ref_count(children[i]), 1, __ATOMIC_ACQ_REL) == 0) {
+                stack[depth++] = children[i];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Create a node owning one more reference to each of the given children.
+ * @return The node, or null if out of memory.
+ */
+AVLNode* create_node(int value, AVLNode* left, AVLNode* right) {
+    AVLPersistentNode* created = (AVLPersistentNode*)malloc(sizeof(AVLPersistentNode));
+    if (!created) {
+        return NULL;
+    }
+    created->node.value = value;
+    created->node.left = avl_persistent_retain(left);
+    created->node.right = avl_persistent_retain(right);
+    update_height(&created->node);
+    created->refCount = 1;
+    return &created->node;
+}
+
+/**
+ * @brief Get a node which may be modified by the version being built.
+ *
+ * The node is reached through a parent of the new version, which holds one of its references.
+ * If that is the only one, no other version can see the node. Otherwise the parent's
+ * reference is moved to a copy.
+ * @return The node itself or its copy, to be linked in place of the node, or null if out of
+ *         memory, then the node keeps the parent's reference.
+ */
+AVLNode* own_node(AVLNode* node) {
+    if (!node || __atomic_load_n(get_ref_count(node), __ATOMIC_ACQUIRE) == 1) {
+        return node;
+    }
+    AVLNode* copy = create_node(node->value, node->left, node->right);
+    if (copy) {
+        __atomic_sub_fetch(get_ref_count(node), 1, __ATOMIC_ACQ_REL);
+    }
+    return copy;
+}
+
+/**
+ * @brief Replace the non-null node of a link by an owned one, see own_node.
+ * @return 1 if succeeded, 0 if out of memory and the link is unchanged.
+ */
+int own_link(AVLNode** link) {
+    AVLNode* owned = own_node(*link);
+    if (!owned) {
+        return 0;
+    }
+    *link = owned;
+    return 1;
+}
+
+/**
+ * @brief Update and rebalance nodes on the path bottom-up, stopping once a subtree keeps its height.
+ * @param links Links to owned nodes from the root down.
+ * @return 1 if succeeded, 0 if out of memory, leaving a valid but possibly unbalanced version.
+ */
+int rebalance_path(AVLNode*** links, int depth) {
+    for (int i = depth - 1; i >= 0; --i) {
+        AVLNode* node = *links[i];
+        int oldHeight = node->height;
+        update_height(node);
+        if (!balance(node)) {
+            return 0;
+        }
+        if (node->height == oldHeight) {
+            break;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Rotate at an owned node if needed, after taking ownership of the nodes the rotation changes.
+ * @return 1 if succeeded, 0 if out of memory before any rotation.
+ */
+int balance(AVLNode* root) {
+    int balanceFactor = get_height(root->right) - get_height(root->left);
+    if (balanceFactor < -1) {
+        if (!own_link(&root->left)) {
+            return 0;
+        }
+        if (get_height(root->left->right) > get_height(root->left->left)) {
+            if (!own_link(&root->left->right)) {
+                return 0;
+            }
+            rotate_left(root->left);
+        }
+        rotate_right(root);
+    } else if (balanceFactor > 1) {
+        if (!own_link(&root->right)) {
+            return 0;
+        }
+        if (get_height(root->right->left) > get_height(root->right->right)) {
+            if (!own_link(&root->right->left)) {
+                return 0;
+            }
+            rotate_right(root->right);
+        }
+        rotate_left(root);
+    }
+    return 1;
+}
+
+/**
+ * @brief Left rotation keeping the root node in place like the one of avl_tree,
+ * so that versions have the same shapes as trees built by avl_* functions.
+ *
+ * Both nodes must be owned. Subtrees only move between them, their reference counts hold.
+ */
+void rotate_left(AVLNode* root) {
+    AVLNode* reservedNode = root->right;
+    int tempRootValue = root->value;
+    root->value = reservedNode->value;
+    root->right = reservedNode->right;
+    reservedNode->right = reservedNode->left;
+    reservedNode->left = root->left;
+    reservedNode->value = tempRootValue;
+    root->left = reservedNode;
+    update_height(reservedNode);
+    update_height(root);
+}
+
+/**
+ * @brief Similar to left rotation.
+ * @ref rotate_left
+ */
+void rotate_right(AVLNode* root) {
+    AVLNode* reservedNode = root->left;
+    int tempRootValue = root->value;
+    root->value = reservedNode->value;
+    root->left = reservedNode->left;
+    reservedNode->left = reservedNode->right;
+    reservedNode->right = root->right;
+    reservedNode->value = tempRootValue;
+    root->right = reservedNode;
+    update_height(reservedNode);
+    update_height(root);
+}
+
+void update_height(AVLNode* node) {
+    int left = get_height(node->left);
+    int right = get_height(node->right);
+    node->height = 1 + (left > right ? left : right);
+}
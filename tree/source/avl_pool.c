@@ -0,0 +1,123 @@
+#include "avl_pool.h"
+#include "avl_tree.h"
+
+#include <stdlib.h>
+
+// Nodes held by the first page, each following page doubles until the maximum.
+#define POOL_MIN_PAGE_NODES 64
+#define POOL_MAX_PAGE_NODES 65536
+
+typedef struct AVLPoolPage {
+    struct AVLPoolPage* next;
+    // Nodes of the page, aligned as AVLNode because every node starts with one.
+    AVLNode nodes[];
+} AVLPoolPage;
+
+/**
+ * @brief Initialize an empty pool, no memory is allocated until the first node is requested.
+ * @param nodeSize Size in bytes of each node, at least sizeof(AVLNode).
+ */
+void avl_pool_init(AVLNodePool* pool, int nodeSize) {
+    pool->pages = NULL;
+    pool->freeList = NULL;
+    pool->pageUsed = 0;
+    pool->pageCapacity = 0;
+    pool->nodeSize = nodeSize;
+}
+
+/**
+ * @brief Take a node from the pool. Fields of the returned node are not initialized.
+ * @return Pointer to the node, or null if a new page cannot be allocated.
+ */
+AVLNode* avl_pool_alloc(AVLNodePool* pool) {
+    if (pool->freeList) {
+        AVLNode* node = pool->freeList;
+        pool->freeList = node->left;
+        return node;
+    }
+
+    if (pool->pageUsed == pool->pageCapacity) {
+        int capacity = pool->pageCapacity ? pool->pageCapacity * 2 : POOL_MIN_PAGE_NODES;
+        if (capacity > POOL_MAX_PAGE_NODES) {
+            capacity = POOL_MAX_PAGE_NODES;
+        }
+        AVLPoolPage* page = (AVLPoolPage*)malloc(sizeof(AVLPoolPage) + (size_t)capacity * pool->nodeSize);
+        if (!page) {
+            return NULL;
+        }
+        page->next = pool->pages;
+        pool->pages = page;
+        pool->pageUsed = 0;
+        pool->pageCapacity = capacity;
+    }
+
+    return (AVLNode*)((char*)pool->pages->nodes + (size_t)pool->nodeSize * pool->pageUsed++);
+}
+
+/**
+ * @brief Give a node back to the pool so that it can be handed out again.
+ */
+void avl_pool_release(AVLNodePool* pool, AVLNode* node) {
+    node->left = pool->freeList;
+    pool->freeList = node;
+}
+
+/**
+ * @brief Free all pages of the pool at once, every node taken from it becomes invalid.
+ */
+void avl_pool_free(AVLNodePool* pool) {
+    AVLPoolPage* page = pool->pages;
+    while (page) {
+        AVLPoolPage* next = page->next;
+        free(page);
+        page = next;
+    }
+    avl_pool_init(pool, pool->nodeSize);
+}
+
+/**
+ * @brief Give a chain of nodes back to the pool at once.
+ * @param first First node of the chain, whose nodes are linked through their left child.
+ * @param last Last node of the chain.
+ */
+void avl_pool_release_list(AVLNodePool* pool, AVLNode* first, AVLNode* last) {
+    if (!first) {
+        return;
+    }
+    last->left = pool->freeList;
+    pool->freeList = first;
+}
+
+/**
+ * @brief Move all pages and free nodes of [other] to [pool], nodes taken from either pool stay valid.
+ *
+ * The pools must have the same node size. [other] is empty afterwards. Its newest page
+ * is not allocated from anymore, the rest of that page is given back with the pool.
+ */
+void avl_pool_merge(AVLNodePool* pool, AVLNodePool* other) {
+    if (!other->pages) {
+        return;
+    }
+    if (other->freeList) {
+        AVLNode* last = other->freeList;
+        while (last->left) {
+            last = last->left;
+        }
+        avl_pool_release_list(pool, other->freeList, last);
+    }
+
+    if (!pool->pages) {
+        pool->pages = other->pages;
+        pool->pageUsed = other->pageUsed;
+        pool->pageCapacity = other->pageCapacity;
+    } else {
+        // Keep the newest page first, allocations continue from it.
+        AVLPoolPage* last = other->pages;
+        while (last->next) {
+            last = last->next;
+        }
+        last->next = pool->pages->next;
+        pool->pages->next = other->pages;
+    }
+    avl_pool_init(other, other->nodeSize);
+}
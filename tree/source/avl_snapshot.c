@@ -0,0 +1,294 @@
+#include "avl_snapshot.h"
+
+#include <stdlib.h>
+
+// Number of lookups advanced side by side in a batch, so that their cache misses overlap.
+#define FIND_BATCH_LANES 8
+
+// Slots four levels below slot k start at 16k, which is one cache line of keys.
+#define PREFETCH_DISTANCE 16
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SNAPSHOT_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define SNAPSHOT_PREFETCH(address) ((void)(address))
+#endif
+
+#pragma region Function Declarations
+static int allocate_keys(AVLSnapshot* snapshot, int len);
+static int count_nodes(AVLNode* root);
+static int get_level(unsigned int slot);
+static int get_subtree_size(unsigned int slot, unsigned int size);
+
+// Return the slot found by a descent which ended below a leaf at [slot].
+static inline unsigned int resolve_descent(unsigned int slot) {
+    // The trailing ones are the right turns taken after the last left turn, drop them
+    // and that left turn to get back to the last node which was not less than the value.
+    return slot >> __builtin_ffs(~slot);
+}
+#pragma endregion
+
+/**
+ * @brief Copy the values of a tree into a snapshot, in O(n).
+ *
+ * The tree is walked in order while the snapshot's slots are visited in order too,
+ * so values land in their Eytzinger slots without sorting or searching.
+ * @param snapshot Uninitialized or freed snapshot.
+ * @param root Root of the tree to copy.
+ */
+void avl_snapshot_build(AVLSnapshot* snapshot, AVLNode* root) {
+    int len = count_nodes(root);
+    if (!allocate_keys(snapshot, len)) {
+        return;
+    }
+
+    AVLNode** stack = (AVLNode**)malloc(sizeof(AVLNode*) * (root ? root->height + 1 : 1));
+    int depth = 0;
+    AVLNode* node = root;
+    int slot = avl_snapshot_first(snapshot);
+    while (node || depth) {
+        while (node) {
+            stack[depth++] = node;
+            node = node->left;
+        }
+        node = stack[--depth];
+        snapshot->keys[slot] = node->value;
+        slot = avl_snapshot_next(snapshot, slot);
+        node = node->right;
+    }
+    free(stack);
+}
+
+/**
+ * @brief Copy sorted values into a snapshot, in O(n).
+ * @param snapshot Uninitialized or freed snapshot.
+ * @param values Values in ascending order, without duplicates.
+ * @param len Number of values.
+ */
+void avl_snapshot_build_sorted(AVLSnapshot* snapshot, const int* values, const int len) {
+    if (!allocate_keys(snapshot, len)) {
+        return;
+    }
+    int slot = avl_snapshot_first(snapshot);
+    for (int i = 0; i < len; ++i) {
+        snapshot->keys[slot] = values[i];
+        slot = avl_snapshot_next(snapshot, slot);
+    }
+}
+
+/**
+ * @brief Delete the snapshot's keys, the snapshot is empty afterwards.
+ */
+void avl_snapshot_free(AVLSnapshot* snapshot) {
+    free(snapshot->keys);
+    snapshot->keys = NULL;
+    snapshot->size = 0;
+}
+
+/**
+ * @return 1 if the key array is allocated, otherwise 0 and the snapshot is empty.
+ */
+int allocate_keys(AVLSnapshot* snapshot, int len) {
+    snapshot->keys = (int*)malloc(sizeof(int) * ((size_t)len + 1));
+    snapshot->size = snapshot->keys ? len : 0;
+    return snapshot->keys != NULL;
+}
+
+/**
+ * @brief Count nodes of a tree without recursion.
+ */
+int count_nodes(AVLNode* root) {
+    if (!root) {
+        return 0;
+    }
+    AVLNode** stack = (AVLNode**)malloc(sizeof(AVLNode*) * (root->height + 1));
+    int depth = 0;
+    int count = 0;
+    stack[depth++] = root;
+    while (depth) {
+        AVLNode* node = stack[--depth];
+        ++count;
+        if (node->left) {
+            stack[depth++] = node->left;
+        }
+        if (node->right) {
+            stack[depth++] = node->right;
+        }
+    }
+    free(stack);
+    return count;
+}
+
+/**
+ * @brief Find the slot holding a value.
+ * @return The slot, or AVL_SNAPSHOT_NONE if the value is not in the snapshot.
+ */
+int avl_snapshot_find(const AVLSnapshot* snapshot, int value) {
+    int slot = avl_snapshot_lower_bound(snapshot, value);
+    return slot != AVL_SNAPSHOT_NONE && snapshot->keys[slot] == value ? slot : AVL_SNAPSHOT_NONE;
+}
+
+/**
+ * @return 1 if the value is in the snapshot, otherwise 0.
+ */
+int avl_snapshot_contains(const AVLSnapshot* snapshot, int value) {
+    return avl_snapshot_find(snapshot, value) != AVL_SNAPSHOT_NONE;
+}
+
+/**
+ * @brief Find the slot holding the smallest value which is not less than [value].
+ *
+ * Each step only computes the next slot from a comparison, without branching on it, and
+ * prefetches the cache line holding the slots four levels below.
+ * @return The slot, or AVL_SNAPSHOT_NONE if all values are less than [value].
+ */
+int avl_snapshot_lower_bound(const AVLSnapshot* snapshot, int value) {
+    const int* keys = snapshot->keys;
+    unsigned int size = (unsigned int)snapshot->size;
+    unsigned int slot = 1;
+    while (slot <= size) {
+        SNAPSHOT_PREFETCH(keys + PREFETCH_DISTANCE * slot);
+        slot = 2 * slot + (keys[slot] < value);
+    }
+    return (int)resolve_descent(slot);
+}
+
+/**
+ * @brief Find the slot holding the smallest value which is greater than [value].
+ * @return The slot, or AVL_SNAPSHOT_NONE if no value is greater than [value].
+ */
+int avl_snapshot_upper_bound(const AVLSnapshot* snapshot, int value) {
+    const int* keys = snapshot->keys;
+    unsigned int size = (unsigned int)snapshot->size;
+    unsigned int slot = 1;
+    while (slot <= size) {
+        SNAPSHOT_PREFETCH(keys + PREFETCH_DISTANCE * slot);
+        slot = 2 * slot + (keys[slot] <= value);
+    }
+    return (int)resolve_descent(slot);
+}
+
+/**
+ * @brief Find slots of many values at once.
+ *
+ * All lookups of a group descend the same number of levels, so they advance in lockstep
+ * without checking which ones are done.
+ * @param snapshot The snapshot.
+ * @param values Values to look for.
+ * @param len Number of values.
+ * @param results Output array of [len] slots, AVL_SNAPSHOT_NONE for values not in the snapshot.
+ */
+void avl_snapshot_find_values(const AVLSnapshot* snapshot, const int* values, const int len, int* results) {
+    const int* keys = snapshot->keys;
+    unsigned int size = (unsigned int)snapshot->size;
+    // Every descent passes the full levels, some also pass a node on the last one.
+    int fullLevels = size ? get_level(size) : 0;
+    unsigned int slots[FIND_BATCH_LANES];
+    for (int start = 0; start < len; start += FIND_BATCH_LANES) {
+        const int* targets = values + start;
+        int lanes = len - start < FIND_BATCH_LANES ? len - start : FIND_BATCH_LANES;
+        for (int i = 0; i < lanes; ++i) {
+            slots[i] = 1;
+        }
+        for (int level = 0; level < fullLevels; ++level) {
+            for (int i = 0; i < lanes; ++i) {
+                unsigned int slot = slots[i];
+                SNAPSHOT_PREFETCH(keys + PREFETCH_DISTANCE * slot);
+                slots[i] = 2 * slot + (keys[slot] < targets[i]);
+            }
+        }
+        for (int i = 0; i < lanes; ++i) {
+            unsigned int slot = slots[i];
+            if (slot <= size) {
+                slot = 2 * slot + (keys[slot] < targets[i]);
+            }
+            slot = resolve_descent(slot);
+            results[start + i] = slot != AVL_SNAPSHOT_NONE && keys[slot] == targets[i] ? (int)slot : AVL_SNAPSHOT_NONE;
+        }
+    }
+}
+
+/**
+ * @return The slot holding the smallest value, or AVL_SNAPSHOT_NONE if the snapshot is empty.
+ */
+int avl_snapshot_first(const AVLSnapshot* snapshot) {
+    unsigned int size = (unsigned int)snapshot->size;
+    if (!size) {
+        return AVL_SNAPSHOT_NONE;
+    }
+    unsigned int slot = 1;
+    while (2 * slot <= size) {
+        slot *= 2;
+    }
+    return (int)slot;
+}
+
+/**
+ * @brief Step to the next value in ascending order, for range scans starting at a bound.
+ * @return The slot holding the next value, or AVL_SNAPSHOT_NONE after the largest one.
+ */
+int avl_snapshot_next(const AVLSnapshot* snapshot, int slot) {
+    unsigned int size = (unsigned int)snapshot->size;
+    unsigned int current = (unsigned int)slot;
+    if (2 * current + 1 <= size) {
+        // Leftmost slot of the right subtree.
+        current = 2 * current + 1;
+        while (2 * current <= size) {
+            current *= 2;
+        }
+        return (int)current;
+    }
+    // Go up past all right turns, then past the left turn.
+    return (int)resolve_descent(current);
+}
+
+/**
+ * @brief Count values in the snapshot which are less than [value], in O(log n).
+ */
+int avl_snapshot_rank(const AVLSnapshot* snapshot, int value) {
+    const int* keys = snapshot->keys;
+    unsigned int size = (unsigned int)snapshot->size;
+    unsigned int slot = 1;
+    int rank = 0;
+    while (slot <= size) {
+        int goRight = keys[slot] < value;
+        rank += goRight ? get_subtree_size(2 * slot, size) + 1 : 0;
+        slot = 2 * slot + goRight;
+    }
+    return rank;
+}
+
+/**
+ * @brief Count values in the snapshot within [low, high], in O(log n).
+ */
+int avl_snapshot_count_range(const AVLSnapshot* snapshot, int low, int high) {
+    if (low > high) {
+        return 0;
+    }
+    int upper = avl_snapshot_upper_bound(snapshot, high);
+    int end = upper != AVL_SNAPSHOT_NONE ? avl_snapshot_rank(snapshot, snapshot->keys[upper]) : snapshot->size;
+    return end - avl_snapshot_rank(snapshot, low);
+}
+
+/**
+ * @brief Depth of a slot, where the root at slot 1 is at level 0.
+ */
+int get_level(unsigned int slot) {
+    return 31 - __builtin_clz(slot);
+}
+
+/**
+ * @brief Number of slots in the subtree rooted at [slot], in O(1).
+ *
+ * All levels above the snapshot's last one are full, only the last level needs clamping.
+ */
+int get_subtree_size(unsigned int slot, unsigned int size) {
+    if (slot > size) {
+        return 0;
+    }
+    int shift = get_level(size) - get_level(slot);
+    unsigned long long first = (unsigned long long)slot << shift;
+    unsigned long long width = 1ull << shift;
+    unsigned long long last = size >= first ? size - first + 1 : 0;
+    return (int)(width - 1 + (last < width ? last : width));
+}
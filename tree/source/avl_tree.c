@@ -1,17 +1,146 @@
 #include "avl_tree.h"
 
+#include <limits.h>
+#include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
+
+// Number of lookups advanced side by side in a batch, so that their cache misses overlap.
+#define FIND_BATCH_LANES 8
+
+#if defined(__GNUC__) || defined(__clang__)
+#define AVL_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define AVL_PREFETCH(address) ((void)(address))
+#endif
+
+// Path depth kept without heap allocation. AVL trees with less than 2^44 nodes are never deeper.
+#define PATH_INLINE_DEPTH 64
+
+// Batches smaller than this are inserted value by value, sorting them would not pay off.
+#define BATCH_MIN_VALUES 32
+
+// Subtrees lower than this are merged on the calling thread, smaller ones are not worth a thread.
+#define SET_FORK_MIN_HEIGHT 14
+
+// Set operations, see set_operation.
+#define SET_UNION           0
+#define SET_INTERSECTION    1
+#define SET_DIFFERENCE      2
+
+/**
+ * @brief Links to the nodes visited from the root down, where [links][0] is the link to the root.
+ *
+ * Rotations keep the root node of the rotated subtree in place and move values instead, so
+ * recorded links remain valid while the path is rebalanced.
+ */
+typedef struct NodePath {
+    AVLNode*** links;
+    AVLNode** inlineLinks[PATH_INLINE_DEPTH];
+    int depth;
+    int capacity;
+} NodePath;
+
+/**
+ * @brief Nodes dropped by a set operation, linked through their left child like a pool's free list.
+ *
+ * Each task of a parallel operation collects its own chain, which are concatenated when tasks
+ * are joined, so nodes are given back to the pool without locking.
+ */
+typedef struct NodeChain {
+    AVLNode* first;
+    AVLNode* last;
+} NodeChain;
+
+/**
+ * @brief Half of a set operation running on its own thread.
+ */
+typedef struct SetTask {
+    // View of the tree for augmentations, with counters of the task's own.
+    AVLTree tree;
+    BSTStats stats;
+
+    int operation;
+    AVLNode* a;
+    AVLNode* b;
+    int threads;
+
+    AVLNode* result;
+    NodeChain dropped;
+} SetTask;
 
 #pragma region Function Declarations
 static int get_balance_factor(AVLNode* node);
 static void update_node_height(AVLNode* node);
+static void update_node(AVLTree* tree, AVLNode* node);
+static void update_augments(AVLTree* tree, AVLNode* node);
+static void update_aggregates(AVLNode* node);
+static void update_max_high(AVLTree* tree, AVLNode* node);
+static void swap_highs(AVLTree* tree, AVLNode* a, AVLNode* b);
+static void copy_value(AVLTree* tree, AVLNode* to, AVLNode* from);
+static void sum_below(AVLNode* root, int value, int inclusive, int* count, long long* sum);
 static int get_height(AVLNode* node);
+static int compare_ints(const void* a, const void* b);
+
+static void balance(AVLTree* tree, AVLNode* root);
+static void rotate_left(AVLTree* tree, AVLNode* root);
+static void rotate_right(AVLTree* tree, AVLNode* root);
+
+static AVLNode* create_node(AVLTree* tree, int value);
+static void release_node(AVLTree* tree, AVLNode* node);
+static int insert_node(AVLTree* tree, AVLNode** root, int value);
+static int remove_node(AVLTree* tree, AVLNode** root, int value);
+static void rebalance_path(AVLTree* tree, NodePath* path);
+static int rebalance_links(AVLTree* tree, AVLNode*** links, int depth);
+
+static void path_init(NodePath* path);
+static int path_push(NodePath* path, AVLNode** link);
+static void path_free(NodePath* path);
+
+static int sort_unique(int* values, int len);
+static AVLNode* build_sorted(AVLTree* tree, const int* values, int len);
+static AVLNode* build_unsorted(AVLTree* tree, const int* values, int len);
+static void release_balanced(AVLTree* tree, AVLNode* root);
+static int replace_root(AVLTree* tree, const int* values, int len, int sorted);
+static void insert_batch(AVLTree* tree, AVLNode** root, const int* values, int len);
+static AVLNode* merge_sorted(AVLTree* tree, AVLNode* root, const int* values, int len);
+static int remove_batch(AVLTree* tree, AVLNode** root, const int* values, int len, int rebuildPercent);
+static AVLNode* remove_sorted(AVLTree* tree, AVLNode* root, const int* values, int len, NodeChain* removed);
+static AVLNode* rebuild_without(AVLTree* tree, AVLNode* root, const int* values, int len, NodeChain* removed);
+static AVLNode* build_from_chain(AVLTree* tree, AVLNode** chain, int len);
+static int release_chain(AVLTree* tree, NodeChain* chain);
+static int search_sorted(AVLTree* tree, const int* values, int len, int value);
+
+static AVLNode* join(AVLTree* tree, AVLNode* left, AVLNode* node, AVLNode* right);
+static AVLNode* join_sides(AVLTree* tree, AVLNode* left, AVLNode* right);
+static AVLNode* split(AVLTree* tree, AVLNode* root, int value, AVLNode** left, AVLNode** right);
+static AVLNode* set_operation(AVLTree* tree, int operation, AVLNode* a, AVLNode* b, int threads, NodeChain* dropped);
+static void* run_set_task(void* task);
+static int merge_trees(AVLTree* tree, AVLTree* other, int operation, int threads);
+static void chain_push(NodeChain* chain, AVLNode* node);
+static void chain_push_tree(NodeChain* chain, AVLNode* root);
+static void chain_append(NodeChain* chain, NodeChain* other);
+
+static const void* get_interval_left(const void* node, const void* context);
+static const void* get_interval_right(const void* node, const void* context);
+static int get_interval_value(const void* node, const void* context);
+static int get_interval_high(const void* node, const void* context);
+
+static AVLNode* cursor_seek(AVLCursor* cursor, int value);
+static int cursor_push(AVLCursor* cursor, AVLNode** link, long long low, long long high);
+static void cursor_rebalance(AVLCursor* cursor, int depth, int kept, int value);
 
-static void balance(AVLNode* root);
-static void rotate_left(AVLNode* root);
-static void rotate_right(AVLNode* root);
+static inline void count_comparison(AVLTree* tree) {
+    if (tree && tree->stats) {
+        ++tree->stats->comparisons;
+    }
+}
 
-static int remove_max(AVLNode* parent, AVLNode** node);
+static inline void count_rotation(AVLTree* tree) {
+    if (tree && tree->stats) {
+        ++tree->stats->rotations;
+    }
+}
 
 #pragma endregion
 
@@ -27,91 +156,306 @@ AVLNode* avl_create_tree(const int* values, const int len) {
     return root;
 }
 
+/**
+ * @brief Build a height-balanced tree from values given in any order, duplicates are dropped.
+ *
+ * The values are sorted first, then the tree is built in linear time without any rotation.
+ * @param values Node values array.
+ * @param len Number of values.
+ * @return Pointer to the root node, or null if no values are given.
+ */
+AVLNode* avl_build_tree(const int* values, const int len) {
+    return build_unsorted(NULL, values, len);
+}
+
+/**
+ * @brief Build a height-balanced tree in linear time from values in strictly increasing order.
+ * @return Pointer to the root node, or null if no values are given.
+ */
+AVLNode* avl_build_sorted_tree(const int* values, const int len) {
+    return build_sorted(NULL, values, len);
+}
+
+/**
+ * @brief Sort a copy of [values], drop duplicates and build a balanced tree from the result.
+ */
+AVLNode* build_unsorted(AVLTree* tree, const int* values, int len) {
+    if (len <= 0) {
+        return NULL;
+    }
+    int* sorted = (int*)malloc(len * sizeof(int));
+    if (!sorted) {
+        return NULL;
+    }
+    memcpy(sorted, values, len * sizeof(int));
+    len = sort_unique(sorted, len);
+    AVLNode* root = build_sorted(tree, sorted, len);
+    free(sorted);
+    return root;
+}
+
+/**
+ * @brief Build a height-balanced tree whose in-order sequence is [values].
+ *
+ * The middle value becomes the root and both halves are built the same way, so sizes of
+ * sibling subtrees differ by at most one. Nodes are created in pre-order, which keeps
+ * pooled nodes of a subtree next to each other.
+ * @return Root of the tree, or null if no values are given or a node cannot be allocated,
+ * in which case the nodes created so far are released.
+ */
+AVLNode* build_sorted(AVLTree* tree, const int* values, int len) {
+    if (len <= 0) {
+        return NULL;
+    }
+    int mid = (len - 1) / 2;
+    AVLNode* node = create_node(tree, values[mid]);
+    if (!node) {
+        return NULL;
+    }
+    node->left = build_sorted(tree, values, mid);
+    node->right = node->left || mid == 0 ? build_sorted(tree, values + mid + 1, len - mid - 1) : NULL;
+    if ((mid > 0 && !node->left) || (len - mid - 1 > 0 && !node->right)) {
+        release_balanced(tree, node);
+        return NULL;
+    }
+    update_node(tree, node);
+    return node;
+}
+
+/**
+ * @brief Release all nodes of a subtree, recursively as its height is logarithmic in its size.
+ */
+void release_balanced(AVLTree* tree, AVLNode* root) {
+    if (!root) {
+        return;
+    }
+    release_balanced(tree, root->left);
+    release_balanced(tree, root->right);
+    release_node(tree, root);
+}
+
+/**
+ * @brief Sort values in increasing order with a byte-wise radix sort, then remove duplicates.
+ * @return Number of unique values kept at the beginning of the array.
+ */
+int sort_unique(int* values, int len) {
+    unsigned int* keys = (unsigned int*)values;
+    unsigned int* temp = (unsigned int*)malloc(len * sizeof(unsigned int));
+    if (temp) {
+        // Flipping the sign bit makes unsigned order match signed order.
+        for (int i = 0; i < len; ++i) {
+            keys[i] ^= 0x80000000u;
+        }
+        for (int shift = 0; shift < 32; shift += 8) {
+            int counts[257] = {0};
+            for (int i = 0; i < len; ++i) {
+                ++counts[((keys[i] >> shift) & 0xFF) + 1];
+            }
+            if (counts[((keys[0] >> shift) & 0xFF) + 1] == len) {
+                continue; // All keys share this byte, the pass would not move anything.
+            }
+            for (int b = 0; b < 256; ++b) {
+                counts[b + 1] += counts[b];
+            }
+            for (int i = 0; i < len; ++i) {
+                temp[counts[(keys[i] >> shift) & 0xFF]++] = keys[i];
+            }
+            memcpy(keys, temp, len * sizeof(unsigned int));
+        }
+        for (int i = 0; i < len; ++i) {
+            keys[i] ^= 0x80000000u;
+        }
+        free(temp);
+    } else {
+        qsort(values, len, sizeof(int), compare_ints);
+    }
+
+    int unique = len > 0 ? 1 : 0;
+    for (int i = 1; i < len; ++i) {
+        if (values[i] != values[unique - 1]) {
+            values[unique++] = values[i];
+        }
+    }
+    return unique;
+}
+
 /**
  * @brief Allocate memory for an AVL Node without children.
  * @param value To assign as the node's value.
  * @return Pointer to the AVL Node.
  */
 AVLNode* avl_create_node(int value) {
-    AVLNode* node = (AVLNode*)malloc(sizeof(AVLNode));
+    return create_node(NULL, value);
+}
+
+/**
+ * @brief Allocate a node without children from the tree's pool, or from the heap if no tree is given.
+ */
+AVLNode* create_node(AVLTree* tree, int value) {
+    AVLNode* node = tree ? avl_pool_alloc(&tree->pool) : (AVLNode*)malloc(sizeof(AVLNode));
+    if (!node) {
+        return NULL;
+    }
     node->value = value;
     node->height = 1;
     node->left = NULL;
     node->right = NULL;
+    if (tree && (tree->augments & AVL_AUGMENT_INTERVALS)) {
+        avl_interval(tree, node)->high = value;
+    }
+    if (tree && tree->augments) {
+        update_augments(tree, node);
+    }
     return node;
 }
 
 /**
- * @brief Insert multiple nodes into a tree.
+ * @brief Insert multiple nodes into a tree, values already in the tree or repeated are skipped.
+ *
+ * Large batches are sorted and merged into the tree in one pass, see insert_batch.
  * @param root Root node pointer, will be allocated if passing null.
  * @param values Array of values to insert.
  * @param len Size of value array.
  */
 void avl_insert_nodes(AVLNode** root, const int* values, const int len) {
-    for (int i = 0; i < len; ++i) {
-        avl_insert_node(root, values[i]);
+    insert_batch(NULL, root, values, len);
+}
+
+/**
+ * @brief Insert values one by one for small batches, otherwise sort them and merge them into the tree.
+ *
+ * Merging takes O(m log(n/m + 1)) for m values into n nodes, instead of O(m log n) for separate
+ * insertions, and each affected subtree is rebalanced once. The shape of the resulting tree may
+ * differ from the one of separate insertions.
+ */
+void insert_batch(AVLTree* tree, AVLNode** root, const int* values, int len) {
+    int* sorted = len >= BATCH_MIN_VALUES ? (int*)malloc(len * sizeof(int)) : NULL;
+    if (!sorted) {
+        for (int i = 0; i < len; ++i) {
+            insert_node(tree, root, values[i]);
+        }
+        return;
+    }
+    memcpy(sorted, values, len * sizeof(int));
+    len = sort_unique(sorted, len);
+    *root = merge_sorted(tree, *root, sorted, len);
+    free(sorted);
+}
+
+/**
+ * @brief Insert strictly increasing values into a subtree, splitting the values by the subtree's root.
+ *
+ * Both halves go to the root's children, then the root joins the grown children back,
+ * which rebalances along the spine of the higher one. Subtrees getting no value are not visited.
+ * @return Root of the merged subtree.
+ */
+AVLNode* merge_sorted(AVLTree* tree, AVLNode* root, const int* values, int len) {
+    if (len <= 0) {
+        return root;
     }
+    if (!root) {
+        return build_sorted(tree, values, len);
+    }
+
+    // Values [0, low) go to the left, a value equal to the root is skipped.
+    int low = search_sorted(tree, values, len, root->value);
+    int skip = low < len && values[low] == root->value;
+
+    // Subtrees keeping their root and height leave this node as it is, which spares reading the other child.
+    int changed = tree && tree->augments;
+    AVLNode* left = root->left;
+    AVLNode* right = root->right;
+    if (low > 0) {
+        int height = get_height(left);
+        left = merge_sorted(tree, left, values, low);
+        changed |= left != root->left || get_height(left) != height;
+    }
+    if (low + skip < len) {
+        int height = get_height(right);
+        right = merge_sorted(tree, right, values + low + skip, len - low - skip);
+        changed |= right != root->right || get_height(right) != height;
+    }
+    return changed ? join(tree, left, root, right) : root;
 }
 
 /**
- * @brief Delete assigned memory of the entire tree recursively.
+ * @brief Delete assigned memory of the entire tree.
+ *
+ * Left children are rotated up until the top node has none, which is then freed and its right
+ * subtree taken next. This needs neither recursion nor a stack, so trees of any shape are freed.
  * @param root Pointer to the root node of the tree to be freed, assigned to null after finished.
  */
 void avl_free_tree(AVLNode** root) {
-    if (!(*root)) return;
-    int rootValue = (*root)->value;
-    avl_free_tree(&(*root)->left);
-    avl_free_tree(&(*root)->right);
-    free(*root);
+    AVLNode* node = *root;
+    while (node) {
+        AVLNode* left = node->left;
+        if (left) {
+            node->left = left->right;
+            left->right = node;
+            node = left;
+        } else {
+            AVLNode* right = node->right;
+            free(node);
+            node = right;
+        }
+    }
     *root = NULL;
 }
 
+/**
+ * @brief Give back memory of a node to where it was allocated.
+ */
+void release_node(AVLTree* tree, AVLNode* node) {
+    if (tree) {
+        avl_pool_release(&tree->pool, node);
+    } else {
+        free(node);
+    }
+}
+
 /**
  * @brief Insert a value to the tree.
  * @param root Tree's root.
  * @param value Value to insert.
+ * @return 1 if the value is inserted, 0 if it already exists.
  */
 int avl_insert_node(AVLNode** root, int value) {
-    if (!(*root)) {
-        *root = avl_create_node(value);
-    }
-    if (value == (*root)->value) {
-        return 0;
-    }
-    
-    int inserted = 0;
-    if (value < (*root)->value) {
-        if ((*root)->left) {
-            // Continue finding on the left sub-tree.
-            inserted = avl_insert_node(&((*root)->left), value);
-        } else {
-            // Left child is empty, insert here.
-            (*root)->left = avl_create_node(value);
-            inserted = 1;
-        }
-    } else if (value > (*root)->value) {
-        if ((*root)->right) {
-            // Continue finding on the right sub-tree.
-            inserted = avl_insert_node(&((*root)->right), value);
-        } else {
-            // Right child is empty, insert here.
-            (*root)->right = avl_create_node(value);
-            inserted = 1;
+    return insert_node(NULL, root, value);
+}
+
+/**
+ * @brief Insert a value to the tree, allocating the new node from [tree] if given.
+ *
+ * The descent records links of visited nodes, then heights are fixed bottom-up along them.
+ */
+int insert_node(AVLTree* tree, AVLNode** root, int value) {
+    NodePath path;
+    path_init(&path);
+
+    AVLNode** link = root;
+    while (*link) {
+        AVLNode* node = *link;
+        count_comparison(tree);
+        if (value == node->value || !path_push(&path, link)) {
+            path_free(&path);
+            return 0;
         }
+        link = value < node->value ? &node->left : &node->right;
     }
 
+    *link = create_node(tree, value);
+    int inserted = *link != NULL;
     if (inserted) {
-        // Update height and rebalance if needed.
-        update_node_height(*root);
-        balance(*root);
+        rebalance_path(tree, &path);
     }
+    path_free(&path);
     return inserted;
 }
 
 /**
  * @brief Check for balance factors at a node and its children to determine if rotations needed.
  */
-void balance(AVLNode* root) {
+void balance(AVLTree* tree, AVLNode* root) {
     int balanceFactor = get_balance_factor(root);
     if (balanceFactor >= -1 && balanceFactor <= 1) {
         return;
@@ -122,22 +466,18 @@ void balance(AVLNode* root) {
         // Left child is slightly right-heavy, a right rotation at root might make its right child higher.
         // Therefore a left rotation at left child is needed.
         if (get_balance_factor(root->left) > 0) {
-            rotate_left(root->left);
+            rotate_left(tree, root->left);
         }
 
-        rotate_right(root);
+        rotate_right(tree, root);
     } else if (balanceFactor > 1) {
         // Similar implementation on the other side.
 
         if (get_balance_factor(root->right) < 0) {
-            rotate_right(root->right);
+            rotate_right(tree, root->right);
         }
-        rotate_left(root);
+        rotate_left(tree, root);
     }
-
-    update_node_height(root->right);
-    update_node_height(root->left);
-    update_node_height(root);
 }
 
 /**
@@ -174,7 +514,9 @@ void balance(AVLNode* root) {
  *   ┃ X1┃     ┃ Z1┃
  *   ┗━━━┛     ┗━━━┛
  */
-void rotate_left(AVLNode* root) {
+void rotate_left(AVLTree* tree, AVLNode* root) {
+    count_rotation(tree);
+
     // Right child node is taken out and reserved as its value will shift to the root node's position
     AVLNode* reservedNode = root->right;
     
@@ -188,92 +530,354 @@ void rotate_left(AVLNode* root) {
     reservedNode->right = reservedNode->left;
     reservedNode->left = root->left;
     reservedNode->value = tempRootValue;
+    swap_highs(tree, root, reservedNode);
 
     // Connect the new root and the new left nodes.
     root->left = reservedNode;
+
+    // Only the two nodes whose children changed need updates, the lower one first.
+    update_node(tree, reservedNode);
+    update_node(tree, root);
 }
 
 /**
  * @brief Similar to left rotation.
  * @ref rotateLeft
  */
-void rotate_right(AVLNode* root) {
+void rotate_right(AVLTree* tree, AVLNode* root) {
+    count_rotation(tree);
     AVLNode* toReuseNode = root->left;
     int tempRootValue = root->value;
     root->value = root->left->value;
     root->left = root->left->left;
     toReuseNode->value = tempRootValue;
+    swap_highs(tree, root, toReuseNode);
     toReuseNode->left = toReuseNode->right;
     toReuseNode->right = root->right;
     root->right = toReuseNode;
+    update_node(tree, toReuseNode);
+    update_node(tree, root);
 }
 
 /**
  * @brief Find node to remove.
  * @param value Value to be removed.
  * @param root Tree's root node.
+ * @return 1 if the value is removed, 0 if it is not found.
  */
 int avl_remove_node(AVLNode** root, int value) {
-    int removed = 0;
-    if (value < (*root)->value) {
-        // Continue finding on left sub-tree.
-        removed = (*root)->left ? avl_remove_node(&(*root)->left, value) : 0;
-    } else if (value > (*root)->value) {
-        // Continue finding on right sub-tree.
-        removed = (*root)->right ? avl_remove_node(&(*root)->right, value) : 0;
+    return remove_node(NULL, root, value);
+}
+
+/**
+ * @brief Remove multiple values from a tree, values not in the tree are ignored.
+ * @ref remove_batch
+ * @return Number of values removed.
+ */
+int avl_remove_nodes(AVLNode** root, const int* values, const int len) {
+    return remove_batch(NULL, root, values, len, AVL_REBUILD_PERCENT);
+}
+
+/**
+ * @brief Remove values one by one for small batches, otherwise sort them and remove them together.
+ *
+ * A batch removing less than [rebuildPercent] of the tree splits the sorted values along one
+ * traversal, so that each affected subtree is joined back once. Larger batches filter the tree's
+ * in-order sequence and rebuild it balanced in O(n), reusing the remaining nodes.
+ * @return Number of values removed.
+ */
+int remove_batch(AVLTree* tree, AVLNode** root, const int* values, int len, int rebuildPercent) {
+    int* sorted = len >= BATCH_MIN_VALUES ? (int*)malloc(len * sizeof(int)) : NULL;
+    if (!sorted) {
+        int removed = 0;
+        for (int i = 0; i < len; ++i) {
+            removed += remove_node(tree, root, values[i]);
+        }
+        return removed;
+    }
+    memcpy(sorted, values, len * sizeof(int));
+    len = sort_unique(sorted, len);
+
+    // Without aggregates the size is bounded by the height, so the rebuild is only taken when surely worth it.
+    long long size = tree && (tree->augments & AVL_AUGMENT_AGGREGATES) && *root
+        ? avl_aggregate(*root)->count
+        : (1LL << (get_height(*root) < 62 ? get_height(*root) : 62)) - 1;
+    NodeChain removed = { NULL, NULL };
+    if ((long long)len * 100 >= size * rebuildPercent) {
+        *root = rebuild_without(tree, *root, sorted, len, &removed);
+        if (tree) {
+            ++tree->rebuilds;
+        }
     } else {
-        // Node found
-        if (!(*root)->left && !(*root)->right) {
-            free(*root);
-            *root = NULL;
-        } else if (!(*root)->left) {
-            // No left child, delete root and replaced by the right child.
-            (*root)->value = (*root)->right->value;
-            AVLNode* tempRight = (*root)->right;
-            (*root)->right = (*root)->right->right;
-            free(tempRight);
-        } else if ((*root)->left->right) {
-            // Left child exists, find the maximum node on the left sub-tree to replace root.
-            int removedValue = remove_max((*root)->left, &(*root)->left->right);
-            (*root)->value = removedValue;
+        *root = remove_sorted(tree, *root, sorted, len, &removed);
+    }
+    free(sorted);
+    return release_chain(tree, &removed);
+}
+
+/**
+ * @brief Remove strictly increasing values from a subtree, splitting the values by the subtree's root.
+ *
+ * Both halves are removed from the root's children, then the root joins them back, or is
+ * removed itself by joining the children directly. Subtrees getting no value are not visited.
+ * @param removed Receives the removed nodes.
+ * @return Root of the remaining subtree.
+ */
+AVLNode* remove_sorted(AVLTree* tree, AVLNode* root, const int* values, int len, NodeChain* removed) {
+    if (len <= 0 || !root) {
+        return root;
+    }
+    int low = search_sorted(tree, values, len, root->value);
+    int found = low < len && values[low] == root->value;
+
+    // Same as merge_sorted, unchanged subtrees leave this node as it is.
+    int changed = tree && tree->augments;
+    AVLNode* left = root->left;
+    AVLNode* right = root->right;
+    if (low > 0) {
+        int height = get_height(left);
+        left = remove_sorted(tree, left, values, low, removed);
+        changed |= left != root->left || get_height(left) != height;
+    }
+    if (low + found < len) {
+        int height = get_height(right);
+        right = remove_sorted(tree, right, values + low + found, len - low - found, removed);
+        changed |= right != root->right || get_height(right) != height;
+    }
+    if (found) {
+        chain_push(removed, root);
+        return join_sides(tree, left, right);
+    }
+    return changed ? join(tree, left, root, right) : root;
+}
+
+/**
+ * @brief Remove strictly increasing values from a tree by filtering its nodes in order, then rebuild it balanced.
+ *
+ * The tree is flattened into an ascending chain without recursion, and the remaining nodes are
+ * linked again into a height-balanced tree. Nothing is allocated, all in O(n).
+ * @param removed Receives the removed nodes.
+ * @return Root of the rebuilt tree.
+ */
+AVLNode* rebuild_without(AVLTree* tree, AVLNode* root, const int* values, int len, NodeChain* removed) {
+    NodeChain nodes = { NULL, NULL };
+    chain_push_tree(&nodes, root);
+
+    // Kept nodes stay in ascending order by being appended at the tail.
+    AVLNode* kept = NULL;
+    AVLNode** tail = &kept;
+    int keptCount = 0;
+    int i = 0;
+    AVLNode* node = nodes.first;
+    while (node) {
+        AVLNode* next = node->left;
+        while (i < len && values[i] < node->value) {
+            ++i;
+        }
+        count_comparison(tree);
+        if (i < len && values[i] == node->value) {
+            chain_push(removed, node);
         } else {
-            // No right child, or left child is the maximum in its subtree (left child has no right child)
-            // delete root and replaced by the left child
-            (*root)->value = (*root)->left->value;
-            AVLNode* tempLeft = (*root)->left;
-            (*root)->left = (*root)->left->left;
-            free(tempLeft);
+            *tail = node;
+            tail = &node->left;
+            ++keptCount;
+        }
+        node = next;
+    }
+    *tail = NULL;
+
+    AVLNode* chain = kept;
+    return build_from_chain(tree, &chain, keptCount);
+}
+
+/**
+ * @brief Link the first [len] nodes of an ascending chain into a height-balanced tree, like build_sorted.
+ * @param chain First node of the chain linked through left children, advanced past the used nodes.
+ */
+AVLNode* build_from_chain(AVLTree* tree, AVLNode** chain, int len) {
+    if (len <= 0) {
+        return NULL;
+    }
+    int mid = (len - 1) / 2;
+    AVLNode* left = build_from_chain(tree, chain, mid);
+    AVLNode* node = *chain;
+    *chain = node->left;
+    node->left = left;
+    node->right = build_from_chain(tree, chain, len - mid - 1);
+    update_node(tree, node);
+    return node;
+}
+
+/**
+ * @brief Give nodes of a chain back to [tree]'s pool, or to the heap if no tree is given.
+ * @return Number of nodes released.
+ */
+int release_chain(AVLTree* tree, NodeChain* chain) {
+    int count = 0;
+    for (AVLNode* node = chain->first; node; ++count) {
+        AVLNode* next = node->left;
+        if (!tree) {
+            free(node);
         }
-        removed = 1;
+        node = next;
     }
+    if (tree) {
+        avl_pool_release_list(&tree->pool, chain->first, chain->last);
+    }
+    chain->first = NULL;
+    chain->last = NULL;
+    return count;
+}
 
-    if (removed && *root) {
-        update_node_height(*root);
-        balance(*root);
+/**
+ * @return Index of the first of the increasing [values] which is not less than [value].
+ */
+int search_sorted(AVLTree* tree, const int* values, int len, int value) {
+    int low = 0;
+    int high = len;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        count_comparison(tree);
+        if (values[mid] < value) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
     }
-    return removed;
+    return low;
 }
 
 /**
- * @brief Find the maximum node of the tree and remove it.
- * @param current Node to start finding.
- * @param parent Parent node of the current node. Needed for re-connecting with grandchild after deletion of current.
+ * @brief Remove a value from the tree, giving the freed node back to [tree] if given.
+ *
+ * A node with a left child takes over the maximum value of its left subtree, whose node is
+ * removed instead. Heights are then fixed bottom-up along the recorded path.
  */
-int remove_max(AVLNode* parent, AVLNode** current) {
-    int removedValue = 0;
-    if ((*current)->right) {
-        removedValue = remove_max(*current, &((*current)->right));
+int remove_node(AVLTree* tree, AVLNode** root, int value) {
+    NodePath path;
+    path_init(&path);
+
+    AVLNode** link = root;
+    while (*link && (count_comparison(tree), (*link)->value != value)) {
+        if (!path_push(&path, link)) {
+            path_free(&path);
+            return 0;
+        }
+        link = value < (*link)->value ? &(*link)->left : &(*link)->right;
+    }
+    if (!(*link)) {
+        path_free(&path);
+        return 0;
+    }
+
+    AVLNode* node = *link;
+    if (!node->left) {
+        // No left child, the node is replaced by its right child, which might be null.
+        *link = node->right;
+        release_node(tree, node);
     } else {
-        removedValue = (*current)->value;
-        AVLNode* currentLeft = (*current)->left;
-        free(*current);
-        *current = currentLeft;
+        // Find the maximum node on the left sub-tree to replace the node's value.
+        AVLNode** maxLink = &node->left;
+        int recorded = path_push(&path, link);
+        while (recorded && (*maxLink)->right) {
+            recorded = path_push(&path, maxLink);
+            maxLink = &(*maxLink)->right;
+        }
+        if (!recorded) {
+            path_free(&path);
+            return 0;
+        }
+        AVLNode* max = *maxLink;
+        copy_value(tree, node, max);
+        *maxLink = max->left;
+        release_node(tree, max);
+    }
+
+    rebalance_path(tree, &path);
+    path_free(&path);
+    return 1;
+}
+
+/**
+ * @brief Update and rebalance nodes on the path bottom-up, after a node was added or removed below it.
+ *
+ * Once a subtree keeps the height it had before, nodes above it cannot be unbalanced, so
+ * rebalancing stops there. Only subtree aggregates, if maintained, are refreshed further up.
+ */
+void rebalance_path(AVLTree* tree, NodePath* path) {
+    rebalance_links(tree, path->links, path->depth);
+}
+
+/**
+ * @brief Rebalance nodes behind [links] bottom-up, the first link being the top one.
+ * @ref rebalance_path
+ * @return Index of the topmost link whose node got rotated, or [depth] if there was no rotation.
+ */
+int rebalance_links(AVLTree* tree, AVLNode*** links, int depth) {
+    int rotated = depth;
+    int i = depth - 1;
+    while (i >= 0) {
+        AVLNode* node = *links[i];
+        int oldHeight = node->height;
+        update_node(tree, node);
+        int balanceFactor = get_balance_factor(node);
+        if (balanceFactor < -1 || balanceFactor > 1) {
+            balance(tree, node);
+            rotated = i;
+        }
+        --i;
+        if (node->height == oldHeight) {
+            break;
+        }
     }
 
-    update_node_height(parent);
-    balance(parent);
+    if (tree && tree->augments) {
+        for (; i >= 0; --i) {
+            update_augments(tree, *links[i]);
+        }
+    }
+    return rotated;
+}
+
+/**
+ * @brief Initialize an empty path, using the inline storage until the path gets deeper than an AVL tree can be.
+ */
+void path_init(NodePath* path) {
+    path->links = path->inlineLinks;
+    path->depth = 0;
+    path->capacity = PATH_INLINE_DEPTH;
+}
+
+/**
+ * @brief Append the link of a visited node, moving to heap storage for trees which are not balanced.
+ * @return 1 on success, 0 if memory for a deeper path cannot be allocated.
+ */
+int path_push(NodePath* path, AVLNode** link) {
+    if (path->depth == path->capacity) {
+        int capacity = path->capacity * 2;
+        AVLNode*** links = (AVLNode***)malloc(capacity * sizeof(AVLNode**));
+        if (!links) {
+            return 0;
+        }
+        memcpy(links, path->links, path->depth * sizeof(AVLNode**));
+        if (path->links != path->inlineLinks) {
+            free(path->links);
+        }
+        path->links = links;
+        path->capacity = capacity;
+    }
+    path->links[path->depth++] = link;
+    return 1;
+}
 
-    return removedValue;
+/**
+ * @brief Free heap storage of the path, if any.
+ */
+void path_free(NodePath* path) {
+    if (path->links != path->inlineLinks) {
+        free(path->links);
+    }
+    path_init(path);
 }
 
 /**
@@ -298,6 +902,87 @@ void update_node_height(AVLNode* node) {
     }
 }
 
+/**
+ * @brief Update node's height and the augmented data selected by the tree, from its children.
+ * @param tree Tree owning the node, or null for a plain heap-allocated node.
+ */
+void update_node(AVLTree* tree, AVLNode* node) {
+    update_node_height(node);
+    if (tree && tree->augments) {
+        update_augments(tree, node);
+    }
+}
+
+/**
+ * @brief Recompute all augmented data selected by the tree from the node's children.
+ */
+void update_augments(AVLTree* tree, AVLNode* node) {
+    if (tree->augments & AVL_AUGMENT_AGGREGATES) {
+        update_aggregates(node);
+    }
+    if (tree->augments & AVL_AUGMENT_INTERVALS) {
+        update_max_high(tree, node);
+    }
+}
+
+/**
+ * @brief Recompute subtree summaries of an aggregate node from its children.
+ */
+void update_aggregates(AVLNode* node) {
+    AVLAggregateNode* aggregate = avl_aggregate(node);
+    aggregate->count = 1;
+    aggregate->min = node->value;
+    aggregate->max = node->value;
+    aggregate->sum = node->value;
+    if (node->left) {
+        AVLAggregateNode* left = avl_aggregate(node->left);
+        aggregate->count += left->count;
+        aggregate->min = left->min;
+        aggregate->sum += left->sum;
+    }
+    if (node->right) {
+        AVLAggregateNode* right = avl_aggregate(node->right);
+        aggregate->count += right->count;
+        aggregate->max = right->max;
+        aggregate->sum += right->sum;
+    }
+}
+
+/**
+ * @brief Recompute the largest high end of the node's subtree from its children.
+ */
+void update_max_high(AVLTree* tree, AVLNode* node) {
+    AVLInterval* interval = avl_interval(tree, node);
+    interval->maxHigh = interval->high;
+    if (node->left && avl_interval(tree, node->left)->maxHigh > interval->maxHigh) {
+        interval->maxHigh = avl_interval(tree, node->left)->maxHigh;
+    }
+    if (node->right && avl_interval(tree, node->right)->maxHigh > interval->maxHigh) {
+        interval->maxHigh = avl_interval(tree, node->right)->maxHigh;
+    }
+}
+
+/**
+ * @brief Exchange the high ends of two nodes whose values a rotation exchanged, so that intervals move with their low end.
+ */
+void swap_highs(AVLTree* tree, AVLNode* a, AVLNode* b) {
+    if (tree && (tree->augments & AVL_AUGMENT_INTERVALS)) {
+        int high = avl_interval(tree, a)->high;
+        avl_interval(tree, a)->high = avl_interval(tree, b)->high;
+        avl_interval(tree, b)->high = high;
+    }
+}
+
+/**
+ * @brief Move the value of a node about to be removed into another node, with its interval's high end if any.
+ */
+void copy_value(AVLTree* tree, AVLNode* to, AVLNode* from) {
+    to->value = from->value;
+    if (tree && (tree->augments & AVL_AUGMENT_INTERVALS)) {
+        avl_interval(tree, to)->high = avl_interval(tree, from)->high;
+    }
+}
+
 /**
  * @param node A tree's node.
  * @return Height of given node, or zero if node is null.
@@ -306,19 +991,1047 @@ int get_height(AVLNode* node) {
     return node ? node->height : 0;
 }
 
+int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
 /**
  * @brief Traverse all nodes to calculate heights.
+ *
+ * Nodes are visited in post-order along a path kept on the heap, so unbalanced trees of any
+ * depth are handled.
  * @param root The tree's root.
  */
 void avl_update_tree_height(AVLNode *root) {
-    if (!root) {
-        return;
-    }
-    if (root->left) {
-        avl_update_tree_height(root->left);
+    NodePath path;
+    path_init(&path);
+    AVLNode** link = &root;
+    AVLNode* last = NULL;
+    while (*link || path.depth) {
+        if (*link) {
+            if (!path_push(&path, link)) {
+                break;
+            }
+            link = &(*link)->left;
+            continue;
+        }
+        // The left subtree of the node on top is done, go on with its right one or finish the node.
+        AVLNode* node = *path.links[path.depth - 1];
+        if (node->right && node->right != last) {
+            link = &node->right;
+        } else {
+            update_node_height(node);
+            last = node;
+            --path.depth;
+        }
     }
-    if (root->right) {
-        avl_update_tree_height(root->right);
+    path_free(&path);
+}
+
+/**
+ * @brief Initialize an empty tree handle with plain nodes.
+ */
+void avl_tree_init(AVLTree* tree) {
+    avl_tree_init_augmented(tree, AVL_AUGMENT_NONE);
+}
+
+/**
+ * @brief Initialize an empty tree handle whose nodes maintain extra data.
+ * @param augments AVL_AUGMENT_* flags, plain trees do not pay for augmentations they do not select.
+ */
+void avl_tree_init_augmented(AVLTree* tree, int augments) {
+    tree->root = NULL;
+    tree->augments = augments;
+    tree->version = 0;
+    tree->rebuildPercent = AVL_REBUILD_PERCENT;
+    tree->rebuilds = 0;
+    tree->stats = NULL;
+    size_t nodeSize = (augments & AVL_AUGMENT_AGGREGATES) ? sizeof(AVLAggregateNode) : sizeof(AVLNode);
+    if (augments & AVL_AUGMENT_INTERVALS) {
+        nodeSize += sizeof(AVLInterval);
     }
-    update_node_height(root);
-}
\ No newline at end of file
+    avl_pool_init(&tree->pool, nodeSize);
+}
+
+/**
+ * @brief Allocate a node without children from the tree's pool, e.g. to assemble a tree of a given shape.
+ * @return Pointer to the node, which stays valid until it is removed or the tree is cleared.
+ */
+AVLNode* avl_tree_create_node(AVLTree* tree, int value) {
+    return create_node(tree, value);
+}
+
+/**
+ * @brief Insert a value to the tree, reusing a previously removed node if any.
+ * @return 1 if the value is inserted, 0 if it already exists.
+ */
+int avl_tree_insert_node(AVLTree* tree, int value) {
+    ++tree->version;
+    return insert_node(tree, &tree->root, value);
+}
+
+/**
+ * @brief Insert multiple values to the tree, large batches are merged in one pass.
+ * @ref avl_insert_nodes
+ */
+void avl_tree_insert_nodes(AVLTree* tree, const int* values, const int len) {
+    ++tree->version;
+    insert_batch(tree, &tree->root, values, len);
+}
+
+/**
+ * @brief Replace the tree's content by a height-balanced tree built from values in any order.
+ *
+ * Duplicates are dropped. Sorting is followed by a linear-time build without any rotation.
+ * @return 1 on success, 0 if memory runs out, leaving the tree unchanged.
+ */
+int avl_tree_build(AVLTree* tree, const int* values, const int len) {
+    return replace_root(tree, values, len, 0);
+}
+
+/**
+ * @brief Replace the tree's content by a height-balanced tree built in linear time
+ * from values in strictly increasing order.
+ * @return 1 on success, 0 if memory runs out, leaving the tree unchanged.
+ */
+int avl_tree_build_sorted(AVLTree* tree, const int* values, const int len) {
+    return replace_root(tree, values, len, 1);
+}
+
+/**
+ * @brief Build the new content in a pool of its own, which replaces the old pool once the build succeeded.
+ */
+int replace_root(AVLTree* tree, const int* values, int len, int sorted) {
+    AVLNodePool kept = tree->pool;
+    avl_pool_init(&tree->pool, kept.nodeSize);
+    AVLNode* root = sorted ? build_sorted(tree, values, len) : build_unsorted(tree, values, len);
+    if (!root && len > 0) {
+        avl_pool_free(&tree->pool);
+        tree->pool = kept;
+        return 0;
+    }
+    avl_pool_free(&kept);
+    tree->root = root;
+    ++tree->version;
+    ++tree->rebuilds;
+    return 1;
+}
+
+/**
+ * @brief Remove a value from the tree, its node is kept in the pool for later insertions.
+ * @return 1 if the value is removed, 0 if it is not found.
+ */
+int avl_tree_remove_node(AVLTree* tree, int value) {
+    ++tree->version;
+    return remove_node(tree, &tree->root, value);
+}
+
+/**
+ * @brief Replace the tree's content by a copy of another tree's shape, if that shape is balanced.
+ *
+ * Nodes are copied in pre-order with an explicit stack, then heights are computed in reverse
+ * creation order, which visits children before their parent. Both passes take O(n).
+ * @param root Root of the tree to copy, whose values must be strictly increasing in order.
+ * @param len Number of values of [root], which for a binary tree is its number of nodes.
+ * @return 1 if the copy is a valid AVL tree, otherwise 0 and the tree is left empty.
+ */
+int avl_tree_import_shape(AVLTree* tree, const void* root, const BTNodeAccessor* accessor, int len) {
+    avl_tree_clear(tree);
+    const void** sources = (const void**)malloc(sizeof(void*) * (len ? len : 1));
+    AVLNode*** links = (AVLNode***)malloc(sizeof(AVLNode**) * (len ? len : 1));
+    AVLNode** created = (AVLNode**)malloc(sizeof(AVLNode*) * (len ? len : 1));
+    int balanced = sources && links && created && (root ? len > 0 : len == 0);
+
+    int count = 0;
+    int depth = 0;
+    if (balanced && root) {
+        sources[depth] = root;
+        links[depth++] = &tree->root;
+    }
+    while (balanced && depth) {
+        --depth;
+        const void* source = sources[depth];
+        AVLNode* node = create_node(tree, accessor->value(source, accessor->context));
+        if (!node) {
+            balanced = 0;
+            break;
+        }
+        *links[depth] = node;
+        created[count++] = node;
+
+        // Created and pending nodes together never outnumber the tree's [len] nodes.
+        const void* left = accessor->left(source, accessor->context);
+        const void* right = accessor->right(source, accessor->context);
+        if (count + depth + (left != NULL) + (right != NULL) > len) {
+            balanced = 0;
+            break;
+        }
+        if (left) {
+            sources[depth] = left;
+            links[depth++] = &node->left;
+        }
+        if (right) {
+            sources[depth] = right;
+            links[depth++] = &node->right;
+        }
+    }
+
+    // Nodes the accessor does not reach as left or right children, e.g. keys of multi-key nodes, are missing.
+    balanced = balanced && count == len;
+    for (int i = count - 1; balanced && i >= 0; --i) {
+        update_node(tree, created[i]);
+        int balanceFactor = get_balance_factor(created[i]);
+        balanced = balanceFactor >= -1 && balanceFactor <= 1;
+    }
+
+    free(sources);
+    free(links);
+    free(created);
+    if (!balanced) {
+        avl_tree_clear(tree);
+    }
+    return balanced;
+}
+
+/**
+ * @brief Remove multiple values from the tree, their nodes are kept in the pool.
+ *
+ * Batches of at least [rebuildPercent] of the tree rebuild it, see remove_batch.
+ * @return Number of values removed.
+ */
+int avl_tree_remove_nodes(AVLTree* tree, const int* values, const int len) {
+    ++tree->version;
+    return remove_batch(tree, &tree->root, values, len, tree->rebuildPercent);
+}
+
+/**
+ * @brief Remove all nodes by releasing the pool's pages, without visiting the nodes.
+ */
+void avl_tree_clear(AVLTree* tree) {
+    avl_pool_free(&tree->pool);
+    tree->root = NULL;
+    ++tree->version;
+    ++tree->rebuilds;
+}
+
+/**
+ * @brief Find the node holding a value.
+ * @param root The tree's root.
+ * @param value Value to look for.
+ * @return The node, or null if the value is not in the tree.
+ */
+AVLNode* avl_find_node(AVLNode* root, int value) {
+    AVLNode* node = avl_lower_bound(root, value);
+    return node && node->value == value ? node : NULL;
+}
+
+/**
+ * @return 1 if the value is in the tree, otherwise 0.
+ */
+int avl_contains(AVLNode* root, int value) {
+    return avl_find_node(root, value) != NULL;
+}
+
+/**
+ * @brief Find the node holding the smallest value which is not less than [value].
+ *
+ * The descent always runs down to a leaf without testing for equality, so each step only
+ * selects the next child and the last candidate, which compiles to conditional moves.
+ * @return The node, or null if all values are less than [value].
+ */
+AVLNode* avl_lower_bound(AVLNode* root, int value) {
+    AVLNode* candidate = NULL;
+    AVLNode* node = root;
+    while (node) {
+        int goLeft = value <= node->value;
+        candidate = goLeft ? node : candidate;
+        node = goLeft ? node->left : node->right;
+    }
+    return candidate;
+}
+
+/**
+ * @brief Find the node holding the smallest value which is greater than [value].
+ * @return The node, or null if no value is greater than [value].
+ */
+AVLNode* avl_upper_bound(AVLNode* root, int value) {
+    AVLNode* candidate = NULL;
+    AVLNode* node = root;
+    while (node) {
+        int goLeft = value < node->value;
+        candidate = goLeft ? node : candidate;
+        node = goLeft ? node->left : node->right;
+    }
+    return candidate;
+}
+
+/**
+ * @brief Find nodes of many values at once.
+ *
+ * Lookups are processed in groups, each step advances every lookup of the group by one level
+ * and prefetches the next node, so memory latency of one lookup is hidden behind the others.
+ * @param root The tree's root.
+ * @param values Values to look for.
+ * @param len Number of values.
+ * @param results Output array of [len] nodes, null for values not in the tree.
+ */
+void avl_find_nodes(AVLNode* root, const int* values, const int len, AVLNode** results) {
+    AVLNode* nodes[FIND_BATCH_LANES];
+    AVLNode* candidates[FIND_BATCH_LANES];
+    for (int start = 0; start < len; start += FIND_BATCH_LANES) {
+        const int* keys = values + start;
+        int lanes = len - start < FIND_BATCH_LANES ? len - start : FIND_BATCH_LANES;
+        for (int i = 0; i < lanes; ++i) {
+            nodes[i] = root;
+            candidates[i] = NULL;
+        }
+
+        int active = root ? lanes : 0;
+        while (active) {
+            active = 0;
+            for (int i = 0; i < lanes; ++i) {
+                AVLNode* node = nodes[i];
+                if (!node) {
+                    continue;
+                }
+                int goLeft = keys[i] <= node->value;
+                candidates[i] = goLeft ? node : candidates[i];
+                node = goLeft ? node->left : node->right;
+                AVL_PREFETCH(node);
+                nodes[i] = node;
+                active += node != NULL;
+            }
+        }
+
+        for (int i = 0; i < lanes; ++i) {
+            results[start + i] = candidates[i] && candidates[i]->value == keys[i] ? candidates[i] : NULL;
+        }
+    }
+}
+
+/**
+ * @brief Count values in the tree which are less than [value], in O(log n).
+ * @return The count, or -1 if the tree does not maintain AVL_AUGMENT_AGGREGATES.
+ */
+int avl_tree_rank(AVLTree* tree, int value) {
+    if (!(tree->augments & AVL_AUGMENT_AGGREGATES)) {
+        return -1;
+    }
+    int count = 0;
+    long long sum = 0;
+    sum_below(tree->root, value, 0, &count, &sum);
+    return count;
+}
+
+/**
+ * @brief Find the node holding the [index]-th smallest value, counting from zero, in O(log n).
+ * @return The node, or null if the index is out of range or the tree does not maintain AVL_AUGMENT_AGGREGATES.
+ */
+AVLNode* avl_tree_select(AVLTree* tree, int index) {
+    if (!(tree->augments & AVL_AUGMENT_AGGREGATES)) {
+        return NULL;
+    }
+    AVLNode* node = tree->root;
+    while (node) {
+        int leftCount = node->left ? avl_aggregate(node->left)->count : 0;
+        if (index < leftCount) {
+            node = node->left;
+        } else if (index > leftCount) {
+            index -= leftCount + 1;
+            node = node->right;
+        } else {
+            return node;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Count values within [low, high] in O(log n).
+ * @return The count, or -1 if the tree does not maintain AVL_AUGMENT_AGGREGATES.
+ */
+int avl_tree_count_range(AVLTree* tree, int low, int high) {
+    if (!(tree->augments & AVL_AUGMENT_AGGREGATES)) {
+        return -1;
+    }
+    if (low > high) {
+        return 0;
+    }
+    int lowCount = 0, highCount = 0;
+    long long lowSum = 0, highSum = 0;
+    sum_below(tree->root, low, 0, &lowCount, &lowSum);
+    sum_below(tree->root, high, 1, &highCount, &highSum);
+    return highCount - lowCount;
+}
+
+/**
+ * @brief Sum values within [low, high] in O(log n).
+ * @return The sum, or zero if the tree does not maintain AVL_AUGMENT_AGGREGATES.
+ */
+long long avl_tree_range_sum(AVLTree* tree, int low, int high) {
+    if (!(tree->augments & AVL_AUGMENT_AGGREGATES) || low > high) {
+        return 0;
+    }
+    int lowCount = 0, highCount = 0;
+    long long lowSum = 0, highSum = 0;
+    sum_below(tree->root, low, 0, &lowCount, &lowSum);
+    sum_below(tree->root, high, 1, &highCount, &highSum);
+    return highSum - lowSum;
+}
+
+/**
+ * @brief Accumulate count and sum of values less than [value], or not greater than it if [inclusive].
+ *
+ * Whenever the descent goes right, the current node and its whole left subtree are below [value].
+ */
+void sum_below(AVLNode* root, int value, int inclusive, int* count, long long* sum) {
+    AVLNode* node = root;
+    while (node) {
+        if (node->value < value || (inclusive && node->value == value)) {
+            *count += 1;
+            *sum += node->value;
+            if (node->left) {
+                *count += avl_aggregate(node->left)->count;
+                *sum += avl_aggregate(node->left)->sum;
+            }
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+}
+
+#pragma region Intervals
+
+/**
+ * @brief Insert the interval [low, high], keyed by its low end.
+ *
+ * Only one interval can start at each value. The new high end can only raise the largest
+ * high ends on the path to the interval's node, so they are raised on a second descent.
+ * @return 1 if the interval is inserted, 0 if its low end is taken, low > high, or the tree
+ * does not maintain AVL_AUGMENT_INTERVALS.
+ */
+int avl_tree_insert_interval(AVLTree* tree, int low, int high) {
+    if (!(tree->augments & AVL_AUGMENT_INTERVALS) || low > high || !avl_tree_insert_node(tree, low)) {
+        return 0;
+    }
+    AVLNode* node = tree->root;
+    while (node->value != low) {
+        if (avl_interval(tree, node)->maxHigh < high) {
+            avl_interval(tree, node)->maxHigh = high;
+        }
+        node = low < node->value ? node->left : node->right;
+    }
+    avl_interval(tree, node)->high = high;
+    if (avl_interval(tree, node)->maxHigh < high) {
+        avl_interval(tree, node)->maxHigh = high;
+    }
+    return 1;
+}
+
+/**
+ * @brief Visit every interval containing [point], in order of their low ends.
+ * @ref avl_tree_overlap
+ * @return Number of intervals visited, or -1 if the tree does not maintain AVL_AUGMENT_INTERVALS.
+ */
+int avl_tree_stab(AVLTree* tree, int point, void (*visit)(int low, int high, void* context), void* context) {
+    return avl_tree_overlap(tree, point, point, visit, context);
+}
+
+/**
+ * @brief Visit every interval overlapping [low, high], in order of their low ends.
+ *
+ * The in-order walk skips subtrees whose largest high end is below [low], and stops at the
+ * first interval starting after [high]. Queries without result take O(log n), and each reported
+ * interval costs O(log n) at most, usually much less as reported intervals are close together.
+ * @return Number of intervals visited, or -1 if the tree does not maintain AVL_AUGMENT_INTERVALS.
+ */
+int avl_tree_overlap(AVLTree* tree, int low, int high, void (*visit)(int low, int high, void* context), void* context) {
+    if (!(tree->augments & AVL_AUGMENT_INTERVALS)) {
+        return -1;
+    }
+    // AVL trees are never deeper than a path can be without heap storage.
+    AVLNode* stack[PATH_INLINE_DEPTH];
+    int depth = 0;
+    int visited = 0;
+    AVLNode* node = low <= high ? tree->root : NULL;
+    while (node || depth) {
+        while (node && avl_interval(tree, node)->maxHigh >= low) {
+            stack[depth++] = node;
+            node = node->left;
+        }
+        if (!depth) {
+            break;
+        }
+        node = stack[--depth];
+        count_comparison(tree);
+        if (node->value > high) {
+            break;
+        }
+        int nodeHigh = avl_interval(tree, node)->high;
+        if (nodeHigh >= low) {
+            visit(node->value, nodeHigh, context);
+            ++visited;
+        }
+        node = node->right;
+    }
+    return visited;
+}
+
+/**
+ * @brief Callbacks letting the BTBox renderer draw the intervals of the tree's nodes as "[low, high]".
+ *
+ * Pass the tree's root as the root node. Valid until the tree changes.
+ */
+BTNodeAccessor avl_tree_interval_accessor(AVLTree* tree) {
+    BTNodeAccessor accessor = {
+        get_interval_left, get_interval_right, get_interval_value, tree,
+        NULL, NULL, NULL, 0, get_interval_high,
+    };
+    return accessor;
+}
+
+const void* get_interval_left(const void* node, const void* context) {
+    return ((const AVLNode*)node)->left;
+}
+
+const void* get_interval_right(const void* node, const void* context) {
+    return ((const AVLNode*)node)->right;
+}
+
+int get_interval_value(const void* node, const void* context) {
+    return ((const AVLNode*)node)->value;
+}
+
+int get_interval_high(const void* node, const void* context) {
+    return avl_interval((const AVLTree*)context, (AVLNode*)node)->high;
+}
+
+#pragma endregion
+
+#pragma region Set Operations
+
+/**
+ * @brief Join two trees with a node in between, in O(|h(left) - h(right)| + 1).
+ *
+ * All values of [left] must be less than the node's, and all values of [right] greater.
+ * The lower tree is attached to the higher one's spine where heights match, then the
+ * spine is rebalanced. Nodes must belong to [tree], or to the heap if [tree] is null.
+ * @return Root of the joined tree.
+ */
+AVLNode* avl_tree_join(AVLTree* tree, AVLNode* left, AVLNode* node, AVLNode* right) {
+    return join(tree, left, node, right);
+}
+
+/**
+ * @brief Split a tree by [value], in O(log n).
+ *
+ * The tree's nodes are distributed over the two results, nothing is allocated or freed.
+ * Nodes must belong to [tree], or to the heap if [tree] is null.
+ * @param root Root of the tree to split, it is invalid afterwards.
+ * @param left Receives the tree of values less than [value].
+ * @param right Receives the tree of values greater than [value].
+ * @return The node holding [value] detached from both trees, or null if there is none.
+ */
+AVLNode* avl_tree_split(AVLTree* tree, AVLNode* root, int value, AVLNode** left, AVLNode** right) {
+    return split(tree, root, value, left, right);
+}
+
+/**
+ * @brief Add all values of [other] to the tree, taking over its nodes, in O(m log(n/m + 1)).
+ *
+ * Both trees must have the same augmentations. [other] is empty afterwards.
+ * @param threads Number of threads the work may be spread on, 1 to run on the calling thread.
+ * @return 1 on success, 0 if the trees are not compatible.
+ */
+int avl_tree_union(AVLTree* tree, AVLTree* other, int threads) {
+    return merge_trees(tree, other, SET_UNION, threads);
+}
+
+/**
+ * @brief Keep only values which are in [other] too, in O(m log(n/m + 1)).
+ * @ref avl_tree_union
+ */
+int avl_tree_intersection(AVLTree* tree, AVLTree* other, int threads) {
+    return merge_trees(tree, other, SET_INTERSECTION, threads);
+}
+
+/**
+ * @brief Remove all values which are in [other], in O(m log(n/m + 1)).
+ * @ref avl_tree_union
+ */
+int avl_tree_difference(AVLTree* tree, AVLTree* other, int threads) {
+    return merge_trees(tree, other, SET_DIFFERENCE, threads);
+}
+
+/**
+ * @brief Run a set operation between two tree handles, leaving [other] empty.
+ *
+ * The pools are merged first, so that all nodes of the result come from the tree's pool.
+ */
+int merge_trees(AVLTree* tree, AVLTree* other, int operation, int threads) {
+    if (tree == other || tree->augments != other->augments) {
+        return 0;
+    }
+    avl_pool_merge(&tree->pool, &other->pool);
+    AVLNode* otherRoot = other->root;
+    other->root = NULL;
+    ++tree->version;
+    ++other->version;
+
+    NodeChain dropped = { NULL, NULL };
+    tree->root = set_operation(tree, operation, tree->root, otherRoot, threads > 0 ? threads : 1, &dropped);
+    avl_pool_release_list(&tree->pool, dropped.first, dropped.last);
+    return 1;
+}
+
+/**
+ * @brief Combine two trees by splitting one at the other's root and recursing on both sides.
+ *
+ * Sides of big trees run in parallel, one of them on a new thread, each with half of the
+ * thread budget. The recursion is as deep as the trees are high.
+ * @param a Tree whose root splits [b], or the tree to subtract from for SET_DIFFERENCE.
+ * @param dropped Receives nodes which are not part of the result anymore.
+ * @return Root of the result.
+ */
+AVLNode* set_operation(AVLTree* tree, int operation, AVLNode* a, AVLNode* b, int threads, NodeChain* dropped) {
+    if (!a || !b) {
+        if (operation == SET_UNION) {
+            return a ? a : b;
+        }
+        if (operation == SET_DIFFERENCE) {
+            chain_push_tree(dropped, b);
+            return a;
+        }
+        chain_push_tree(dropped, a ? a : b);
+        return NULL;
+    }
+
+    // The difference keeps the structure of [a], so it is [a] which gets split.
+    AVLNode* pivot = operation == SET_DIFFERENCE ? b : a;
+    AVLNode* splitRoot = operation == SET_DIFFERENCE ? a : b;
+    AVLNode* pivotLeft = pivot->left;
+    AVLNode* pivotRight = pivot->right;
+    AVLNode* splitLeft = NULL;
+    AVLNode* splitRight = NULL;
+    AVLNode* found = split(tree, splitRoot, pivot->value, &splitLeft, &splitRight);
+
+    AVLNode* left = NULL;
+    AVLNode* right = NULL;
+    int forked = 0;
+    if (threads > 1 && get_height(a) >= SET_FORK_MIN_HEIGHT && get_height(b) >= SET_FORK_MIN_HEIGHT) {
+        SetTask task;
+        task.tree = *tree;
+        memset(&task.stats, 0, sizeof(BSTStats));
+        task.tree.stats = tree->stats ? &task.stats : NULL;
+        task.operation = operation;
+        task.a = operation == SET_DIFFERENCE ? splitLeft : pivotLeft;
+        task.b = operation == SET_DIFFERENCE ? pivotLeft : splitLeft;
+        task.threads = threads / 2;
+        task.dropped.first = NULL;
+        task.dropped.last = NULL;
+
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, run_set_task, &task) == 0) {
+            right = operation == SET_DIFFERENCE
+                ? set_operation(tree, operation, splitRight, pivotRight, threads - threads / 2, dropped)
+                : set_operation(tree, operation, pivotRight, splitRight, threads - threads / 2, dropped);
+            pthread_join(thread, NULL);
+            left = task.result;
+            chain_append(dropped, &task.dropped);
+            if (tree->stats) {
+                tree->stats->comparisons += task.stats.comparisons;
+                tree->stats->rotations += task.stats.rotations;
+            }
+            forked = 1;
+        }
+    }
+    if (!forked) {
+        if (operation == SET_DIFFERENCE) {
+            left = set_operation(tree, operation, splitLeft, pivotLeft, threads, dropped);
+            right = set_operation(tree, operation, splitRight, pivotRight, threads, dropped);
+        } else {
+            left = set_operation(tree, operation, pivotLeft, splitLeft, threads, dropped);
+            right = set_operation(tree, operation, pivotRight, splitRight, threads, dropped);
+        }
+    }
+
+    switch (operation) {
+        case SET_UNION:
+            // The pivot stays, a duplicate found by the split goes.
+            if (found) {
+                chain_push(dropped, found);
+            }
+            return join(tree, left, pivot, right);
+
+        case SET_INTERSECTION:
+            if (found) {
+                chain_push(dropped, found);
+                return join(tree, left, pivot, right);
+            }
+            chain_push(dropped, pivot);
+            return join_sides(tree, left, right);
+
+        default:
+            // The pivot is from the subtracted tree, the found node has its value.
+            chain_push(dropped, pivot);
+            if (found) {
+                chain_push(dropped, found);
+            }
+            return join_sides(tree, left, right);
+    }
+}
+
+void* run_set_task(void* task) {
+    SetTask* setTask = (SetTask*)task;
+    setTask->result = set_operation(&setTask->tree, setTask->operation, setTask->a, setTask->b, setTask->threads, &setTask->dropped);
+    return NULL;
+}
+
+/**
+ * @brief Join two trees, where all values of [left] are less than those of [right].
+ *
+ * The maximum node of [left] is detached to join them.
+ * @return Root of the joined tree.
+ */
+AVLNode* join_sides(AVLTree* tree, AVLNode* left, AVLNode* right) {
+    if (!left) {
+        return right;
+    }
+    if (!right) {
+        return left;
+    }
+    // Nodes of the right spine are linked back up through their right child, which the joins replace
+    // anyway, so that trees of any depth are handled without a stack.
+    AVLNode* spine = NULL;
+    AVLNode* node = left;
+    while (node->right) {
+        AVLNode* next = node->right;
+        node->right = spine;
+        spine = node;
+        node = next;
+    }
+    // Rebuild the left tree without its maximum from the bottom of the right spine up.
+    AVLNode* rest = node->left;
+    while (spine) {
+        AVLNode* parent = spine;
+        spine = parent->right;
+        rest = join(tree, parent->left, parent, rest);
+    }
+    return join(tree, rest, node, right);
+}
+
+AVLNode* join(AVLTree* tree, AVLNode* left, AVLNode* node, AVLNode* right) {
+    int leftHeight = get_height(left);
+    int rightHeight = get_height(right);
+    if (leftHeight <= rightHeight + 1 && rightHeight <= leftHeight + 1) {
+        node->left = left;
+        node->right = right;
+        update_node(tree, node);
+        return node;
+    }
+
+    // Walk down the higher tree's inner spine to a subtree at most one level higher than the other tree.
+    // Passed nodes are linked back up through the spine child, like in split, so the walk needs no storage.
+    int leftIsHigher = leftHeight > rightHeight;
+    AVLNode* lower = leftIsHigher ? right : left;
+    int lowerHeight = leftIsHigher ? rightHeight : leftHeight;
+    AVLNode* spine = NULL;
+    AVLNode* subtree = leftIsHigher ? left : right;
+    while (get_height(subtree) > lowerHeight + 1) {
+        AVLNode* next = leftIsHigher ? subtree->right : subtree->left;
+        if (leftIsHigher) {
+            subtree->right = spine;
+        } else {
+            subtree->left = spine;
+        }
+        spine = subtree;
+        subtree = next;
+    }
+    node->left = leftIsHigher ? subtree : lower;
+    node->right = leftIsHigher ? lower : subtree;
+    update_node(tree, node);
+
+    // Relink and rebalance bottom-up like rebalance_links. Rotations keep each subtree's top node in place.
+    AVLNode* child = node;
+    int settled = 0;
+    while (spine) {
+        AVLNode* parent = spine;
+        if (leftIsHigher) {
+            spine = parent->right;
+            parent->right = child;
+        } else {
+            spine = parent->left;
+            parent->left = child;
+        }
+        if (!settled) {
+            int oldHeight = parent->height;
+            update_node(tree, parent);
+            balance(tree, parent);
+            settled = parent->height == oldHeight;
+        } else if (tree && tree->augments) {
+            update_augments(tree, parent);
+        }
+        child = parent;
+    }
+    return child;
+}
+
+AVLNode* split(AVLTree* tree, AVLNode* root, int value, AVLNode** left, AVLNode** right) {
+    // Nodes passed on the way down, whose outer subtrees end up on the left or right side. Each is
+    // linked back up through the child it was left by, which the joins replace anyway, so that trees
+    // of any depth are split without a stack.
+    AVLNode* leftParts = NULL;
+    AVLNode* rightParts = NULL;
+    AVLNode* found = NULL;
+    AVLNode* leftTree = NULL;
+    AVLNode* rightTree = NULL;
+
+    AVLNode* node = root;
+    while (node) {
+        count_comparison(tree);
+        if (value < node->value) {
+            AVLNode* next = node->left;
+            node->left = rightParts;
+            rightParts = node;
+            node = next;
+        } else if (value > node->value) {
+            AVLNode* next = node->right;
+            node->right = leftParts;
+            leftParts = node;
+            node = next;
+        } else {
+            found = node;
+            leftTree = node->left;
+            rightTree = node->right;
+            found->left = NULL;
+            found->right = NULL;
+            update_node(tree, found);
+            break;
+        }
+    }
+
+    // Join the parts from the bottom up, trees only get higher so the joins take O(log n) in total.
+    while (leftParts) {
+        AVLNode* part = leftParts;
+        leftParts = part->right;
+        leftTree = join(tree, part->left, part, leftTree);
+    }
+    while (rightParts) {
+        AVLNode* part = rightParts;
+        rightParts = part->left;
+        rightTree = join(tree, rightTree, part, part->right);
+    }
+    *left = leftTree;
+    *right = rightTree;
+    return found;
+}
+
+void chain_push(NodeChain* chain, AVLNode* node) {
+    node->left = chain->first;
+    chain->first = node;
+    if (!chain->last) {
+        chain->last = node;
+    }
+}
+
+/**
+ * @brief Add all nodes of a tree to the chain without recursion, rotating left children up until there are none.
+ */
+void chain_push_tree(NodeChain* chain, AVLNode* root) {
+    AVLNode* node = root;
+    while (node) {
+        AVLNode* right = node->right;
+        if (right) {
+            node->right = right->left;
+            right->left = node;
+            node = right;
+        } else {
+            AVLNode* left = node->left;
+            chain_push(chain, node);
+            node = left;
+        }
+    }
+}
+
+void chain_append(NodeChain* chain, NodeChain* other) {
+    if (!other->first) {
+        return;
+    }
+    if (!chain->first) {
+        *chain = *other;
+        return;
+    }
+    chain->last->left = other->first;
+    chain->last = other->last;
+}
+
+#pragma endregion
+
+#pragma region Cursor
+
+/**
+ * @brief Initialize a cursor on the tree's root, it keeps following the tree as long as it lives.
+ */
+void avl_cursor_init(AVLCursor* cursor, AVLTree* tree) {
+    cursor->tree = tree;
+    cursor->depth = 0;
+    cursor->version = tree->version;
+}
+
+/**
+ * @return The node the cursor is on, or null if its last search missed or the tree changed since.
+ */
+AVLNode* avl_cursor_get(AVLCursor* cursor) {
+    if (cursor->depth == 0 || cursor->version != cursor->tree->version) {
+        return NULL;
+    }
+    return *cursor->links[cursor->depth - 1];
+}
+
+/**
+ * @brief Find a value starting from the cursor's position, and move the cursor there.
+ *
+ * The search climbs only until the value is within the bounds of a visited subtree, so
+ * for a value d ranks away from the previous one it takes O(log d) instead of O(log n).
+ * @return The node holding the value, or null if there is none, then the cursor is where it would be inserted.
+ */
+AVLNode* avl_cursor_find(AVLCursor* cursor, int value) {
+    return cursor_seek(cursor, value);
+}
+
+/**
+ * @brief Insert a value starting from the cursor's position, see avl_cursor_find.
+ *
+ * The cursor is on the value's node afterwards, also if it already existed.
+ * @return 1 if the value is inserted, 0 if it already exists or memory is out.
+ */
+int avl_cursor_insert(AVLCursor* cursor, int value) {
+    if (cursor_seek(cursor, value)) {
+        return 0;
+    }
+    if (cursor->depth == 0) {
+        // The path is deeper than the cursor can record.
+        return avl_tree_insert_node(cursor->tree, value);
+    }
+    AVLNode* node = create_node(cursor->tree, value);
+    if (!node) {
+        return 0;
+    }
+    *cursor->links[cursor->depth - 1] = node;
+    cursor_rebalance(cursor, cursor->depth - 1, cursor->depth - 1, value);
+    return 1;
+}
+
+/**
+ * @brief Remove the node the cursor is on.
+ *
+ * The cursor is then where the removed value would be inserted again, so that
+ * lookups of nearby values still start close.
+ * @return 1 if a node is removed, 0 if the cursor is not on a node.
+ */
+int avl_cursor_remove(AVLCursor* cursor) {
+    AVLNode* node = avl_cursor_get(cursor);
+    if (!node) {
+        return 0;
+    }
+    AVLTree* tree = cursor->tree;
+    int value = node->value;
+    int level = cursor->depth - 1;
+    AVLNode** link = cursor->links[level];
+    if (!node->left) {
+        *link = node->right;
+        release_node(tree, node);
+    } else {
+        // Same as remove_node, the maximum of the left subtree replaces the value.
+        long long low = cursor->low[level];
+        int recorded = cursor_push(cursor, &node->left, low, value);
+        while (recorded && (*cursor->links[cursor->depth - 1])->right) {
+            AVLNode* parent = *cursor->links[cursor->depth - 1];
+            recorded = cursor_push(cursor, &parent->right, parent->value, value);
+        }
+        if (!recorded) {
+            cursor->depth = 0;
+            return avl_tree_remove_node(tree, value);
+        }
+        AVLNode** maxLink = cursor->links[cursor->depth - 1];
+        AVLNode* max = *maxLink;
+        copy_value(tree, node, max);
+        *maxLink = max->left;
+        release_node(tree, max);
+    }
+    // Bounds below the removed node's level relied on its old value.
+    cursor_rebalance(cursor, cursor->depth - 1, level, value);
+    return 1;
+}
+
+/**
+ * @brief Move the cursor to [value] or to the null link where it belongs.
+ *
+ * Each level keeps the exclusive bounds of values its subtree may hold, derived from the
+ * ancestors, so that climbing stops at the first subtree which covers the value. Paths deeper
+ * than AVL_CURSOR_DEPTH, which only trees assembled node by node can have, are searched
+ * without recording them, and the cursor is then on no position.
+ */
+AVLNode* cursor_seek(AVLCursor* cursor, int value) {
+    AVLTree* tree = cursor->tree;
+    if (cursor->depth == 0 || cursor->version != tree->version) {
+        cursor->depth = 0;
+        cursor->version = tree->version;
+        cursor_push(cursor, &tree->root, LLONG_MIN, LLONG_MAX);
+    }
+    while (cursor->depth > 1 && (value <= cursor->low[cursor->depth - 1] || value >= cursor->high[cursor->depth - 1])) {
+        --cursor->depth;
+    }
+
+    int level = cursor->depth - 1;
+    AVLNode* node = *cursor->links[level];
+    while (node) {
+        count_comparison(tree);
+        if (value == node->value) {
+            return node;
+        }
+        level = cursor->depth - 1;
+        int recorded = value < node->value ? cursor_push(cursor, &node->left, cursor->low[level], node->value)
+                                           : cursor_push(cursor, &node->right, node->value, cursor->high[level]);
+        if (!recorded) {
+            cursor->depth = 0;
+            return avl_find_node(node, value);
+        }
+        node = *cursor->links[cursor->depth - 1];
+    }
+    return NULL;
+}
+
+/**
+ * @return 1 if the level is recorded, 0 if the cursor is full.
+ */
+int cursor_push(AVLCursor* cursor, AVLNode** link, long long low, long long high) {
+    if (cursor->depth == AVL_CURSOR_DEPTH) {
+        return 0;
+    }
+    cursor->links[cursor->depth] = link;
+    cursor->low[cursor->depth] = low;
+    cursor->high[cursor->depth] = high;
+    ++cursor->depth;
+    return 1;
+}
+
+/**
+ * @brief Rebalance the first [depth] levels of the cursor after a change below them, then find [value] again.
+ *
+ * Levels above the topmost rotation still hold the same subtrees with the same bounds,
+ * so the search continues from there instead of the root.
+ * @param kept Deepest level whose bounds are still valid after the change.
+ */
+void cursor_rebalance(AVLCursor* cursor, int depth, int kept, int value) {
+    AVLTree* tree = cursor->tree;
+    int rotated = rebalance_links(tree, cursor->links, depth);
+    cursor->depth = (rotated < kept ? rotated : kept) + 1;
+    cursor->version = ++tree->version;
+    cursor_seek(cursor, value);
+}
+
+#pragma endregion
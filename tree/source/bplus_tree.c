@@ -0,0 +1,690 @@
+#include "bplus_tree.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Cache line size, nodes start on a line so that their keys are read with one miss.
+#define NODE_ALIGNMENT 64
+
+// Inner nodes have at least BPLUS_MIN_KEYS + 1 children, so int-sized trees are far less deep.
+#define MAX_DEPTH 32
+
+#pragma region Function Declarations
+static BPlusNode* create_node();
+static int insert_into_leaf(BPlusTree* tree, BPlusNode* leaf, int position, int value, BPlusNode* spare, int* separator);
+static int insert_into_inner(BPlusTree* tree, BPlusNode* node, int index, int key, BPlusNode* child, BPlusNode* spare, int* separator);
+static void fix_underflow(BPlusTree* tree, BPlusNode* parent, int index, int leaf);
+static void merge_children(BPlusNode* parent, int index, int leaf);
+static int compare_ints(const void* a, const void* b);
+
+static void* engine_create(BSTStats* stats);
+static void engine_destroy(void* tree);
+static int engine_insert(void* tree, int value);
+static int engine_remove(void* tree, int value);
+static int engine_contains(void* tree, int value);
+static const void* engine_get_root(void* tree);
+static int engine_build(void* tree, const int* values, int len);
+static int engine_import_shape(void* tree, const void* root, const BTNodeAccessor* accessor, int len);
+static int get_value(const void* node, const void* context);
+static int get_key_count(const void* node, const void* context);
+static int get_key(const void* node, int index, const void* context);
+static const void* get_child(const void* node, int index, const void* context);
+
+static inline void count_comparisons(BPlusTree* tree, int count) {
+    if (tree->stats) {
+        tree->stats->comparisons += count;
+    }
+}
+
+static inline void count_rotation(BPlusTree* tree) {
+    if (tree->stats) {
+        ++tree->stats->rotations;
+    }
+}
+
+/**
+ * @return Index of the child whose subtree may hold [value], the number of keys not greater than it.
+ *
+ * Keys are counted without branches over the node's cache line, which compilers vectorize.
+ */
+static inline int find_child(BPlusTree* tree, const BPlusNode* node, int value) {
+    count_comparisons(tree, node->count);
+    int index = 0;
+    for (int i = 0; i < node->count; ++i) {
+        index += node->keys[i] <= value;
+    }
+    return index;
+}
+
+/**
+ * @return Position of [value] in a leaf, or where it would be inserted, the number of keys less than it.
+ */
+static inline int find_key(BPlusTree* tree, const BPlusNode* leaf, int value) {
+    count_comparisons(tree, leaf->count);
+    int position = 0;
+    for (int i = 0; i < leaf->count; ++i) {
+        position += leaf->keys[i] < value;
+    }
+    return position;
+}
+#pragma endregion
+
+const BSTEngine bst_bplus_engine = {
+    "bplus",
+    engine_create,
+    engine_destroy,
+    engine_insert,
+    engine_remove,
+    engine_contains,
+    engine_get_root,
+    { NULL, NULL, get_value, NULL, get_key_count, get_key, get_child, 1 },
+    engine_build,
+    NULL,
+    NULL,
+    NULL,
+    engine_import_shape,
+};
+
+/**
+ * @brief Initialize an empty tree.
+ * @param stats Counters to write to, or null.
+ */
+void bplus_tree_init(BPlusTree* tree, BSTStats* stats) {
+    tree->root = NULL;
+    tree->height = 0;
+    tree->stats = stats;
+}
+
+/**
+ * @return 1 if the value is in the tree, otherwise 0.
+ */
+int bplus_tree_contains(BPlusTree* tree, int value) {
+    BPlusNode* node = tree->root;
+    if (!node) {
+        return 0;
+    }
+    for (int level = 1; level < tree->height; ++level) {
+        node = node->children[find_child(tree, node, value)];
+    }
+    int position = find_key(tree, node, value);
+    return position < node->count && node->keys[position] == value;
+}
+
+/**
+ * @brief Insert a value, splitting full nodes on the way back up.
+ *
+ * The nodes needed for splits are allocated before the tree is changed, so that running out
+ * of memory leaves the tree as it was.
+ * @return 1 if the value is inserted, 0 if it already exists or memory ran out.
+ */
+int bplus_tree_insert_node(BPlusTree* tree, int value) {
+    if (!tree->root) {
+        BPlusNode* leaf = create_node();
+        if (!leaf) {
+            return 0;
+        }
+        leaf->keys[0] = value;
+        leaf->count = 1;
+        tree->root = leaf;
+        tree->height = 1;
+        return 1;
+    }
+
+    BPlusNode* path[MAX_DEPTH];
+    int indices[MAX_DEPTH];
+    BPlusNode* node = tree->root;
+    for (int level = 0; level + 1 < tree->height; ++level) {
+        path[level] = node;
+        indices[level] = find_child(tree, node, value);
+        node = node->children[indices[level]];
+    }
+    int position = find_key(tree, node, value);
+    if (position < node->count && node->keys[position] == value) {
+        return 0;
+    }
+
+    // Full nodes from the leaf upwards split, with a new root if all of them do.
+    int splits = 0;
+    if (node->count == BPLUS_MAX_KEYS) {
+        splits = 1;
+        while (splits < tree->height && path[tree->height - 1 - splits]->count == BPLUS_MAX_KEYS) {
+            ++splits;
+        }
+    }
+    BPlusNode* spares[MAX_DEPTH + 1];
+    int spareCount = splits + (splits == tree->height);
+    for (int i = 0; i < spareCount; ++i) {
+        spares[i] = create_node();
+        if (!spares[i]) {
+            while (i--) {
+                free(spares[i]);
+            }
+            return 0;
+        }
+    }
+
+    int separator;
+    if (!insert_into_leaf(tree, node, position, value, spares[0], &separator)) {
+        return 1;
+    }
+    BPlusNode* split = spares[0];
+    for (int level = tree->height - 2; level >= 0; --level) {
+        int spareIndex = tree->height - 1 - level;
+        BPlusNode* spare = spareIndex < spareCount ? spares[spareIndex] : NULL;
+        if (!insert_into_inner(tree, path[level], indices[level], separator, split, spare, &separator)) {
+            return 1;
+        }
+        split = spare;
+    }
+
+    // The root split as well.
+    BPlusNode* root = spares[spareCount - 1];
+    root->keys[0] = separator;
+    root->count = 1;
+    root->children[0] = tree->root;
+    root->children[1] = split;
+    tree->root = root;
+    ++tree->height;
+    return 1;
+}
+
+/**
+ * @brief Remove a value, refilling nodes under half full from a sibling or merging them with one.
+ * @return 1 if the value is removed, 0 if it is not found.
+ */
+int bplus_tree_remove_node(BPlusTree* tree, int value) {
+    if (!tree->root) {
+        return 0;
+    }
+    BPlusNode* path[MAX_DEPTH];
+    int indices[MAX_DEPTH];
+    BPlusNode* node = tree->root;
+    for (int level = 0; level + 1 < tree->height; ++level) {
+        path[level] = node;
+        indices[level] = find_child(tree, node, value);
+        node = node->children[indices[level]];
+    }
+    int position = find_key(tree, node, value);
+    if (position == node->count || node->keys[position] != value) {
+        return 0;
+    }
+    memmove(node->keys + position, node->keys + position + 1, sizeof(int) * (node->count - position - 1));
+    --node->count;
+
+    // Separators equal to the removed value still route correctly, they are left as they are.
+    for (int level = tree->height - 2; level >= 0 && node->count < BPLUS_MIN_KEYS; --level) {
+        fix_underflow(tree, path[level], indices[level], level == tree->height - 2);
+        node = path[level];
+    }
+
+    BPlusNode* root = tree->root;
+    if (root->count == 0) {
+        tree->root = tree->height > 1 ? root->children[0] : NULL;
+        --tree->height;
+        free(root);
+    }
+    return 1;
+}
+
+/**
+ * @brief Replace the content by values in any order, with duplicates, loading leaves and levels bottom-up.
+ *
+ * Nodes of each level are filled evenly, so all of them are at least half full.
+ * @return 1 if succeeded, 0 if memory ran out and the tree is unchanged.
+ */
+int bplus_tree_build(BPlusTree* tree, const int* values, int len) {
+    int* sorted = (int*)malloc(sizeof(int) * (len ? len : 1));
+    if (!sorted) {
+        return 0;
+    }
+    if (len > 0) {
+        memcpy(sorted, values, sizeof(int) * len);
+        qsort(sorted, len, sizeof(int), compare_ints);
+    }
+    int unique = len > 0 ? 1 : 0;
+    for (int i = 1; i < len; ++i) {
+        if (sorted[i] != sorted[unique - 1]) {
+            sorted[unique++] = sorted[i];
+        }
+    }
+
+    // Count the nodes first, so that all of them are allocated before the old tree is dropped.
+    int total = 0;
+    int height = 0;
+    for (int count = (unique + BPLUS_MAX_KEYS - 1) / BPLUS_MAX_KEYS; count > 0; count = count > 1 ? (count + BPLUS_MAX_KEYS) / (BPLUS_MAX_KEYS + 1) : 0) {
+        total += count;
+        ++height;
+    }
+    BPlusNode** nodes = (BPlusNode**)malloc(sizeof(BPlusNode*) * (total ? total : 1));
+    int* lows = (int*)malloc(sizeof(int) * (total ? total : 1));
+    int created = 0;
+    while (nodes && lows && created < total && (nodes[created] = create_node())) {
+        ++created;
+    }
+    if (created < total) {
+        while (nodes && created--) {
+            free(nodes[created]);
+        }
+        free(nodes);
+        free(lows);
+        free(sorted);
+        return 0;
+    }
+    bplus_tree_clear(tree);
+
+    // Leaves, linked in order.
+    int count = (unique + BPLUS_MAX_KEYS - 1) / BPLUS_MAX_KEYS;
+    int start = 0;
+    for (int i = 0; i < count; ++i) {
+        BPlusNode* leaf = nodes[i];
+        leaf->count = unique / count + (i < unique % count);
+        memcpy(leaf->keys, sorted + start, sizeof(int) * leaf->count);
+        leaf->next = i + 1 < count ? nodes[i + 1] : NULL;
+        lows[i] = sorted[start];
+        start += leaf->count;
+    }
+
+    // Each level above takes the nodes below in groups, keyed by the lowest value under each child.
+    int level = 0;
+    while (count > 1) {
+        int parents = (count + BPLUS_MAX_KEYS) / (BPLUS_MAX_KEYS + 1);
+        int child = level;
+        for (int i = 0; i < parents; ++i) {
+            BPlusNode* parent = nodes[level + count + i];
+            int children = count / parents + (i < count % parents);
+            parent->count = children - 1;
+            for (int k = 0; k < children; ++k) {
+                parent->children[k] = nodes[child + k];
+                if (k) {
+                    parent->keys[k - 1] = lows[child + k];
+                }
+            }
+            lows[level + count + i] = lows[child];
+            child += children;
+        }
+        level += count;
+        count = parents;
+    }
+
+    tree->root = total ? nodes[total - 1] : NULL;
+    tree->height = height;
+    free(nodes);
+    free(lows);
+    free(sorted);
+    return 1;
+}
+
+/**
+ * @brief Replace the content by a copy of another B+tree's shape, e.g. one restored from a file.
+ *
+ * The shape is kept if all leaves are equally deep and every node but the root is at least half
+ * full, as nodes of this tree always are. Nodes are copied in pre-order with an explicit stack,
+ * leaves are linked in the order they are reached.
+ * @param root Root of the tree to copy, read through [accessor] which marks inner keys as routing
+ * keys. Its leaves' keys must be strictly increasing, with each routing key fitting between them.
+ * @param len Number of values of [root], the keys of its leaves.
+ * @return 1 if the copy is a valid B+tree, otherwise 0 and the tree is left empty.
+ */
+int bplus_tree_import_shape(BPlusTree* tree, const void* root, const BTNodeAccessor* accessor, int len) {
+    bplus_tree_clear(tree);
+    if (!root || !accessor->key_count || !accessor->leafValues) {
+        return !root && len == 0;
+    }
+
+    // Sources on the path from the root with their copies, and the next child to copy, -1 before the node itself.
+    const void* sources[MAX_DEPTH];
+    BPlusNode* copies[MAX_DEPTH];
+    int next[MAX_DEPTH];
+    BPlusNode** created = NULL;
+    BPlusNode* lastLeaf = NULL;
+    int total = 0;
+    int capacity = 0;
+    int height = 0;
+    int values = 0;
+    int valid = 1;
+    int depth = 1;
+    sources[0] = root;
+    next[0] = -1;
+    while (depth && valid) {
+        const void* source = sources[depth - 1];
+        int count = accessor->key_count(source, accessor->context);
+        if (next[depth - 1] < 0) {
+            if (count < 1 || count > BPLUS_MAX_KEYS || (depth > 1 && count < BPLUS_MIN_KEYS)) {
+                valid = 0;
+                break;
+            }
+            if (total == capacity) {
+                capacity = capacity ? capacity * 2 : 64;
+                BPlusNode** grown = (BPlusNode**)realloc(created, sizeof(BPlusNode*) * capacity);
+                if (!grown) {
+                    valid = 0;
+                    break;
+                }
+                created = grown;
+            }
+            BPlusNode* node = create_node();
+            if (!node) {
+                valid = 0;
+                break;
+            }
+            created[total++] = node;
+            node->count = count;
+            for (int i = 0; i < count; ++i) {
+                node->keys[i] = accessor->key(source, i, accessor->context);
+            }
+            if (depth > 1) {
+                copies[depth - 2]->children[next[depth - 2] - 1] = node;
+            }
+            copies[depth - 1] = node;
+            next[depth - 1] = 0;
+
+            if (!accessor->child(source, 0, accessor->context)) {
+                valid = height == 0 || height == depth;
+                height = depth;
+                values += count;
+                if (lastLeaf) {
+                    lastLeaf->next = node;
+                }
+                lastLeaf = node;
+                --depth;
+                continue;
+            }
+        }
+        if (next[depth - 1] > count) {
+            --depth;
+            continue;
+        }
+        const void* child = accessor->child(source, next[depth - 1]++, accessor->context);
+        if (!child || depth == MAX_DEPTH) {
+            valid = 0;
+            break;
+        }
+        sources[depth] = child;
+        next[depth++] = -1;
+    }
+
+    valid = valid && values == len;
+    if (valid) {
+        tree->root = created[0];
+        tree->height = height;
+    } else {
+        for (int i = 0; i < total; ++i) {
+            free(created[i]);
+        }
+    }
+    free(created);
+    return valid;
+}
+
+/**
+ * @brief Visit values from [low] to [high] in ascending order, following the leaves' links.
+ * @return Number of values visited.
+ */
+int bplus_tree_range(BPlusTree* tree, int low, int high, void (*visit)(int value, void* context), void* context) {
+    BPlusNode* node = tree->root;
+    if (!node || low > high) {
+        return 0;
+    }
+    for (int level = 1; level < tree->height; ++level) {
+        node = node->children[find_child(tree, node, low)];
+    }
+    int visited = 0;
+    for (int i = find_key(tree, node, low); node; node = node->next, i = 0) {
+        for (; i < node->count; ++i) {
+            if (node->keys[i] > high) {
+                return visited;
+            }
+            visit(node->keys[i], context);
+            ++visited;
+        }
+    }
+    return visited;
+}
+
+/**
+ * @brief Delete all nodes with an explicit stack, the tree is empty afterwards.
+ */
+void bplus_tree_clear(BPlusTree* tree) {
+    BPlusNode* path[MAX_DEPTH];
+    int next[MAX_DEPTH];
+    int depth = 0;
+    if (tree->root) {
+        path[0] = tree->root;
+        next[0] = 0;
+        depth = 1;
+    }
+    while (depth) {
+        BPlusNode* node = path[depth - 1];
+        if (depth == tree->height || next[depth - 1] > node->count) {
+            free(node);
+            --depth;
+            continue;
+        }
+        path[depth] = node->children[next[depth - 1]++];
+        next[depth++] = 0;
+    }
+    tree->root = NULL;
+    tree->height = 0;
+}
+
+/**
+ * @return A node without keys or children, aligned to a cache line, or null if out of memory.
+ */
+BPlusNode* create_node() {
+    size_t size = (sizeof(BPlusNode) + NODE_ALIGNMENT - 1) / NODE_ALIGNMENT * NODE_ALIGNMENT;
+    BPlusNode* node = (BPlusNode*)aligned_alloc(NODE_ALIGNMENT, size);
+    if (node) {
+        node->count = 0;
+        memset(node->children, 0, sizeof(node->children));
+        node->next = NULL;
+    }
+    return node;
+}
+
+/**
+ * @brief Insert a value into a leaf, splitting it into [spare] if it is full.
+ * @param separator Set to the lowest value of [spare] if the leaf split.
+ * @return 1 if the leaf split, otherwise 0.
+ */
+int insert_into_leaf(BPlusTree* tree, BPlusNode* leaf, int position, int value, BPlusNode* spare, int* separator) {
+    if (leaf->count < BPLUS_MAX_KEYS) {
+        memmove(leaf->keys + position + 1, leaf->keys + position, sizeof(int) * (leaf->count - position));
+        leaf->keys[position] = value;
+        ++leaf->count;
+        return 0;
+    }
+
+    int keys[BPLUS_MAX_KEYS + 1];
+    memcpy(keys, leaf->keys, sizeof(int) * position);
+    keys[position] = value;
+    memcpy(keys + position + 1, leaf->keys + position, sizeof(int) * (BPLUS_MAX_KEYS - position));
+
+    int half = (BPLUS_MAX_KEYS + 1) / 2;
+    leaf->count = half;
+    memcpy(leaf->keys, keys, sizeof(int) * half);
+    spare->count = BPLUS_MAX_KEYS + 1 - half;
+    memcpy(spare->keys, keys + half, sizeof(int) * spare->count);
+    spare->next = leaf->next;
+    leaf->next = spare;
+    *separator = spare->keys[0];
+    count_rotation(tree);
+    return 1;
+}
+
+/**
+ * @brief Insert a key with the child right of it into an inner node, splitting it into [spare] if it is full.
+ * @param index Index of the child which split into itself and [child].
+ * @param separator Set to the key moving up to the parent if the node split.
+ * @return 1 if the node split, otherwise 0.
+ */
+int insert_into_inner(BPlusTree* tree, BPlusNode* node, int index, int key, BPlusNode* child, BPlusNode* spare, int* separator) {
+    if (node->count < BPLUS_MAX_KEYS) {
+        memmove(node->keys + index + 1, node->keys + index, sizeof(int) * (node->count - index));
+        memmove(node->children + index + 2, node->children + index + 1, sizeof(BPlusNode*) * (node->count - index));
+        node->keys[index] = key;
+        node->children[index + 1] = child;
+        ++node->count;
+        return 0;
+    }
+
+    int keys[BPLUS_MAX_KEYS + 1];
+    BPlusNode* children[BPLUS_MAX_KEYS + 2];
+    memcpy(keys, node->keys, sizeof(int) * index);
+    keys[index] = key;
+    memcpy(keys + index + 1, node->keys + index, sizeof(int) * (BPLUS_MAX_KEYS - index));
+    memcpy(children, node->children, sizeof(BPlusNode*) * (index + 1));
+    children[index + 1] = child;
+    memcpy(children + index + 2, node->children + index + 1, sizeof(BPlusNode*) * (BPLUS_MAX_KEYS - index));
+
+    // The middle key moves up, the keys around it stay in the two halves.
+    int half = (BPLUS_MAX_KEYS + 1) / 2;
+    node->count = half;
+    memcpy(node->keys, keys, sizeof(int) * half);
+    memcpy(node->children, children, sizeof(BPlusNode*) * (half + 1));
+    memset(node->children + half + 1, 0, sizeof(BPlusNode*) * (BPLUS_MAX_KEYS - half));
+    spare->count = BPLUS_MAX_KEYS - half;
+    memcpy(spare->keys, keys + half + 1, sizeof(int) * spare->count);
+    memcpy(spare->children, children + half + 1, sizeof(BPlusNode*) * (spare->count + 1));
+    *separator = keys[half];
+    count_rotation(tree);
+    return 1;
+}
+
+/**
+ * @brief Refill the child at [index] which fell under half full, from a sibling or by merging with one.
+ * @param leaf Nonzero if the children are leaves.
+ */
+void fix_underflow(BPlusTree* tree, BPlusNode* parent, int index, int leaf) {
+    BPlusNode* node = parent->children[index];
+    BPlusNode* left = index > 0 ? parent->children[index - 1] : NULL;
+    BPlusNode* right = index < parent->count ? parent->children[index + 1] : NULL;
+    count_rotation(tree);
+
+    if (left && left->count > BPLUS_MIN_KEYS) {
+        // Move the left sibling's last key over, through the parent for inner nodes.
+        memmove(node->keys + 1, node->keys, sizeof(int) * node->count);
+        if (leaf) {
+            node->keys[0] = left->keys[left->count - 1];
+            parent->keys[index - 1] = node->keys[0];
+        } else {
+            memmove(node->children + 1, node->children, sizeof(BPlusNode*) * (node->count + 1));
+            node->keys[0] = parent->keys[index - 1];
+            node->children[0] = left->children[left->count];
+            left->children[left->count] = NULL;
+            parent->keys[index - 1] = left->keys[left->count - 1];
+        }
+        ++node->count;
+        --left->count;
+        return;
+    }
+
+    if (right && right->count > BPLUS_MIN_KEYS) {
+        // Move the right sibling's first key over.
+        if (leaf) {
+            node->keys[node->count] = right->keys[0];
+            memmove(right->keys, right->keys + 1, sizeof(int) * (right->count - 1));
+            parent->keys[index] = right->keys[0];
+        } else {
+            node->keys[node->count] = parent->keys[index];
+            node->children[node->count + 1] = right->children[0];
+            parent->keys[index] = right->keys[0];
+            memmove(right->keys, right->keys + 1, sizeof(int) * (right->count - 1));
+            memmove(right->children, right->children + 1, sizeof(BPlusNode*) * right->count);
+            right->children[right->count] = NULL;
+        }
+        ++node->count;
+        --right->count;
+        return;
+    }
+
+    merge_children(parent, left ? index - 1 : index, leaf);
+}
+
+/**
+ * @brief Merge the child right of key [index] into the child left of it, removing the key from the parent.
+ * @param leaf Nonzero if the children are leaves.
+ */
+void merge_children(BPlusNode* parent, int index, int leaf) {
+    BPlusNode* left = parent->children[index];
+    BPlusNode* right = parent->children[index + 1];
+    if (leaf) {
+        memcpy(left->keys + left->count, right->keys, sizeof(int) * right->count);
+        left->count += right->count;
+        left->next = right->next;
+    } else {
+        // The parent's key comes down between the two halves.
+        left->keys[left->count] = parent->keys[index];
+        memcpy(left->keys + left->count + 1, right->keys, sizeof(int) * right->count);
+        memcpy(left->children + left->count + 1, right->children, sizeof(BPlusNode*) * (right->count + 1));
+        left->count += right->count + 1;
+    }
+    free(right);
+
+    memmove(parent->keys + index, parent->keys + index + 1, sizeof(int) * (parent->count - index - 1));
+    memmove(parent->children + index + 1, parent->children + index + 2, sizeof(BPlusNode*) * (parent->count - index - 1));
+    parent->children[parent->count] = NULL;
+    --parent->count;
+}
+
+int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+#pragma region Engine
+
+void* engine_create(BSTStats* stats) {
+    BPlusTree* tree = (BPlusTree*)malloc(sizeof(BPlusTree));
+    if (tree) {
+        bplus_tree_init(tree, stats);
+    }
+    return tree;
+}
+
+void engine_destroy(void* tree) {
+    bplus_tree_clear((BPlusTree*)tree);
+    free(tree);
+}
+
+int engine_insert(void* tree, int value) {
+    return bplus_tree_insert_node((BPlusTree*)tree, value);
+}
+
+int engine_remove(void* tree, int value) {
+    return bplus_tree_remove_node((BPlusTree*)tree, value);
+}
+
+int engine_contains(void* tree, int value) {
+    return bplus_tree_contains((BPlusTree*)tree, value);
+}
+
+const void* engine_get_root(void* tree) {
+    return ((BPlusTree*)tree)->root;
+}
+
+int engine_build(void* tree, const int* values, int len) {
+    return bplus_tree_build((BPlusTree*)tree, values, len);
+}
+
+int engine_import_shape(void* tree, const void* root, const BTNodeAccessor* accessor, int len) {
+    return bplus_tree_import_shape((BPlusTree*)tree, root, accessor, len);
+}
+
+int get_value(const void* node, const void* context) {
+    return ((const BPlusNode*)node)->keys[0];
+}
+
+int get_key_count(const void* node, const void* context) {
+    return ((const BPlusNode*)node)->count;
+}
+
+int get_key(const void* node, int index, const void* context) {
+    return ((const BPlusNode*)node)->keys[index];
+}
+
+const void* get_child(const void* node, int index, const void* context) {
+    return ((const BPlusNode*)node)->children[index];
+}
+
+#pragma endregion
@@ -0,0 +1,630 @@
+#include "bst_engine.h"
+#include "avl_tree.h"
+#include "avl_buffer.h"
+#include "bplus_tree.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Depth of an in-order walk kept without heap allocation.
+#define WALK_INLINE_DEPTH 64
+
+#pragma region Function Declarations
+static void* avl_engine_create(BSTStats* stats);
+static void avl_engine_destroy(void* tree);
+static int avl_engine_insert(void* tree, int value);
+static int avl_engine_remove(void* tree, int value);
+static int avl_engine_contains(void* tree, int value);
+static const void* avl_engine_get_root(void* tree);
+static int avl_engine_build(void* tree, const int* values, int len);
+static void avl_engine_find_values(void* tree, const int* values, int len, int* found);
+static void avl_engine_insert_values(void* tree, const int* values, int len);
+static int avl_engine_remove_values(void* tree, const int* values, int len);
+static int avl_engine_import_shape(void* tree, const void* root, const BTNodeAccessor* accessor, int len);
+static unsigned avl_engine_get_rebuilds(void* tree);
+static const void* get_avl_left(const void* node, const void* context);
+static const void* get_avl_right(const void* node, const void* context);
+static int get_avl_value(const void* node, const void* context);
+
+static int walk_in_order(const void* root, const BTNodeAccessor* accessor, void (*visit)(int value, void* context), void* context);
+static int walk_keys_in_order(const void* root, const BTNodeAccessor* accessor, void (*visit)(int value, void* context), void (*route)(int key, void* context), void* context);
+static void count_value(int value, void* context);
+static void forget_boxes(BSTree* tree);
+static void collect_value(int value, void* context);
+static void append_value(int value, void* context);
+static void check_route(int key, void* context);
+
+/**
+ * @brief Multi-key node on the path of an in-order walk, with the step to take next.
+ */
+typedef struct WalkFrame {
+    const void* node;
+
+    // Even steps 2i descend into child i, odd steps 2i + 1 visit key i.
+    int step;
+} WalkFrame;
+
+/**
+ * @brief Values of an imported tree in the order they are found.
+ */
+typedef struct ImportedValues {
+    int* values;
+    int len;
+    int capacity;
+
+    // Cleared once a value is not greater than the one before.
+    int ordered;
+
+    // Set if memory ran out.
+    int failed;
+
+    // Set after a routing key of a B+tree, which the next value must not be less than.
+    int routed;
+    int route;
+} ImportedValues;
+#pragma endregion
+
+const BSTEngine bst_avl_engine = {
+    "avl",
+    avl_engine_create,
+    avl_engine_destroy,
+    avl_engine_insert,
+    avl_engine_remove,
+    avl_engine_contains,
+    avl_engine_get_root,
+    { get_avl_left, get_avl_right, get_avl_value, NULL },
+    avl_engine_build,
+    avl_engine_find_values,
+    avl_engine_insert_values,
+    avl_engine_remove_values,
+    avl_engine_import_shape,
+    0,
+    avl_engine_get_rebuilds,
+};
+
+static const BSTEngine* const ENGINES[] = {
+    &bst_avl_engine,
+    &bst_rb_engine,
+    &bst_treap_engine,
+    &bst_splay_engine,
+    &bst_wavl_engine,
+    &bst_buffered_engine,
+    &bst_bplus_engine,
+};
+
+/**
+ * @return The engine with the given name, or null if there is none.
+ */
+const BSTEngine* bst_find_engine(const char* name) {
+    for (int i = 0; i < (int)(sizeof(ENGINES) / sizeof(ENGINES[0])); ++i) {
+        if (strcmp(ENGINES[i]->name, name) == 0) {
+            return ENGINES[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief List available engines, starting from index 0.
+ * @return The engine at [index], or null past the last one.
+ */
+const BSTEngine* bst_get_engine(int index) {
+    return index >= 0 && index < (int)(sizeof(ENGINES) / sizeof(ENGINES[0])) ? ENGINES[index] : NULL;
+}
+
+/**
+ * @brief Initialize an empty tree balanced by [engine], with counters at zero.
+ * @return 1 if succeeded, 0 if out of memory.
+ */
+int bst_init(BSTree* tree, const BSTEngine* engine) {
+    memset(&tree->stats, 0, sizeof(BSTStats));
+    tree->boxedRebuilds = 0;
+    tree->engine = engine;
+    tree->impl = engine->create(&tree->stats);
+    return tree->impl != NULL;
+}
+
+/**
+ * @brief Delete all nodes, the tree must be initialized again to be used.
+ */
+void bst_free_tree(BSTree* tree) {
+    if (tree->impl) {
+        tree->engine->destroy(tree->impl);
+        tree->impl = NULL;
+    }
+}
+
+/**
+ * @brief Move the tree's values to a new tree balanced by another engine.
+ * @return 1 if succeeded, 0 if out of memory, then the tree is unchanged.
+ */
+int bst_switch_engine(BSTree* tree, const BSTEngine* engine) {
+    int len = bst_count_nodes(tree);
+    int* values = (int*)malloc(sizeof(int) * (len ? len : 1));
+    void* impl = engine->create(&tree->stats);
+    if (!values || !impl) {
+        free(values);
+        if (impl) {
+            engine->destroy(impl);
+        }
+        return 0;
+    }
+    bst_collect_values(tree, values);
+
+    // The old tree stays until the new one holds all values.
+    const BSTEngine* oldEngine = tree->engine;
+    void* oldImpl = tree->impl;
+    tree->engine = engine;
+    tree->impl = impl;
+    int built = bst_build(tree, values, len);
+    free(values);
+    if (!built) {
+        engine->destroy(tree->impl);
+        tree->engine = oldEngine;
+        tree->impl = oldImpl;
+        return 0;
+    }
+    oldEngine->destroy(oldImpl);
+    return 1;
+}
+
+/**
+ * @brief Set all counters back to zero.
+ */
+void bst_reset_stats(BSTree* tree) {
+    memset(&tree->stats, 0, sizeof(BSTStats));
+}
+
+/**
+ * @return 1 if the value is inserted, 0 if it already exists.
+ */
+int bst_insert_node(BSTree* tree, int value) {
+    return tree->engine->insert(tree->impl, value);
+}
+
+/**
+ * @brief Insert multiple values to the tree, at once if the engine can, otherwise in the given order.
+ */
+void bst_insert_nodes(BSTree* tree, const int* values, const int len) {
+    if (tree->engine->insert_values) {
+        tree->engine->insert_values(tree->impl, values, len);
+        return;
+    }
+    for (int i = 0; i < len; ++i) {
+        tree->engine->insert(tree->impl, values[i]);
+    }
+}
+
+/**
+ * @return 1 if the value is removed, 0 if it is not found.
+ */
+int bst_remove_node(BSTree* tree, int value) {
+    return tree->engine->remove(tree->impl, value);
+}
+
+/**
+ * @brief Remove multiple values from the tree, at once if the engine can.
+ * @return Number of values removed.
+ */
+int bst_remove_nodes(BSTree* tree, const int* values, const int len) {
+    if (tree->engine->remove_values) {
+        return tree->engine->remove_values(tree->impl, values, len);
+    }
+    int removed = 0;
+    for (int i = 0; i < len; ++i) {
+        removed += tree->engine->remove(tree->impl, values[i]);
+    }
+    return removed;
+}
+
+/**
+ * @return 1 if the value is in the tree, otherwise 0.
+ */
+int bst_contains(BSTree* tree, int value) {
+    return tree->engine->contains(tree->impl, value);
+}
+
+/**
+ * @brief Look up many values at once, with the engine's batched lookup if it has one.
+ * @param found Output array of [len] flags, 1 for values in the tree.
+ */
+void bst_find_values(BSTree* tree, const int* values, const int len, int* found) {
+    if (tree->engine->find_values) {
+        tree->engine->find_values(tree->impl, values, len, found);
+        return;
+    }
+    for (int i = 0; i < len; ++i) {
+        found[i] = tree->engine->contains(tree->impl, values[i]);
+    }
+}
+
+/**
+ * @brief Replace the tree's content by values in any order, duplicates are dropped.
+ *
+ * Engines without a bulk build get the values inserted one by one into a new tree, which replaces
+ * the old one once it holds all values.
+ * @return 1 if succeeded, 0 if out of memory, then the tree is unchanged.
+ */
+int bst_build(BSTree* tree, const int* values, const int len) {
+    if (tree->engine->build) {
+        if (!tree->engine->build(tree->impl, values, len)) {
+            return 0;
+        }
+    } else {
+        void* impl = tree->engine->create(&tree->stats);
+        if (!impl) {
+            return 0;
+        }
+        // Insertions report 0 for duplicates and when memory runs out, which only a lookup tells apart.
+        for (int i = 0; i < len; ++i) {
+            if (!tree->engine->insert(impl, values[i]) && !tree->engine->contains(impl, values[i])) {
+                tree->engine->destroy(impl);
+                return 0;
+            }
+        }
+        tree->engine->destroy(tree->impl);
+        tree->impl = impl;
+    }
+    forget_boxes(tree);
+    return 1;
+}
+
+/**
+ * @brief Replace the tree's content by the values of another tree, e.g. one read from a file.
+ *
+ * One in-order pass collects the values and checks that they are in BST order. Ordered trees
+ * keep their shape if asked and the engine accepts it, otherwise they are rebuilt balanced.
+ * Values out of order are sorted and deduplicated first.
+ * @param keepShape Nonzero to keep the shape of [root] if it is valid for the engine.
+ * @return BST_IMPORT_* telling how the tree was imported, the tree is unchanged on BST_IMPORT_FAILED.
+ */
+int bst_import(BSTree* tree, const void* root, const BTNodeAccessor* accessor, int keepShape) {
+    ImportedValues imported = { NULL, 0, 0, 1, 0, 0, 0 };
+    if (!walk_in_order(root, accessor, append_value, &imported) || imported.failed) {
+        free(imported.values);
+        return BST_IMPORT_FAILED;
+    }
+
+    // Inner nodes of B+trees repeat values as routing keys, e.g. in a diagram restored from a file.
+    // Read the tree so if only its leaves are in order, with each routing key fitting between them.
+    BTNodeAccessor routed;
+    if (!imported.ordered && accessor->key_count && !accessor->leafValues) {
+        routed = *accessor;
+        routed.leafValues = 1;
+        ImportedValues leaves = { NULL, 0, 0, 1, 0, 0, 0 };
+        if (walk_keys_in_order(root, &routed, append_value, check_route, &leaves) && !leaves.failed && leaves.ordered) {
+            free(imported.values);
+            imported = leaves;
+            accessor = &routed;
+        } else {
+            free(leaves.values);
+        }
+    }
+
+    int result = imported.ordered ? BST_IMPORT_REBUILT : BST_IMPORT_UNORDERED;
+    if (imported.ordered && keepShape && tree->engine->import_shape && accessor->left
+        && tree->engine->import_shape(tree->impl, root, accessor, imported.len)) {
+        result = BST_IMPORT_SHAPE_KEPT;
+        forget_boxes(tree);
+    } else if (!bst_build(tree, imported.values, imported.len)) {
+        result = BST_IMPORT_FAILED;
+    }
+    free(imported.values);
+    return result;
+}
+
+/**
+ * @return Root node of the engine's tree, to be read through the engine's accessor.
+ */
+const void* bst_get_root(BSTree* tree) {
+    return tree->engine->get_root(tree->impl);
+}
+
+/**
+ * @brief Visit all values in ascending order, without recursion so that degenerate trees are fine.
+ */
+void bst_for_each(BSTree* tree, void (*visit)(int value, void* context), void* context) {
+    walk_in_order(bst_get_root(tree), &tree->engine->accessor, visit, context);
+}
+
+/**
+ * @brief Visit values of any tree in order, with an explicit stack.
+ * @return 1 if all nodes were visited, 0 if memory for the stack ran out.
+ */
+int walk_in_order(const void* root, const BTNodeAccessor* accessor, void (*visit)(int value, void* context), void* context) {
+    if (accessor->key_count) {
+        return walk_keys_in_order(root, accessor, visit, NULL, context);
+    }
+    const void* inlineStack[WALK_INLINE_DEPTH];
+    const void** stack = inlineStack;
+    int capacity = WALK_INLINE_DEPTH;
+    int depth = 0;
+    int complete = 0;
+
+    const void* node = root;
+    while (node || depth) {
+        while (node) {
+            if (depth == capacity) {
+                const void** grown = (const void**)malloc(sizeof(void*) * capacity * 2);
+                if (!grown) {
+                    goto clean_up;
+                }
+                memcpy(grown, stack, sizeof(void*) * depth);
+                if (stack != inlineStack) {
+                    free(stack);
+                }
+                stack = grown;
+                capacity *= 2;
+            }
+            stack[depth++] = node;
+            node = accessor->left(node, accessor->context);
+        }
+        node = stack[--depth];
+        visit(accessor->value(node, accessor->context), context);
+        node = accessor->right(node, accessor->context);
+    }
+    complete = 1;
+
+clean_up:
+    if (stack != inlineStack) {
+        free(stack);
+    }
+    return complete;
+}
+
+/**
+ * @brief Visit values of a tree read through the multi-key callbacks of [accessor], with an explicit stack.
+ *
+ * Keys of inner nodes are skipped if the accessor marks them as routing keys.
+ * @param route Optional, visits the skipped routing keys in order.
+ * @return 1 if all nodes were visited, 0 if memory for the stack ran out.
+ */
+int walk_keys_in_order(const void* root, const BTNodeAccessor* accessor, void (*visit)(int value, void* context), void (*route)(int key, void* context), void* context) {
+    WalkFrame inlineStack[WALK_INLINE_DEPTH];
+    WalkFrame* stack = inlineStack;
+    int capacity = WALK_INLINE_DEPTH;
+    int depth = 0;
+    if (root) {
+        stack[depth].node = root;
+        stack[depth++].step = 0;
+    }
+
+    while (depth) {
+        const void* node = stack[depth - 1].node;
+        int step = stack[depth - 1].step++;
+        if (step > 2 * accessor->key_count(node, accessor->context)) {
+            --depth;
+            continue;
+        }
+        if (step % 2) {
+            if (!accessor->leafValues || !accessor->child(node, 0, accessor->context)) {
+                visit(accessor->key(node, step / 2, accessor->context), context);
+            } else if (route) {
+                route(accessor->key(node, step / 2, accessor->context), context);
+            }
+            continue;
+        }
+
+        const void* child = accessor->child(node, step / 2, accessor->context);
+        if (!child) {
+            continue;
+        }
+        if (depth == capacity) {
+            WalkFrame* grown = (WalkFrame*)malloc(sizeof(WalkFrame) * capacity * 2);
+            if (!grown) {
+                if (stack != inlineStack) {
+                    free(stack);
+                }
+                return 0;
+            }
+            memcpy(grown, stack, sizeof(WalkFrame) * depth);
+            if (stack != inlineStack) {
+                free(stack);
+            }
+            stack = grown;
+            capacity *= 2;
+        }
+        stack[depth].node = child;
+        stack[depth++].step = 0;
+    }
+
+    if (stack != inlineStack) {
+        free(stack);
+    }
+    return 1;
+}
+
+/**
+ * @return Number of values in the tree.
+ */
+int bst_count_nodes(BSTree* tree) {
+    int count = 0;
+    bst_for_each(tree, count_value, &count);
+    return count;
+}
+
+/**
+ * @brief Write the tree's values in ascending order.
+ * @param values Output array, must have room for all values.
+ * @return Number of values written.
+ */
+int bst_collect_values(BSTree* tree, int* values) {
+    int* end = values;
+    bst_for_each(tree, collect_value, &end);
+    return (int)(end - values);
+}
+
+/**
+ * @brief Construct the BTBox tree to print, reading the engine's nodes directly.
+ * @return The box tree, or null if the tree is empty.
+ */
+BTBox* bst_create_box(BSTree* tree) {
+    const void* root = bst_get_root(tree);
+    tree->boxedRebuilds = tree->engine->get_rebuilds ? tree->engine->get_rebuilds(tree->impl) : 0;
+    return btbox_create_tree_with(root, &tree->engine->accessor);
+}
+
+/**
+ * @brief Print the tree reading the engine's nodes in place, without keeping boxes.
+ * @ref btbox_print_with
+ */
+void bst_print(FILE* file, BSTree* tree) {
+    btbox_print_with(file, bst_get_root(tree), &tree->engine->accessor);
+}
+
+/**
+ * @brief Update boxes created by bst_create_box after [values] were inserted, removed or looked up.
+ * @ref btbox_update_tree_with
+ * @param box Boxes of the tree before the change, reused or freed. Null to create them.
+ * @return Boxes of the tree, or null if it is empty.
+ */
+BTBox* bst_update_box(BSTree* tree, BTBox* box, const int* values, const int len) {
+    // Reading the root first lets engines apply pending changes, which may rebuild the tree.
+    const void* root = bst_get_root(tree);
+    unsigned rebuilds = tree->engine->get_rebuilds ? tree->engine->get_rebuilds(tree->impl) : 0;
+    if (tree->engine->reshapesAnywhere || rebuilds != tree->boxedRebuilds) {
+        btbox_free_tree(box);
+        return bst_create_box(tree);
+    }
+    return btbox_update_tree_with(box, root, &tree->engine->accessor, values, len);
+}
+
+/**
+ * @brief Make the next bst_update_box create the boxes again, after the whole content was replaced.
+ */
+void forget_boxes(BSTree* tree) {
+    tree->boxedRebuilds = (tree->engine->get_rebuilds ? tree->engine->get_rebuilds(tree->impl) : 0) - 1;
+}
+
+void count_value(int value, void* context) {
+    ++*(int*)context;
+}
+
+void collect_value(int value, void* context) {
+    int** end = (int**)context;
+    *(*end)++ = value;
+}
+
+void append_value(int value, void* context) {
+    ImportedValues* imported = (ImportedValues*)context;
+    if (imported->failed) {
+        return;
+    }
+    if (imported->len == imported->capacity) {
+        int capacity = imported->capacity ? imported->capacity * 2 : 64;
+        int* values = (int*)realloc(imported->values, sizeof(int) * capacity);
+        if (!values) {
+            imported->failed = 1;
+            return;
+        }
+        imported->values = values;
+        imported->capacity = capacity;
+    }
+    if ((imported->len > 0 && value <= imported->values[imported->len - 1]) || (imported->routed && value < imported->route)) {
+        imported->ordered = 0;
+    }
+    imported->routed = 0;
+    imported->values[imported->len++] = value;
+}
+
+/**
+ * @brief Check that a routing key is greater than the values before it, and not greater than those after it.
+ */
+void check_route(int key, void* context) {
+    ImportedValues* imported = (ImportedValues*)context;
+    if ((imported->len > 0 && key <= imported->values[imported->len - 1]) || (imported->routed && key < imported->route)) {
+        imported->ordered = 0;
+    }
+    imported->routed = 1;
+    imported->route = key;
+}
+
+#pragma region AVL Engine
+
+void* avl_engine_create(BSTStats* stats) {
+    AVLTree* tree = (AVLTree*)malloc(sizeof(AVLTree));
+    if (tree) {
+        avl_tree_init(tree);
+        tree->stats = stats;
+    }
+    return tree;
+}
+
+void avl_engine_destroy(void* tree) {
+    avl_tree_clear((AVLTree*)tree);
+    free(tree);
+}
+
+int avl_engine_insert(void* tree, int value) {
+    return avl_tree_insert_node((AVLTree*)tree, value);
+}
+
+int avl_engine_remove(void* tree, int value) {
+    return avl_tree_remove_node((AVLTree*)tree, value);
+}
+
+int avl_engine_contains(void* tree, int value) {
+    AVLTree* avlTree = (AVLTree*)tree;
+    AVLNode* node = avlTree->root;
+    while (node) {
+        ++avlTree->stats->comparisons;
+        if (value == node->value) {
+            return 1;
+        }
+        node = value < node->value ? node->left : node->right;
+    }
+    return 0;
+}
+
+const void* avl_engine_get_root(void* tree) {
+    return ((AVLTree*)tree)->root;
+}
+
+int avl_engine_build(void* tree, const int* values, int len) {
+    return avl_tree_build((AVLTree*)tree, values, len);
+}
+
+void avl_engine_insert_values(void* tree, const int* values, int len) {
+    avl_tree_insert_nodes((AVLTree*)tree, values, len);
+}
+
+int avl_engine_remove_values(void* tree, const int* values, int len) {
+    return avl_tree_remove_nodes((AVLTree*)tree, values, len);
+}
+
+int avl_engine_import_shape(void* tree, const void* root, const BTNodeAccessor* accessor, int len) {
+    return avl_tree_import_shape((AVLTree*)tree, root, accessor, len);
+}
+
+unsigned avl_engine_get_rebuilds(void* tree) {
+    return ((AVLTree*)tree)->rebuilds;
+}
+
+void avl_engine_find_values(void* tree, const int* values, int len, int* found) {
+    AVLNode** nodes = (AVLNode**)malloc(sizeof(AVLNode*) * (len ? len : 1));
+    if (!nodes) {
+        for (int i = 0; i < len; ++i) {
+            found[i] = avl_engine_contains(tree, values[i]);
+        }
+        return;
+    }
+    avl_find_nodes(((AVLTree*)tree)->root, values, len, nodes);
+    for (int i = 0; i < len; ++i) {
+        found[i] = nodes[i] != NULL;
+    }
+    free(nodes);
+}
+
+const void* get_avl_left(const void* node, const void* context) {
+    return ((const AVLNode*)node)->left;
+}
+
+const void* get_avl_right(const void* node, const void* context) {
+    return ((const AVLNode*)node)->right;
+}
+
+int get_avl_value(const void* node, const void* context) {
+    return ((const AVLNode*)node)->value;
+}
+
+#pragma endregion
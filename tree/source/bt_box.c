@@ -2,6 +2,7 @@
 #include "bstbox_utils.h"
 #include "bstbox_input.h"
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,6 +13,7 @@
 #define BOX_V_MARGIN 1
 #define BOX_H_MARGIN 2
 #define ARM_MIN_WIDTH 3
+#define LEVEL_HEIGHT (BOX_HEIGHT + BOX_V_MARGIN)
 
 // ASCII
 #define LINE_HORZ_2 '_'
@@ -43,6 +45,92 @@ typedef struct BTBoxRestoredNode {
     int rightChild; // 0 for having no right child, 1 otherwise
 } BTBoxRestoredNode;
 
+/**
+ * @brief A node to be printed on the current level, with its position from the printing origin.
+ */
+typedef struct LevelEntry {
+    BTBox* node;
+    BTBox* parent;
+    int x;
+} LevelEntry;
+
+/**
+ * @brief A node of the changed tree whose box is relinked by btbox_update_tree_with.
+ */
+typedef struct BoxUpdate {
+    const void* node;
+    // Box of the same value before the change, or a new one.
+    BTBox* box;
+    // Index of the parent's update, or -1 for the root, and the side of the node under it.
+    int parent;
+    int isRight;
+    // Set if the box's whole subtree is kept as it is.
+    int kept;
+    // Set if the box did not exist before the change.
+    int created;
+    // Exclusive bounds of the values in the node's subtree.
+    long long low;
+    long long high;
+} BoxUpdate;
+
+/**
+ * @brief Measures of a placed subtree which its parent's placement depends on.
+ */
+typedef struct BoxExtent {
+    int boxX;
+    int boxWidth;
+    int width;
+    int height;
+} BoxExtent;
+
+/**
+ * @brief Layout of a binary tree kept in flat arrays, one slot per node in post-order.
+ *
+ * Children come before their parent and the root is the last slot, so the tree is measured in
+ * the same forward sweep that reads it. Children are linked by index, -1 for none.
+ */
+typedef struct FlatLayout {
+    int count;
+    int isInterval;
+    int* value;
+    int* high;
+    int* left;
+    int* right;
+    int* width;
+    int* height;
+    int* boxX;
+    int* boxWidth;
+    int* rightOffset;
+} FlatLayout;
+
+/**
+ * @brief A slot of a flat layout to be printed on the current level, with its position from the printing origin.
+ */
+typedef struct FlatLevelEntry {
+    int index;
+    int hasParent;
+    int x;
+} FlatLevelEntry;
+
+/**
+ * @brief A node waiting on a walk's stack, with the links its box goes to if the walk creates boxes.
+ */
+typedef struct WalkEntry {
+    const void* node;
+    BTBox** link;
+    // Second link to the same box, e.g. the first child of a multi-key node is also its left one. May be null.
+    BTBox** alsoLink;
+} WalkEntry;
+
+/**
+ * @brief Stack growing on the heap, so that trees of any depth are walked without recursion.
+ */
+typedef struct WalkStack {
+    WalkEntry* entries;
+    int depth;
+    int capacity;
+} WalkStack;
+
 typedef struct LinkedListEntry {
     BTBoxRestoredNode *data;
     struct LinkedListEntry *next;
@@ -110,7 +198,7 @@ static void linkedlist_free(LinkedListEntry *list) {
     LinkedListEntry *curr = list;
     while (curr != NULL) {
         LinkedListEntry *next = curr->next;
-        free(curr->data->node);
+        btbox_free_node(curr->data->node);
         free(curr->data);
         free(curr);
         curr = next;
@@ -118,35 +206,114 @@ static void linkedlist_free(LinkedListEntry *list) {
 }
 
 #pragma region Function Declarations
-static void measure(BTBox* node);
-static void print_buffer(char** buffer, int x, int y, BTBox* parent, BTBox* node);
-static void print_arm(char** buffer, int x, int y, BTBox* parent, BTBox* child);
-static void print_box(char** buffer, int x, int y, BTBox* parent, BTBox* node);
+static int measure(BTBox* root);
+static void measure_node(BTBox* node);
+static void measure_keys(BTBox* node);
+static int get_label_width(BTBox* node);
+static void print_label(char* out, BTBox* node);
+static void print_arm(char* line, int row, int x, BTBox* parent, BTBox* child);
+static void print_inner_arm(char* line, int row, int x, BTBox* parent, int index);
+static void print_box(char* line, int row, int x, BTBox* parent, BTBox* node);
 static int get_box_center_x(BTBox* node, int offset);
+static int get_separator_x(BTBox* node, int index);
+
+static BTBox* create_box(const void* node, const BTNodeAccessor* accessor);
+static void free_box(BTBox* box);
+static void free_boxes_by_rotation(BTBox* box);
+static void free_nodes_by_rotation(BTNode* node);
+static BTBox* find_box(BTBox* root, int value);
+static int is_same_node(BTBox* box, const void* node, const BTNodeAccessor* accessor);
+static int find_neighbors(const void* node, const BTNodeAccessor* accessor, int value, long long* lower, long long* upper);
+static int is_near_changes(long long low, long long high, const long long* lowers, const long long* uppers, int len);
+static int compare_ints(const void* a, const void* b);
+static int count_nodes(const void* tree, const BTNodeAccessor* accessor);
+static int walk_push(WalkStack* stack, const void* node, BTBox** link, BTBox** alsoLink);
+static void walk_free(WalkStack* stack);
+static void place_box(const BoxExtent* left, const BoxExtent* right, BoxExtent* node, int* rightOffset);
+static int create_flat_layout(FlatLayout* layout, const void* tree, const BTNodeAccessor* accessor);
+static void free_flat_layout(FlatLayout* layout);
+static void print_flat_layout(FILE* file, const FlatLayout* layout);
+static BTBox get_flat_box(const FlatLayout* layout, int index);
 
 static int search_arm(char *line, int len, int start, int step);
 static BTBoxRestoredNode* create_restore_node();
 static LinkedListEntry* restore_nodes(FILE *file);
 static BTBoxRestoredNode* find_root_node(FILE *file);
 static void parse_child_nodes(BTBoxRestoredNode* rootInfo, FILE* file);
+static LinkedListEntry* attach_children(BTBoxRestoredNode* parent, LinkedListEntry* child);
+static int is_same_box(const char* buffer, int end, int start);
+static void prepend_key(BTNode* node, int key);
+
+static const void* get_bt_left(const void* node, const void* context) {
+    return ((const BTNode*)node)->left;
+}
+
+static const void* get_bt_right(const void* node, const void* context) {
+    return ((const BTNode*)node)->right;
+}
+
+static int get_bt_value(const void* node, const void* context) {
+    return ((const BTNode*)node)->value;
+}
+
+static int get_bt_key_count(const void* node, const void* context) {
+    const BTNode* btNode = (const BTNode*)node;
+    return btNode->keyCount > 1 ? btNode->keyCount : 1;
+}
+
+static int get_bt_key(const void* node, int index, const void* context) {
+    const BTNode* btNode = (const BTNode*)node;
+    return btNode->keyCount > 1 ? btNode->keys[index] : btNode->value;
+}
+
+static const void* get_bt_child(const void* node, int index, const void* context) {
+    const BTNode* btNode = (const BTNode*)node;
+    if (btNode->keyCount > 1) {
+        return btNode->children ? btNode->children[index] : NULL;
+    }
+    return index == 0 ? btNode->left : btNode->right;
+}
 
 // Return width of the node, or zero if node is null.
 static inline int get_width(BTBox* node) {
     return node ? node->width : 0;
 }
 
-// Return height of the node, or zero if node is null.
-static inline int get_height(BTBox* node) {
-    return node ? node->height : 0;
+// Return the measures of a box that its parent is placed by.
+static inline BoxExtent get_extent(BTBox* node) {
+    BoxExtent extent;
+    extent.boxX = node->boxX;
+    extent.boxWidth = node->boxWidth;
+    extent.width = node->width;
+    extent.height = node->height;
+    return extent;
+}
+
+// Return the measures of a slot of a flat layout that its parent is placed by.
+static inline BoxExtent get_flat_extent(const FlatLayout* layout, int index) {
+    BoxExtent extent;
+    extent.boxX = layout->boxX[index];
+    extent.boxWidth = layout->boxWidth[index];
+    extent.width = layout->width[index];
+    extent.height = layout->height[index];
+    return extent;
 }
 
 #pragma endregion
 
+const BTNodeAccessor btbox_node_accessor = {
+    get_bt_left, get_bt_right, get_bt_value, NULL,
+    get_bt_key_count, get_bt_key, get_bt_child, 0,
+};
+
 BTNode* btbox_create_node(int value) {
     BTNode *node = (BTNode*)malloc(sizeof(BTNode));
     node->value = value;
     node->left = NULL;
     node->right = NULL;
+    node->keyCount = 0;
+    node->keys = NULL;
+    node->children = NULL;
     return node;
 }
 
@@ -154,132 +321,788 @@ BTNode* btbox_create_node(int value) {
  * @brief Construct the BSTBox node based on the binary tree hierarchy.
  */
 BTBox* btbox_create_tree(BTNode* tree) {
+    return btbox_create_tree_with(tree, &btbox_node_accessor);
+}
+
+/**
+ * @brief Construct the BSTBox node based on a tree of any type.
+ * @param tree Root node of the tree, read through [accessor].
+ * @param accessor Callbacks reading children and values of the tree's nodes, or keys of multi-key nodes.
+ */
+BTBox* btbox_create_tree_with(const void* tree, const BTNodeAccessor* accessor) {
+    BTBox* root = NULL;
+    WalkStack stack = { NULL, 0, 0 };
+    int failed = tree && !walk_push(&stack, tree, &root, NULL);
+    while (stack.depth && !failed) {
+        WalkEntry entry = stack.entries[--stack.depth];
+        const void* node = entry.node;
+        BTBox* box = (BTBox*)malloc(sizeof(BTBox));
+        if (!box) {
+            failed = 1;
+            break;
+        }
+        box->left = NULL;
+        box->right = NULL;
+        box->keyCount = accessor->key_count ? accessor->key_count(node, accessor->context) : 1;
+        box->keys = NULL;
+        box->children = NULL;
+        box->childOffsets = NULL;
+        box->isInterval = accessor->high != NULL;
+        box->high = box->isInterval ? accessor->high(node, accessor->context) : 0;
+        box->dirty = 1;
+        *entry.link = box;
+        if (entry.alsoLink) {
+            *entry.alsoLink = box;
+        }
+
+        // Children are pushed right to left, so boxes are created in pre-order.
+        if (box->keyCount == 1) {
+            box->value = accessor->key_count ? accessor->key(node, 0, accessor->context) : accessor->value(node, accessor->context);
+            const void* left = accessor->key_count ? accessor->child(node, 0, accessor->context) : accessor->left(node, accessor->context);
+            const void* right = accessor->key_count ? accessor->child(node, 1, accessor->context) : accessor->right(node, accessor->context);
+            failed = (right && !walk_push(&stack, right, &box->right, NULL)) || (left && !walk_push(&stack, left, &box->left, NULL));
+            continue;
+        }
+
+        box->keys = (int*)malloc(sizeof(int) * box->keyCount);
+        box->children = (BTBox**)calloc(box->keyCount + 1, sizeof(BTBox*));
+        box->childOffsets = (int*)malloc(sizeof(int) * (box->keyCount + 1));
+        if (!box->keys || !box->children || !box->childOffsets) {
+            // Only binary boxes are freed by their parent while multi-key ones are incomplete.
+            box->keyCount = 1;
+            failed = 1;
+            break;
+        }
+        for (int i = 0; i < box->keyCount; ++i) {
+            box->keys[i] = accessor->key(node, i, accessor->context);
+        }
+        box->value = box->keys[0];
+        for (int i = box->keyCount; i >= 0 && !failed; --i) {
+            const void* child = accessor->child(node, i, accessor->context);
+            BTBox** alsoLink = i == 0 ? &box->left : (i == box->keyCount ? &box->right : NULL);
+            failed = child && !walk_push(&stack, child, &box->children[i], alsoLink);
+        }
+    }
+    walk_free(&stack);
+    if (failed) {
+        btbox_free_tree(root);
+        return NULL;
+    }
+    return root;
+}
+
+/**
+ * @brief Update the boxes of a tree after [values] were inserted, removed or looked up, e.g. by a splay tree.
+ *
+ * Only nodes whose range of values reaches a changed value's nearest neighbors are visited, which
+ * covers the paths that insertions, removals and their rotations touch. A subtree hanging off these
+ * paths keeps its boxes and measures if its root has the same value and children as before, otherwise
+ * it is checked the same way one level down. Other boxes are looked up by value and relinked, keeping
+ * their value strings, so after a single change only O(log n) nodes are measured again.
+ * Trees with multi-key nodes are created again.
+ * @param box Boxes of the tree before the change, reused or freed. Null to create them.
+ * @param tree Root node of the tree after the change.
+ * @param values Values which changed, in any order.
+ * @return Boxes of the tree.
+ */
+BTBox* btbox_update_tree_with(BTBox* box, const void* tree, const BTNodeAccessor* accessor, const int* values, int len) {
+    if (!box || !tree || accessor->key_count) {
+        btbox_free_tree(box);
+        return btbox_create_tree_with(tree, accessor);
+    }
+    int capacity = 64;
+    int* sorted = (int*)malloc(sizeof(int) * (len ? len : 1));
+    long long* lowers = (long long*)malloc(sizeof(long long) * (len ? len : 1));
+    long long* uppers = (long long*)malloc(sizeof(long long) * (len ? len : 1));
+    BTBox** removed = (BTBox**)malloc(sizeof(BTBox*) * (len ? len : 1));
+    BoxUpdate* updates = (BoxUpdate*)malloc(sizeof(BoxUpdate) * capacity);
+    int failed = !sorted || !lowers || !uppers || !removed || !updates;
+
+    // Nearest neighbors of each changed value bound the ranges to visit. Boxes of removed values
+    // are found before any box is relinked.
+    int changedLen = 0;
+    int removedLen = 0;
+    if (!failed && len > 0) {
+        memcpy(sorted, values, sizeof(int) * len);
+        qsort(sorted, len, sizeof(int), compare_ints);
+        for (int i = 0; i < len; ++i) {
+            if (i > 0 && sorted[i] == sorted[changedLen - 1]) {
+                continue;
+            }
+            sorted[changedLen] = sorted[i];
+            if (!find_neighbors(tree, accessor, sorted[i], &lowers[changedLen], &uppers[changedLen])) {
+                BTBox* old = find_box(box, sorted[i]);
+                if (old) {
+                    removed[removedLen++] = old;
+                }
+            }
+            ++changedLen;
+        }
+    }
+
+    // Collect the nodes to relink top-down, each one's children after it.
+    int count = 0;
+    for (int i = -1; !failed && i < count; ++i) {
+        if (i >= 0 && updates[i].kept) {
+            continue;
+        }
+        for (int side = 0; side < 2; ++side) {
+            const void* node;
+            BoxUpdate update;
+            if (i < 0) {
+                node = side ? NULL : tree;
+                update.low = LLONG_MIN;
+                update.high = LLONG_MAX;
+            } else {
+                int value = accessor->value(updates[i].node, accessor->context);
+                node = side ? accessor->right(updates[i].node, accessor->context) : accessor->left(updates[i].node, accessor->context);
+                update.low = side ? value : updates[i].low;
+                update.high = side ? updates[i].high : value;
+            }
+            if (!node) {
+                continue;
+            }
+            if (count == capacity) {
+                capacity *= 2;
+                BoxUpdate* grown = (BoxUpdate*)realloc(updates, sizeof(BoxUpdate) * capacity);
+                if (!grown) {
+                    failed = 1;
+                    break;
+                }
+                updates = grown;
+            }
+            update.node = node;
+            update.box = find_box(box, accessor->value(node, accessor->context));
+            update.parent = i;
+            update.isRight = side;
+            update.kept = i >= 0 && update.box && !is_near_changes(update.low, update.high, lowers, uppers, changedLen)
+                && is_same_node(update.box, node, accessor);
+            update.created = !update.box;
+            if (update.created && !(update.box = create_box(node, accessor))) {
+                failed = 1;
+                break;
+            }
+            updates[count++] = update;
+        }
+    }
+
+    BTBox* root = NULL;
+    if (failed) {
+        for (int i = 0; updates && i < count; ++i) {
+            if (updates[i].created) {
+                free_box(updates[i].box);
+            }
+        }
+        btbox_free_tree(box);
+    } else {
+        for (int i = 0; i < count; ++i) {
+            BTBox* node = updates[i].box;
+            if (!updates[i].kept) {
+                int high = node->isInterval ? accessor->high(updates[i].node, accessor->context) : 0;
+                node->high = high;
+                node->left = NULL;
+                node->right = NULL;
+                node->dirty = 1;
+            }
+            if (updates[i].parent < 0) {
+                root = node;
+            } else if (updates[i].isRight) {
+                updates[updates[i].parent].box->right = node;
+            } else {
+                updates[updates[i].parent].box->left = node;
+            }
+        }
+        for (int i = 0; i < removedLen; ++i) {
+            free_box(removed[i]);
+        }
+    }
+
+    free(sorted);
+    free(lowers);
+    free(uppers);
+    free(removed);
+    free(updates);
+    return failed ? btbox_create_tree_with(tree, accessor) : root;
+}
+
+/**
+ * @brief Create the box of a binary node, without children.
+ */
+BTBox* create_box(const void* node, const BTNodeAccessor* accessor) {
     BTBox* box = (BTBox*)malloc(sizeof(BTBox));
-    box->value = tree->value;
-    box->left = tree->left ? btbox_create_tree(tree->left) : NULL;
-    box->right = tree->right ? btbox_create_tree(tree->right) : NULL;
+    if (!box) {
+        return NULL;
+    }
+    box->value = accessor->value(node, accessor->context);
+    box->left = NULL;
+    box->right = NULL;
+    box->keyCount = 1;
+    box->keys = NULL;
+    box->children = NULL;
+    box->childOffsets = NULL;
+    box->isInterval = accessor->high != NULL;
+    box->high = box->isInterval ? accessor->high(node, accessor->context) : 0;
+    box->dirty = 1;
     return box;
 }
 
 /**
- * @brief Delete entire BSTBox tree.
+ * @brief Free one box, leaving its children.
  */
-void btbox_free_tree(BTBox* root) {
-    if (!root) return;
-    btbox_free_tree(root->left);
-    btbox_free_tree(root->right);
-    free(root->valueString);
-    free(root);
+void free_box(BTBox* box) {
+    free(box->keys);
+    free(box->children);
+    free(box->childOffsets);
+    free(box);
 }
 
-void btbox_free_node(BTNode *node) {
-    if (node == NULL) {
-        return;
+/**
+ * @brief Free a tree of boxes without any stack, for when the walk's stack cannot grow.
+ *
+ * Like avl_free_tree, left children are rotated up until the top box has none. Inner children
+ * of multi-key boxes are moved to the empty left link first, so a box is freed once its right
+ * child is its only one, which is taken next.
+ */
+void free_boxes_by_rotation(BTBox* box) {
+    while (box) {
+        for (int i = 1; !box->left && i < box->keyCount; ++i) {
+            box->left = box->children[i];
+            box->children[i] = NULL;
+        }
+        BTBox* left = box->left;
+        if (left) {
+            box->left = left->right;
+            left->right = box;
+            box = left;
+        } else {
+            BTBox* right = box->right;
+            free_box(box);
+            box = right;
+        }
     }
-    if (node->left) {
-        btbox_free_node(node->left);
+}
+
+/**
+ * @brief Free a tree of restored nodes without any stack, see free_boxes_by_rotation.
+ *
+ * Children of multi-key nodes are all in their children array, which is emptied into the left link.
+ */
+void free_nodes_by_rotation(BTNode* node) {
+    while (node) {
+        for (int i = 0; !node->left && node->children && i <= node->keyCount; ++i) {
+            node->left = node->children[i];
+            node->children[i] = NULL;
+        }
+        BTNode* left = node->left;
+        if (left) {
+            node->left = left->right;
+            left->right = node;
+            node = left;
+        } else {
+            BTNode* right = node->right;
+            free(node->keys);
+            free(node->children);
+            free(node);
+            node = right;
+        }
     }
-    if (node->right) {
-        btbox_free_node(node->right);
+}
+
+/**
+ * @return The box of [value] in a tree of binary boxes, or null if there is none.
+ */
+BTBox* find_box(BTBox* root, int value) {
+    while (root && root->value != value) {
+        root = value < root->value ? root->left : root->right;
     }
-    free(node);
+    return root;
 }
 
-void print_box(char** buffer, int x, int y, BTBox* parent, BTBox* node) {
-    int boxStartX = x + node->boxX;
-    int boxEndX = boxStartX + node->boxWidth - 1;
-    int boxStartY = y;
-    int boxEndY = y + BOX_HEIGHT - 1;
-    // 4 box's corners
-    buffer[boxStartY][boxStartX] = BOX_TL_CORNER;
-    buffer[boxStartY][boxEndX] = BOX_TR_CORNER;
-    buffer[boxEndY][boxStartX] = BOX_BL_CORNER;
-    buffer[boxEndY][boxEndX] = BOX_BR_CORNER;
+/**
+ * @return 1 if the box shows the node and its children have the values of the node's children.
+ */
+int is_same_node(BTBox* box, const void* node, const BTNodeAccessor* accessor) {
+    const void* left = accessor->left(node, accessor->context);
+    const void* right = accessor->right(node, accessor->context);
+    return box->value == accessor->value(node, accessor->context)
+        && (!box->isInterval || box->high == accessor->high(node, accessor->context))
+        && (box->left ? left && box->left->value == accessor->value(left, accessor->context) : !left)
+        && (box->right ? right && box->right->value == accessor->value(right, accessor->context) : !right);
+}
 
-    // Draw horizontal lines on top and bottom
-    memset(buffer[y] + boxStartX + BOX_BORDER, BOX_H_LINE, boxEndX - boxStartX - BOX_BORDER);
-    memset(buffer[boxEndY] + boxStartX + BOX_BORDER, BOX_H_LINE, boxEndX - boxStartX - BOX_BORDER);
+/**
+ * @brief Find the greatest value less than [value] and the least value greater than it.
+ * @param lower Receives the lower neighbor, or LLONG_MIN if there is none.
+ * @param upper Receives the upper neighbor, or LLONG_MAX if there is none.
+ * @return 1 if the tree holds [value], otherwise 0.
+ */
+int find_neighbors(const void* node, const BTNodeAccessor* accessor, int value, long long* lower, long long* upper) {
+    *lower = LLONG_MIN;
+    *upper = LLONG_MAX;
+    while (node) {
+        int nodeValue = accessor->value(node, accessor->context);
+        if (nodeValue == value) {
+            for (const void* left = accessor->left(node, accessor->context); left; left = accessor->right(left, accessor->context)) {
+                *lower = accessor->value(left, accessor->context);
+            }
+            for (const void* right = accessor->right(node, accessor->context); right; right = accessor->left(right, accessor->context)) {
+                *upper = accessor->value(right, accessor->context);
+            }
+            return 1;
+        }
+        if (nodeValue < value) {
+            *lower = nodeValue;
+            node = accessor->right(node, accessor->context);
+        } else {
+            *upper = nodeValue;
+            node = accessor->left(node, accessor->context);
+        }
+    }
+    return 0;
+}
 
-    // Draw vertical lines on two sides
-    for (int i = boxStartY + 1; i < boxEndY; ++i) {
-        buffer[i][boxStartX] = BOX_V_LINE;
-        buffer[i][boxEndX] = BOX_V_LINE;
+/**
+ * @brief Tell whether a subtree holding values within (low, high) reaches the neighbors of a changed value.
+ * @param lowers Lower neighbors of the changed values in ascending order, as found by find_neighbors.
+ * @param uppers Upper neighbors of the changed values, in the same order.
+ */
+int is_near_changes(long long low, long long high, const long long* lowers, const long long* uppers, int len) {
+    // Neighbors ascend with the values, so only the first change whose upper neighbor is not below the subtree matters.
+    int first = 0, last = len;
+    while (first < last) {
+        int middle = first + (last - first) / 2;
+        if (uppers[middle] < low) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
     }
+    return first < len && lowers[first] <= high;
+}
 
-    // If the box is a child node, show the connecting point with its parent's arm.
-    if (parent) {
-        buffer[boxStartY][boxStartX + node->boxWidth / 2] = ARM_T_JUNCTION;
+int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Delete entire BSTBox tree.
+ */
+void btbox_free_tree(BTBox* root) {
+    WalkStack stack = { NULL, 0, 0 };
+    BTBox* box = root;
+    while (box) {
+        // Go down the left side, keeping the other children on the stack.
+        BTBox* next = box->left;
+        for (int i = 1; i < box->keyCount; ++i) {
+            if (box->children[i] && !walk_push(&stack, box->children[i], NULL, NULL)) {
+                free_boxes_by_rotation(box->children[i]);
+            }
+        }
+        if (box->right) {
+            if (!next) {
+                next = box->right;
+            } else if (!walk_push(&stack, box->right, NULL, NULL)) {
+                free_boxes_by_rotation(box->right);
+            }
+        }
+        free_box(box);
+        box = next ? next : (stack.depth ? (BTBox*)stack.entries[--stack.depth].node : NULL);
     }
+    walk_free(&stack);
+}
 
-    // Draw the value
-    int valueStartX = boxStartX + BOX_BORDER + BOX_PADDING;
-    int valueY = (boxStartY + boxEndY + 1) / 2;
-    for (int i = 0; i < strlen(node->valueString); ++i) {
-        buffer[valueY][valueStartX + i] = node->valueString[i];
+void btbox_free_node(BTNode *node) {
+    WalkStack stack = { NULL, 0, 0 };
+    while (node) {
+        // Go down the left side, keeping the other children on the stack.
+        BTNode* next = NULL;
+        BTNode* children[2] = { node->left, node->right };
+        for (int i = 0; i < 2; ++i) {
+            if (children[i] && !next) {
+                next = children[i];
+            } else if (children[i] && !walk_push(&stack, children[i], NULL, NULL)) {
+                free_nodes_by_rotation(children[i]);
+            }
+        }
+        for (int i = 0; node->children && i <= node->keyCount; ++i) {
+            if (node->children[i] && !next) {
+                next = node->children[i];
+            } else if (node->children[i] && !walk_push(&stack, node->children[i], NULL, NULL)) {
+                free_nodes_by_rotation(node->children[i]);
+            }
+        }
+        free(node->keys);
+        free(node->children);
+        free(node);
+        node = next ? next : (stack.depth ? (BTNode*)stack.entries[--stack.depth].node : NULL);
     }
+    walk_free(&stack);
 }
 
 /**
- * @brief Draw a node to 2-D buffer.
- * @param buffer 2-D buffer holding drawing characters.
- * @param x Offset x from the origin of the buffer.
- * @param y Offset y from the origin of the buffer.
- * @param node Tree's root to be printed.
- * @param parent Parent node, for additional information while printing.
+ * @brief Draw the part of a node's bounding box which lies on one row of its level.
+ * @param line Line buffer of the row being printed.
+ * @param row Row index counting from the top of the node's level.
+ * @param x Offset x of the node from the printing origin.
+ * @param parent Parent node, or null if the node is the root.
+ * @param node Node to draw.
  */
-void print_buffer(char** buffer, int x, int y, BTBox* parent, BTBox* node) {
-    print_box(buffer, x, y, parent, node);
+void print_box(char* line, int row, int x, BTBox* parent, BTBox* node) {
+    if (row >= BOX_HEIGHT) {
+        return;
+    }
 
-    if (node->left) {
-        print_arm(buffer, x, y, node, node->left);
+    int boxStartX = x + node->boxX;
+    int boxEndX = boxStartX + node->boxWidth - 1;
+    if (row == 0 || row == BOX_HEIGHT - 1) {
+        // Box's corners, then horizontal lines on top and bottom
+        line[boxStartX] = row == 0 ? BOX_TL_CORNER : BOX_BL_CORNER;
+        line[boxEndX] = row == 0 ? BOX_TR_CORNER : BOX_BR_CORNER;
+        memset(line + boxStartX + BOX_BORDER, BOX_H_LINE, boxEndX - boxStartX - BOX_BORDER);
+    } else {
+        // Vertical lines on two sides
+        line[boxStartX] = BOX_V_LINE;
+        line[boxEndX] = BOX_V_LINE;
     }
-    if (node->right) {
-        print_arm(buffer, x, y, node, node->right);
+
+    // If the box is a child node, show the connecting point with its parent's arm.
+    if (row == 0 && parent) {
+        line[boxStartX + node->boxWidth / 2] = ARM_T_JUNCTION;
     }
 
-    if (node->left) {
-        print_buffer(buffer, x, y + BOX_HEIGHT + BOX_V_MARGIN, node, node->left);
+    // Draw the value
+    if (row == BOX_HEIGHT / 2) {
+        print_label(line + boxStartX + BOX_BORDER + BOX_PADDING, node);
     }
-    
-    if (node->right) {
-        print_buffer(buffer, x + node->rightOffset, y + BOX_HEIGHT + BOX_V_MARGIN, node, node->right);
+
+    // Lines between keys of a multi-key node run down to the bottom edge.
+    for (int i = 1; row > 0 && i < node->keyCount; ++i) {
+        line[x + get_separator_x(node, i)] = BOX_V_LINE;
     }
 }
 
 /**
- * @brief Print the connecting line from parent node to child node.
- * @param buffer 2-D printing buffer
+ * @brief Print the part of the connecting line from parent node to child node which lies on one row.
+ * @param line Line buffer of the row being printed.
+ * @param row Row index counting from the top of the parent's level.
+ * @param x Offset x of the parent from the printing origin.
  * @param parent Parent node
  * @param child Child node
- * @param x Starting x position of the child from the printing origin.
- * @param y Starting y position of the child from the printing origin.
  */
-void print_arm(char** buffer, int x, int y, BTBox* parent, BTBox* child) {
+void print_arm(char* line, int row, int x, BTBox* parent, BTBox* child) {
     int armHeight = (BOX_HEIGHT - 1) / 2 + BOX_V_MARGIN + 1;
-    int startX, endX;
-    int startY = y + BOX_HEIGHT / 2;
+    int startY = BOX_HEIGHT / 2;
     int endY = startY + armHeight - 1;
-    char elbow;
+    if (row < startY || row > endY) {
+        return;
+    }
+
+    int startX, endX;
+    char elbow, junction;
     if (parent->left == child) {
         startX = x + parent->boxX - 1;
         endX = get_box_center_x(child, x);
         elbow = ARM_TL_ELBOW;
-        buffer[startY][startX + 1] = ARM_L_JUNCTION;
-    } else if (parent->right == child) {
+        junction = ARM_L_JUNCTION;
+    } else {
         startX = x + parent->boxX + parent->boxWidth;
         endX = get_box_center_x(child, x + parent->rightOffset);
         elbow = ARM_TR_ELBOW;
-        buffer[startY][startX - 1] = ARM_R_JUNCTION;
+        junction = ARM_R_JUNCTION;
     }
-    memset(buffer[startY] + bstbox_min(startX, endX), ARM_H_LINE, abs(endX - startX) + 1);
-    for (int i = startY + 1; i <= endY; ++i) {
-        buffer[i][endX] = ARM_V_LINE;
+
+    if (row > startY) {
+        line[endX] = ARM_V_LINE;
+        return;
     }
-    buffer[startY][endX] = elbow;
+    line[startX + (parent->left == child ? 1 : -1)] = junction;
+    memset(line + bstbox_min(startX, endX), ARM_H_LINE, abs(endX - startX) + 1);
+    line[endX] = elbow;
+}
+
+/**
+ * @brief Print the part of the connecting line from a line between keys down to an inner child which lies on one row.
+ *
+ * Inner arms run down below the box, then sideways on the level's last row to above the child.
+ * @param line Line buffer of the row being printed.
+ * @param row Row index counting from the top of the parent's level.
+ * @param x Offset x of the parent from the printing origin.
+ * @param parent Multi-key parent node
+ * @param index Index of the child, from 1 to the number of keys - 1.
+ */
+void print_inner_arm(char* line, int row, int x, BTBox* parent, int index) {
+    if (row < BOX_HEIGHT) {
+        return;
+    }
+    int startX = x + get_separator_x(parent, index);
+    if (row == LEVEL_HEIGHT - 1) {
+        int endX = get_box_center_x(parent->children[index], x + parent->childOffsets[index]);
+        memset(line + bstbox_min(startX, endX), ARM_H_LINE, abs(endX - startX) + 1);
+    }
+    line[startX] = ARM_V_LINE;
+}
+
+/**
+ * @brief Print a tree of any binary node type, reading its nodes in place.
+ *
+ * Instead of one allocation per node, the layout is kept in flat arrays which are filled and
+ * measured in one pass over the tree. Trees with multi-key nodes are copied into boxes as by
+ * btbox_create_tree_with.
+ * @param tree Root node of the tree, read through [accessor].
+ */
+void btbox_print_with(FILE* file, const void* tree, const BTNodeAccessor* accessor) {
+    if (!file || !tree) {
+        return;
+    }
+    if (accessor->key_count) {
+        BTBox* box = btbox_create_tree_with(tree, accessor);
+        btbox_print(file, box);
+        btbox_free_tree(box);
+        return;
+    }
+
+    FlatLayout layout;
+    if (create_flat_layout(&layout, tree, accessor)) {
+        print_flat_layout(file, &layout);
+    }
+    free_flat_layout(&layout);
+}
+
+/**
+ * @brief Read a binary tree into a flat layout and measure it, in one post-order pass without recursion.
+ * @return 1 on success, 0 if the tree is empty or memory ran out. The layout is to be freed either way.
+ */
+int create_flat_layout(FlatLayout* layout, const void* tree, const BTNodeAccessor* accessor) {
+    int count = count_nodes(tree, accessor);
+    layout->count = count;
+    layout->isInterval = accessor->high != NULL;
+    layout->value = (int*)malloc(sizeof(int) * 9 * count);
+    if (!layout->value || count == 0) {
+        return 0;
+    }
+    layout->high = layout->value + count;
+    layout->left = layout->high + count;
+    layout->right = layout->left + count;
+    layout->width = layout->right + count;
+    layout->height = layout->width + count;
+    layout->boxX = layout->height + count;
+    layout->boxWidth = layout->boxX + count;
+    layout->rightOffset = layout->boxWidth + count;
+
+    // Nodes on the way down, tagged once their children are pushed, and the slots of finished subtrees.
+    // Each node is on one stack or the other but not both, so [count] entries always suffice.
+    const void** pending = (const void**)malloc(sizeof(void*) * count);
+    int* expanded = (int*)malloc(sizeof(int) * count);
+    int* done = (int*)malloc(sizeof(int) * count);
+    int depth = 0;
+    int doneLen = 0;
+    int len = 0;
+    if (pending && expanded && done) {
+        pending[depth] = tree;
+        expanded[depth++] = 0;
+    }
+    while (depth) {
+        const void* node = pending[depth - 1];
+        if (!expanded[depth - 1]) {
+            const void* left = accessor->left(node, accessor->context);
+            const void* right = accessor->right(node, accessor->context);
+            expanded[depth - 1] = 1 | (left ? 2 : 0) | (right ? 4 : 0);
+            if (right) {
+                pending[depth] = right;
+                expanded[depth++] = 0;
+            }
+            if (left) {
+                pending[depth] = left;
+                expanded[depth++] = 0;
+            }
+            continue;
+        }
+
+        // Both subtrees are finished, their slots are on top of [done].
+        int links = expanded[--depth];
+        int i = len++;
+        layout->right[i] = links & 4 ? done[--doneLen] : -1;
+        layout->left[i] = links & 2 ? done[--doneLen] : -1;
+        layout->value[i] = accessor->value(node, accessor->context);
+        layout->high[i] = layout->isInterval ? accessor->high(node, accessor->context) : 0;
+
+        BoxExtent left, right, extent;
+        if (layout->left[i] >= 0) {
+            left = get_flat_extent(layout, layout->left[i]);
+        }
+        if (layout->right[i] >= 0) {
+            right = get_flat_extent(layout, layout->right[i]);
+        }
+        extent.boxWidth = (layout->isInterval ? bstbox_interval_width(layout->value[i], layout->high[i]) : bstbox_int_width(layout->value[i]))
+            + 2 * BOX_PADDING + 2 * BOX_BORDER;
+        layout->rightOffset[i] = 0;
+        place_box(layout->left[i] >= 0 ? &left : NULL, layout->right[i] >= 0 ? &right : NULL, &extent, &layout->rightOffset[i]);
+        layout->boxX[i] = extent.boxX;
+        layout->boxWidth[i] = extent.boxWidth;
+        layout->width[i] = extent.width;
+        layout->height[i] = extent.height;
+        done[doneLen++] = i;
+    }
+    free(pending);
+    free(expanded);
+    free(done);
+    return len == count;
+}
+
+void free_flat_layout(FlatLayout* layout) {
+    free(layout->value);
+    layout->value = NULL;
+    layout->count = 0;
+}
+
+/**
+ * @return A box on the stack showing one slot of a flat layout, so that it is drawn like any other box.
+ */
+BTBox get_flat_box(const FlatLayout* layout, int index) {
+    BTBox box;
+    memset(&box, 0, sizeof(BTBox));
+    box.value = layout->value[index];
+    box.boxX = layout->boxX[index];
+    box.boxWidth = layout->boxWidth[index];
+    box.width = layout->width[index];
+    box.height = layout->height[index];
+    box.rightOffset = layout->rightOffset[index];
+    box.keyCount = 1;
+    box.isInterval = layout->isInterval;
+    box.high = layout->high[index];
+    return box;
+}
+
+/**
+ * @brief Print a measured flat layout level by level, the same way btbox_print does for boxes.
+ */
+void print_flat_layout(FILE* file, const FlatLayout* layout) {
+    int root = layout->count - 1;
+    int width = layout->width[root];
+    int height = layout->height[root];
+    FlatLevelEntry* level = (FlatLevelEntry*)malloc(sizeof(FlatLevelEntry) * layout->count);
+    FlatLevelEntry* next = (FlatLevelEntry*)malloc(sizeof(FlatLevelEntry) * layout->count);
+    char* line = (char*)malloc(width + 1); // plus 1 for end of line character
+    int levelLen = 1;
+    if (!level || !next || !line) {
+        levelLen = 0;
+        height = 0;
+    } else {
+        level[0].index = root;
+        level[0].hasParent = 0;
+        level[0].x = 0;
+    }
+
+    for (int y = 0; y < height; y += LEVEL_HEIGHT) {
+        for (int row = 0; row < LEVEL_HEIGHT && y + row < height; ++row) {
+            memset(line, ' ', width);
+            line[width] = '\0';
+            for (int i = 0; i < levelLen; ++i) {
+                FlatLevelEntry* entry = level + i;
+                BTBox node = get_flat_box(layout, entry->index);
+                BTBox left, right;
+                print_box(line, row, entry->x, entry->hasParent ? &node : NULL, &node);
+                if (layout->left[entry->index] >= 0) {
+                    left = get_flat_box(layout, layout->left[entry->index]);
+                    node.left = &left;
+                    print_arm(line, row, entry->x, &node, &left);
+                }
+                if (layout->right[entry->index] >= 0) {
+                    right = get_flat_box(layout, layout->right[entry->index]);
+                    node.right = &right;
+                    print_arm(line, row, entry->x, &node, &right);
+                }
+            }
+            fprintf(file, "%s\n", line);
+        }
+
+        // A level never holds more slots than the tree, so both level buffers are allocated once.
+        int nextLen = 0;
+        for (int i = 0; i < levelLen; ++i) {
+            FlatLevelEntry* entry = level + i;
+            int left = layout->left[entry->index];
+            int right = layout->right[entry->index];
+            if (left >= 0) {
+                next[nextLen].index = left;
+                next[nextLen].hasParent = 1;
+                next[nextLen++].x = entry->x;
+            }
+            if (right >= 0) {
+                next[nextLen].index = right;
+                next[nextLen].hasParent = 1;
+                next[nextLen++].x = entry->x + layout->rightOffset[entry->index];
+            }
+        }
+        FlatLevelEntry* temp = level;
+        level = next;
+        next = temp;
+        levelLen = nextLen;
+    }
+    fflush(file);
+
+    free(line);
+    free(next);
+    free(level);
+}
+
+/**
+ * @return Number of nodes of a binary tree, counted without recursion.
+ */
+int count_nodes(const void* tree, const BTNodeAccessor* accessor) {
+    WalkStack stack = { NULL, 0, 0 };
+    int count = 0;
+    if (tree && !walk_push(&stack, tree, NULL, NULL)) {
+        return 0;
+    }
+    while (stack.depth) {
+        const void* node = stack.entries[--stack.depth].node;
+        ++count;
+        const void* left = accessor->left(node, accessor->context);
+        const void* right = accessor->right(node, accessor->context);
+        if ((left && !walk_push(&stack, left, NULL, NULL)) || (right && !walk_push(&stack, right, NULL, NULL))) {
+            count = 0;
+            break;
+        }
+    }
+    walk_free(&stack);
+    return count;
+}
+
+/**
+ * @brief Push a node onto a walk's stack, growing it as needed.
+ * @return 1 on success, 0 if memory ran out.
+ */
+int walk_push(WalkStack* stack, const void* node, BTBox** link, BTBox** alsoLink) {
+    if (stack->depth == stack->capacity) {
+        int capacity = stack->capacity ? stack->capacity * 2 : 64;
+        WalkEntry* entries = (WalkEntry*)realloc(stack->entries, sizeof(WalkEntry) * capacity);
+        if (!entries) {
+            return 0;
+        }
+        stack->entries = entries;
+        stack->capacity = capacity;
+    }
+    WalkEntry* entry = stack->entries + stack->depth++;
+    entry->node = node;
+    entry->link = link;
+    entry->alsoLink = alsoLink;
+    return 1;
+}
+
+void walk_free(WalkStack* stack) {
+    free(stack->entries);
+    stack->entries = NULL;
+    stack->depth = 0;
+    stack->capacity = 0;
 }
 
 /**
  * @brief Print the tree content into an output stream.
+ *
+ * The output is streamed line by line: only the nodes of the level being printed are kept,
+ * together with one line buffer, so memory stays proportional to the tree's width.
  * @param out The output stream to print the result
  * @param node Tree's root.
  */
@@ -289,87 +1112,288 @@ void btbox_print(FILE* file, BTBox* node) {
     }
 
     // Do measurement before printing
-    measure(node);
-    
-    // Allocate memory for printing buffer based on tree's measured width and height
-    int actualRows = 0;
-    char** buffer = (char**)malloc(node->height * sizeof(char*));
-    if (!buffer) {
-        goto cleanup;
+    if (!measure(node)) {
+        return;
     }
-    for (int i = 0; i < node->height; ++i) {
-        buffer[i] = (char*)malloc(node->width + 1); // plus 1 for end of line character
-        if (!buffer[i]) {
-            goto cleanup;
-        }
 
-        ++actualRows;
-        memset(buffer[i], ' ', node->width);
-        buffer[i][node->width] = '\0';
+    int levelLen = 1, levelCapacity = 1;
+    int nextLen = 0, nextCapacity = 0;
+    LevelEntry* level = (LevelEntry*)malloc(levelCapacity * sizeof(LevelEntry));
+    LevelEntry* next = NULL;
+    char* line = (char*)malloc(node->width + 1); // plus 1 for end of line character
+    if (!level || !line) {
+        goto cleanup;
     }
+    level[0].node = node;
+    level[0].parent = NULL;
+    level[0].x = 0;
+
+    for (int y = 0; y < node->height; y += LEVEL_HEIGHT) {
+        for (int row = 0; row < LEVEL_HEIGHT && y + row < node->height; ++row) {
+            memset(line, ' ', node->width);
+            line[node->width] = '\0';
+            for (int i = 0; i < levelLen; ++i) {
+                LevelEntry* entry = level + i;
+                print_box(line, row, entry->x, entry->parent, entry->node);
+                if (entry->node->left) {
+                    print_arm(line, row, entry->x, entry->node, entry->node->left);
+                }
+                for (int k = 1; k < entry->node->keyCount; ++k) {
+                    if (entry->node->children[k]) {
+                        print_inner_arm(line, row, entry->x, entry->node, k);
+                    }
+                }
+                if (entry->node->right) {
+                    print_arm(line, row, entry->x, entry->node, entry->node->right);
+                }
+            }
+            fprintf(file, "%s\n", line);
+        }
 
-    print_buffer(buffer, 0, 0, NULL, node);
+        // Collect children of the current level, two per binary node and one per gap between keys otherwise.
+        int childSlots = 0;
+        for (int i = 0; i < levelLen; ++i) {
+            childSlots += level[i].node->keyCount + 1;
+        }
+        if (nextCapacity < childSlots) {
+            LevelEntry* temp = (LevelEntry*)realloc(next, childSlots * sizeof(LevelEntry));
+            if (!temp) {
+                goto cleanup;
+            }
+            next = temp;
+            nextCapacity = childSlots;
+        }
+        nextLen = 0;
+        for (int i = 0; i < levelLen; ++i) {
+            LevelEntry* entry = level + i;
+            if (entry->node->keyCount > 1) {
+                for (int k = 0; k <= entry->node->keyCount; ++k) {
+                    if (entry->node->children[k]) {
+                        next[nextLen].node = entry->node->children[k];
+                        next[nextLen].parent = entry->node;
+                        next[nextLen].x = entry->x + entry->node->childOffsets[k];
+                        ++nextLen;
+                    }
+                }
+                continue;
+            }
+            if (entry->node->left) {
+                next[nextLen].node = entry->node->left;
+                next[nextLen].parent = entry->node;
+                next[nextLen].x = entry->x;
+                ++nextLen;
+            }
+            if (entry->node->right) {
+                next[nextLen].node = entry->node->right;
+                next[nextLen].parent = entry->node;
+                next[nextLen].x = entry->x + entry->node->rightOffset;
+                ++nextLen;
+            }
+        }
 
-    for (int i = 0; i < node->height; ++i) {
-        fprintf(file, "%s\n", buffer[i]);
+        // The collected children become the level to print next.
+        LevelEntry* temp = level;
+        level = next;
+        next = temp;
+        int tempCapacity = levelCapacity;
+        levelCapacity = nextCapacity;
+        nextCapacity = tempCapacity;
+        levelLen = nextLen;
     }
 
     fflush(file);
 
 cleanup:
-    for (int i = 0; i < actualRows; ++i) {
-        free(buffer[i]);
+    free(line);
+    free(next);
+    free(level);
+}
+
+/**
+ * @brief Calculate dimensions and sizes needed for printing for the dirty nodes of the tree.
+ *
+ * Dirty nodes are collected in pre-order, then measured in reverse so that every node comes after
+ * its subtrees. Clean subtrees kept their measures since the last time and are skipped.
+ * @param root Tree's root node.
+ * @return 1 on success, 0 if memory ran out.
+ */
+int measure(BTBox* root) {
+    WalkStack pending = { NULL, 0, 0 };
+    WalkStack order = { NULL, 0, 0 };
+    int failed = root->dirty && !walk_push(&pending, root, NULL, NULL);
+    while (pending.depth && !failed) {
+        BTBox* node = (BTBox*)pending.entries[--pending.depth].node;
+        failed = !walk_push(&order, node, NULL, NULL);
+        // Binary boxes have two children, while children of multi-key ones include [left] and [right].
+        int childCount = node->keyCount > 1 ? node->keyCount + 1 : 2;
+        for (int i = 0; i < childCount && !failed; ++i) {
+            BTBox* child = node->keyCount > 1 ? node->children[i] : (i == 0 ? node->left : node->right);
+            failed = child && child->dirty && !walk_push(&pending, child, NULL, NULL);
+        }
     }
-    free(buffer);
+    for (int i = order.depth - 1; i >= 0 && !failed; --i) {
+        BTBox* node = (BTBox*)order.entries[i].node;
+        if (node->keyCount > 1) {
+            measure_keys(node);
+        } else {
+            measure_node(node);
+        }
+        node->dirty = 0;
+    }
+    walk_free(&pending);
+    walk_free(&order);
+    return !failed;
 }
 
 /**
- * @brief Calculate dimensions and sizes needed for printing for all nodes in the tree.
- * @param node Tree's root node.
+ * @brief Calculate dimensions of a binary node whose subtrees are measured.
  */
-void measure(BTBox* node) {
+void measure_node(BTBox* node) {
+    // The bounding box
+    node->boxWidth = get_label_width(node) + 2 * BOX_PADDING + 2 * BOX_BORDER;
+
+    BoxExtent left, right, extent;
     if (node->left) {
-        measure(node->left);
+        left = get_extent(node->left);
     }
     if (node->right) {
-        measure(node->right);
+        right = get_extent(node->right);
     }
+    extent.boxWidth = node->boxWidth;
+    place_box(node->left ? &left : NULL, node->right ? &right : NULL, &extent, &node->rightOffset);
+    node->boxX = extent.boxX;
+    node->width = extent.width;
+    node->height = extent.height;
+}
 
-    // The bounding box
-    node->valueString = bstbox_to_string(node->value);
-    node->boxWidth = strlen(node->valueString) + 2 * BOX_PADDING + 2 * BOX_BORDER;
-
+/**
+ * @brief Place a binary node's box above its two subtrees.
+ * @param left Measures of the left subtree, or null if there is none, likewise [right].
+ * @param node Measures of the node, whose box width is given.
+ * @param rightOffset Receives the offset of the right subtree, if there is one.
+ */
+void place_box(const BoxExtent* left, const BoxExtent* right, BoxExtent* node, int* rightOffset) {
     // Use left child as parent's anchor
-    int leftBoxCenterX = node->left ? get_box_center_x(node->left, 0) : - ARM_MIN_WIDTH;
+    int leftBoxCenterX = left ? left->boxX + left->boxWidth / 2 : - ARM_MIN_WIDTH;
     node->boxX = leftBoxCenterX + ARM_MIN_WIDTH;
-    node->width = node->boxX + node->boxWidth;
-    if (node->right) {
+    // The left subtree may reach past a narrow box, when its own right subtree is wide.
+    node->width = bstbox_max(node->boxX + node->boxWidth, left ? left->width : 0);
+    if (right) {
         // First assume the two childs are back to back, then check for any overlappings.
-        node->rightOffset = node->left ? node->left->width : node->boxWidth / 2;
+        int offset = left ? left->width : node->boxWidth / 2;
 
         // 1. Check spaces for the right arm, shift the right node forwards if needed.
-        int rightBoxCenterX = get_box_center_x(node->right, node->rightOffset);
+        int rightBoxCenterX = right->boxX + right->boxWidth / 2 + offset;
         int minRightBoxCenterX = node->boxX + node->boxWidth + ARM_MIN_WIDTH - 1;
         int centerXOffset = (minRightBoxCenterX > rightBoxCenterX) ? (minRightBoxCenterX - rightBoxCenterX) : 0;
-        node->rightOffset += centerXOffset;
+        offset += centerXOffset;
 
         // 2. Check if the two childs leave enough spaces in between, if not increase the offset.
-        int childSeparatorOffset = (node->left && (BOX_H_MARGIN > node->rightOffset - node->left->width)) ? (BOX_H_MARGIN - node->rightOffset + node->left->width) : 0;
-        node->rightOffset += childSeparatorOffset;
+        int childSeparatorOffset = (left && (BOX_H_MARGIN > offset - left->width)) ? (BOX_H_MARGIN - offset + left->width) : 0;
+        offset += childSeparatorOffset;
 
         // Center-align the parent's box
-        node->boxX = (get_box_center_x(node->right, node->rightOffset) + leftBoxCenterX + 1) / 2 - node->boxWidth / 2;
+        node->boxX = (right->boxX + right->boxWidth / 2 + offset + leftBoxCenterX + 1) / 2 - node->boxWidth / 2;
+
+        node->width = offset + right->width;
+        *rightOffset = offset;
+    }
+
+    node->height = BOX_V_MARGIN + BOX_HEIGHT + bstbox_max(left ? left->height : 0, right ? right->height : 0);
+}
+
+/**
+ * @brief Calculate dimensions of a multi-key node and its subtrees.
+ *
+ * Children are placed side by side. The box is centered above them, leaving room for the arms
+ * of the outer children which leave the box sideways like those of binary nodes.
+ * @param node Node with more than one key, whose subtrees are measured.
+ */
+void measure_keys(BTBox* node) {
+    int childHeight = 0;
+    int x = 0;
+    for (int i = 0; i <= node->keyCount; ++i) {
+        node->childOffsets[i] = x;
+        if (node->children[i]) {
+            x += node->children[i]->width + BOX_H_MARGIN;
+            childHeight = bstbox_max(childHeight, node->children[i]->height);
+        }
+    }
+
+    node->boxWidth = get_label_width(node) + 2 * BOX_PADDING + 2 * BOX_BORDER;
+    node->boxX = 0;
+    node->width = node->boxWidth;
+    if (x > 0) {
+        BTBox* last = node->children[node->keyCount];
+        int leftBoxCenterX = node->left ? get_box_center_x(node->left, 0) : 0;
+        int rightBoxCenterX = last ? get_box_center_x(last, node->childOffsets[node->keyCount]) : node->childOffsets[node->keyCount];
+        int minRightBoxCenterX = leftBoxCenterX + ARM_MIN_WIDTH + node->boxWidth + ARM_MIN_WIDTH - 1;
+        if (rightBoxCenterX < minRightBoxCenterX) {
+            node->childOffsets[node->keyCount] += minRightBoxCenterX - rightBoxCenterX;
+            rightBoxCenterX = minRightBoxCenterX;
+        }
+        node->boxX = (leftBoxCenterX + rightBoxCenterX + 1) / 2 - node->boxWidth / 2;
+        node->width = bstbox_max(node->boxX + node->boxWidth, node->childOffsets[node->keyCount] + get_width(last));
+    }
+    node->rightOffset = node->childOffsets[node->keyCount];
+    node->height = BOX_V_MARGIN + BOX_HEIGHT + childHeight;
+}
 
-        node->width = node->rightOffset + node->right->width;
+/**
+ * @return Number of characters of a node's label, worked out from the digits without formatting it.
+ */
+int get_label_width(BTBox* node) {
+    if (node->isInterval) {
+        return bstbox_interval_width(node->value, node->high);
     }
+    if (node->keyCount == 1) {
+        return bstbox_int_width(node->value);
+    }
+    int width = (node->keyCount - 1) * (2 * BOX_PADDING + BOX_BORDER);
+    for (int i = 0; i < node->keyCount; ++i) {
+        width += bstbox_int_width(node->keys[i]);
+    }
+    return width;
+}
 
-    node->height = BOX_V_MARGIN + BOX_HEIGHT + bstbox_max(get_height(node->left), get_height(node->right));
+/**
+ * @brief Format a node's label straight into the line being printed.
+ *
+ * Keys of a multi-key node are left apart by the width of a separator, which print_box draws.
+ * @param out Position of the label's first character.
+ */
+void print_label(char* out, BTBox* node) {
+    if (node->isInterval) {
+        bstbox_format_interval(out, node->value, node->high);
+        return;
+    }
+    if (node->keyCount == 1) {
+        bstbox_format_int(out, node->value);
+        return;
+    }
+    for (int i = 0; i < node->keyCount; ++i) {
+        if (i) {
+            out += 2 * BOX_PADDING + BOX_BORDER;
+        }
+        out += bstbox_format_int(out, node->keys[i]);
+    }
 }
 
 int get_box_center_x(BTBox* node, int offset) {
     return node->boxX + node->boxWidth / 2 + offset;
 }
 
+/**
+ * @return Position inside parent of the line before key [index] of a multi-key node.
+ */
+int get_separator_x(BTBox* node, int index) {
+    int x = node->boxX + BOX_BORDER + BOX_PADDING + (index - 1) * (2 * BOX_PADDING + BOX_BORDER) + BOX_PADDING;
+    for (int i = 0; i < index; ++i) {
+        x += bstbox_int_width(node->keys[i]);
+    }
+    return x;
+}
+
 /**
  * @brief Read the text content from [file] and recreate the binary tree.
  * @param file Text file in the export format.
@@ -405,6 +1429,11 @@ static void parse_child_nodes(BTBoxRestoredNode* rootInfo, FILE* file) {
         LinkedListEntry *lastChild = restoredChilds;
         while (queue->head != NULL) {
             BTBoxRestoredNode* parent = queue_pop(queue);
+            if (parent->node->keyCount > 1) {
+                lastChild = attach_children(parent, lastChild);
+                free(parent);
+                continue;
+            }
             if (parent->leftChild && lastChild != NULL) {
                 parent->node->left = lastChild->data->node;
                 lastChild = lastChild->next;
@@ -440,6 +1469,28 @@ static void parse_child_nodes(BTBoxRestoredNode* rootInfo, FILE* file) {
     free(queue);
 }
 
+/**
+ * @brief Connect a multi-key node read from the file to its children on the level below.
+ *
+ * Lines between keys show no arms on the line holding the keys, so multi-key nodes are taken to
+ * have either no children or one per gap between keys, as in B-trees.
+ * @param parent Multi-key node with its arms.
+ * @param child First unconnected node of the level below.
+ * @return The first node left unconnected.
+ */
+static LinkedListEntry* attach_children(BTBoxRestoredNode* parent, LinkedListEntry* child) {
+    if (!parent->leftChild && !parent->rightChild) {
+        return child;
+    }
+    BTNode* node = parent->node;
+    node->children = (BTNode**)calloc(node->keyCount + 1, sizeof(BTNode*));
+    for (int i = 0; node->children && i <= node->keyCount && child != NULL; ++i) {
+        node->children[i] = child->data->node;
+        child = child->next;
+    }
+    return child;
+}
+
 /**
  * @brief Helper function to find the root node from the file.
  * @param file Text file in the export format.
@@ -479,6 +1530,8 @@ LinkedListEntry* restore_nodes(FILE *file) {
     int detectNum = 0;
     int c = 1;
     int numStart = -1, numEnd = -1;
+    int nextStart = -1; // start of the number parsed before, which is on the right
+
     for (int i = bufferSize - 1; i >= 0; --i) {
         if (bstbox_is_numeric(buffer[i])) {
             if (buffer[i] == '-') {
@@ -496,14 +1549,21 @@ LinkedListEntry* restore_nodes(FILE *file) {
 
             // a number detected, check if there're arms at two sides of it
             if (numStart != -1 && numEnd != -1) {
-                BTBoxRestoredNode *node = create_restore_node();
-                node->leftChild = search_arm(buffer, bufferSize, numStart - 1, -1);
-                node->rightChild = search_arm(buffer, bufferSize, numEnd + 1, 1);
-                node->node = btbox_create_node(detectNum);
-
-                LinkedListEntry* entry = linkedlist_create_entry(node);
-                entry->next = list;
-                list = entry;
+                if (list && is_same_box(buffer, numEnd, nextStart)) {
+                    // another key of the node on the right, whose left arm is on this side then
+                    prepend_key(list->data->node, detectNum);
+                    list->data->leftChild = search_arm(buffer, bufferSize, numStart - 1, -1);
+                } else {
+                    BTBoxRestoredNode *node = create_restore_node();
+                    node->leftChild = search_arm(buffer, bufferSize, numStart - 1, -1);
+                    node->rightChild = search_arm(buffer, bufferSize, numEnd + 1, 1);
+                    node->node = btbox_create_node(detectNum);
+
+                    LinkedListEntry* entry = linkedlist_create_entry(node);
+                    entry->next = list;
+                    list = entry;
+                }
+                nextStart = numStart;
 
                 detectNum = 0;
                 c = 1;
@@ -517,6 +1577,42 @@ LinkedListEntry* restore_nodes(FILE *file) {
     return list;
 }
 
+/**
+ * @return 1 if the characters between [end] and [start] are a line between keys of one box,
+ * boxes of different nodes being further apart.
+ */
+int is_same_box(const char* buffer, int end, int start) {
+    int lines = 0;
+    for (int k = end + 1; k < start; ++k) {
+        if (buffer[k] == BOX_V_LINE) {
+            ++lines;
+        } else if (buffer[k] != ' ') {
+            return 0;
+        }
+    }
+    return lines == 1;
+}
+
+/**
+ * @brief Add a key before the keys of a node read from the file, making it a multi-key node.
+ */
+void prepend_key(BTNode* node, int key) {
+    int len = node->keyCount > 1 ? node->keyCount : 1;
+    int* keys = (int*)realloc(node->keys, sizeof(int) * (len + 1));
+    if (!keys) {
+        return;
+    }
+    if (node->keyCount > 1) {
+        memmove(keys + 1, keys, sizeof(int) * len);
+    } else {
+        keys[1] = node->value;
+    }
+    keys[0] = key;
+    node->keys = keys;
+    node->keyCount = len + 1;
+    node->value = key;
+}
+
 /**
  * Go forward or backward to search for signs of an arm.
  * @param buffer One line in the text file.
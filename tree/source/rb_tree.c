@@ -0,0 +1,383 @@
+#include "rb_tree.h"
+
+#include <stdlib.h>
+
+#pragma region Function Declarations
+static void insert_fixup(RBTree* tree, RBNode* node);
+static void remove_fixup(RBTree* tree, RBNode* node, RBNode* parent);
+static void rotate_left(RBTree* tree, RBNode* root);
+static void rotate_right(RBTree* tree, RBNode* root);
+static void replace_subtree(RBTree* tree, RBNode* node, RBNode* child);
+
+static void* engine_create(BSTStats* stats);
+static void engine_destroy(void* tree);
+static int engine_insert(void* tree, int value);
+static int engine_remove(void* tree, int value);
+static int engine_contains(void* tree, int value);
+static const void* engine_get_root(void* tree);
+static const void* get_left(const void* node, const void* context);
+static const void* get_right(const void* node, const void* context);
+static int get_value(const void* node, const void* context);
+
+static inline int is_red(RBNode* node) {
+    return node && node->red;
+}
+
+static inline void count_comparison(RBTree* tree) {
+    if (tree->stats) {
+        ++tree->stats->comparisons;
+    }
+}
+#pragma endregion
+
+const BSTEngine bst_rb_engine = {
+    "rb",
+    engine_create,
+    engine_destroy,
+    engine_insert,
+    engine_remove,
+    engine_contains,
+    engine_get_root,
+    { get_left, get_right, get_value, NULL },
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+};
+
+/**
+ * @brief Initialize an empty tree.
+ * @param stats Counters to write to, or null.
+ */
+void rb_tree_init(RBTree* tree, BSTStats* stats) {
+    tree->root = NULL;
+    tree->stats = stats;
+}
+
+/**
+ * @brief Find the node holding a value.
+ * @return The node, or null if the value is not in the tree.
+ */
+RBNode* rb_tree_find_node(RBTree* tree, int value) {
+    RBNode* node = tree->root;
+    while (node) {
+        count_comparison(tree);
+        if (value == node->value) {
+            return node;
+        }
+        node = value < node->value ? node->left : node->right;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Insert a value as a red leaf, then fix red nodes with red parents bottom-up.
+ * @return 1 if the value is inserted, 0 if it already exists.
+ */
+int rb_tree_insert_node(RBTree* tree, int value) {
+    RBNode* parent = NULL;
+    RBNode** link = &tree->root;
+    while (*link) {
+        count_comparison(tree);
+        if (value == (*link)->value) {
+            return 0;
+        }
+        parent = *link;
+        link = value < parent->value ? &parent->left : &parent->right;
+    }
+
+    RBNode* node = (RBNode*)malloc(sizeof(RBNode));
+    if (!node) {
+        return 0;
+    }
+    node->value = value;
+    node->red = 1;
+    node->left = NULL;
+    node->right = NULL;
+    node->parent = parent;
+    *link = node;
+    insert_fixup(tree, node);
+    return 1;
+}
+
+/**
+ * @brief Restore the red rule after [node] was colored red.
+ *
+ * A red uncle lets the colors be pushed up from the grandparent, which may move the violation
+ * two levels higher. Otherwise one or two rotations end it.
+ */
+void insert_fixup(RBTree* tree, RBNode* node) {
+    while (is_red(node->parent)) {
+        RBNode* parent = node->parent;
+        RBNode* grandParent = parent->parent;
+        if (parent == grandParent->left) {
+            RBNode* uncle = grandParent->right;
+            if (is_red(uncle)) {
+                parent->red = 0;
+                uncle->red = 0;
+                grandParent->red = 1;
+                node = grandParent;
+                continue;
+            }
+            if (node == parent->right) {
+                // Turn the inner grandchild into an outer one first.
+                rotate_left(tree, parent);
+                node = parent;
+                parent = node->parent;
+            }
+            parent->red = 0;
+            grandParent->red = 1;
+            rotate_right(tree, grandParent);
+        } else {
+            // Similar implementation on the other side.
+            RBNode* uncle = grandParent->left;
+            if (is_red(uncle)) {
+                parent->red = 0;
+                uncle->red = 0;
+                grandParent->red = 1;
+                node = grandParent;
+                continue;
+            }
+            if (node == parent->left) {
+                rotate_right(tree, parent);
+                node = parent;
+                parent = node->parent;
+            }
+            parent->red = 0;
+            grandParent->red = 1;
+            rotate_left(tree, grandParent);
+        }
+    }
+    tree->root->red = 0;
+}
+
+/**
+ * @brief Remove a value from the tree.
+ *
+ * A node with two children is replaced by its successor node. If a black node leaves its
+ * position, the path through it lacks one black node, which is fixed bottom-up.
+ * @return 1 if the value is removed, 0 if it is not found.
+ */
+int rb_tree_remove_node(RBTree* tree, int value) {
+    RBNode* node = rb_tree_find_node(tree, value);
+    if (!node) {
+        return 0;
+    }
+
+    RBNode* child;
+    RBNode* childParent;
+    int removedRed = node->red;
+    if (!node->left || !node->right) {
+        child = node->left ? node->left : node->right;
+        childParent = node->parent;
+        replace_subtree(tree, node, child);
+    } else {
+        RBNode* successor = node->right;
+        while (successor->left) {
+            successor = successor->left;
+        }
+        removedRed = successor->red;
+        child = successor->right;
+        if (successor->parent == node) {
+            childParent = successor;
+        } else {
+            childParent = successor->parent;
+            replace_subtree(tree, successor, successor->right);
+            successor->right = node->right;
+            successor->right->parent = successor;
+        }
+        replace_subtree(tree, node, successor);
+        successor->left = node->left;
+        successor->left->parent = successor;
+        successor->red = node->red;
+    }
+    free(node);
+
+    if (!removedRed) {
+        remove_fixup(tree, child, childParent);
+    }
+    return 1;
+}
+
+/**
+ * @brief Give back the black node missing on paths through [node], which may be null.
+ * @param parent Parent of [node], needed when [node] is null.
+ */
+void remove_fixup(RBTree* tree, RBNode* node, RBNode* parent) {
+    while (node != tree->root && !is_red(node)) {
+        if (node == parent->left) {
+            RBNode* sibling = parent->right;
+            if (is_red(sibling)) {
+                sibling->red = 0;
+                parent->red = 1;
+                rotate_left(tree, parent);
+                sibling = parent->right;
+            }
+            if (!is_red(sibling->left) && !is_red(sibling->right)) {
+                // Take one black node off the sibling's side too, the parent is short of one now.
+                sibling->red = 1;
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+            if (!is_red(sibling->right)) {
+                sibling->left->red = 0;
+                sibling->red = 1;
+                rotate_right(tree, sibling);
+                sibling = parent->right;
+            }
+            sibling->red = parent->red;
+            parent->red = 0;
+            sibling->right->red = 0;
+            rotate_left(tree, parent);
+            node = tree->root;
+        } else {
+            // Similar implementation on the other side.
+            RBNode* sibling = parent->left;
+            if (is_red(sibling)) {
+                sibling->red = 0;
+                parent->red = 1;
+                rotate_right(tree, parent);
+                sibling = parent->left;
+            }
+            if (!is_red(sibling->left) && !is_red(sibling->right)) {
+                sibling->red = 1;
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+            if (!is_red(sibling->left)) {
+                sibling->right->red = 0;
+                sibling->red = 1;
+                rotate_left(tree, sibling);
+                sibling = parent->left;
+            }
+            sibling->red = parent->red;
+            parent->red = 0;
+            sibling->left->red = 0;
+            rotate_right(tree, parent);
+            node = tree->root;
+        }
+    }
+    if (node) {
+        node->red = 0;
+    }
+}
+
+/**
+ * @brief Put [child] where [node] is linked from its parent, or at the root.
+ */
+void replace_subtree(RBTree* tree, RBNode* node, RBNode* child) {
+    if (!node->parent) {
+        tree->root = child;
+    } else if (node == node->parent->left) {
+        node->parent->left = child;
+    } else {
+        node->parent->right = child;
+    }
+    if (child) {
+        child->parent = node->parent;
+    }
+}
+
+/**
+ * @brief Left rotation, the right child takes the place of [root].
+ */
+void rotate_left(RBTree* tree, RBNode* root) {
+    if (tree->stats) {
+        ++tree->stats->rotations;
+    }
+    RBNode* child = root->right;
+    root->right = child->left;
+    if (child->left) {
+        child->left->parent = root;
+    }
+    replace_subtree(tree, root, child);
+    child->left = root;
+    root->parent = child;
+}
+
+/**
+ * @brief Similar to left rotation.
+ * @ref rotate_left
+ */
+void rotate_right(RBTree* tree, RBNode* root) {
+    if (tree->stats) {
+        ++tree->stats->rotations;
+    }
+    RBNode* child = root->left;
+    root->left = child->right;
+    if (child->right) {
+        child->right->parent = root;
+    }
+    replace_subtree(tree, root, child);
+    child->right = root;
+    root->parent = child;
+}
+
+/**
+ * @brief Delete all nodes without recursion, the tree is empty afterwards.
+ */
+void rb_tree_clear(RBTree* tree) {
+    // Rotate left children up until there is none, then the node can go.
+    RBNode* node = tree->root;
+    while (node) {
+        RBNode* left = node->left;
+        if (left) {
+            node->left = left->right;
+            left->right = node;
+            node = left;
+        } else {
+            RBNode* right = node->right;
+            free(node);
+            node = right;
+        }
+    }
+    tree->root = NULL;
+}
+
+#pragma region Engine
+
+void* engine_create(BSTStats* stats) {
+    RBTree* tree = (RBTree*)malloc(sizeof(RBTree));
+    if (tree) {
+        rb_tree_init(tree, stats);
+    }
+    return tree;
+}
+
+void engine_destroy(void* tree) {
+    rb_tree_clear((RBTree*)tree);
+    free(tree);
+}
+
+int engine_insert(void* tree, int value) {
+    return rb_tree_insert_node((RBTree*)tree, value);
+}
+
+int engine_remove(void* tree, int value) {
+    return rb_tree_remove_node((RBTree*)tree, value);
+}
+
+int engine_contains(void* tree, int value) {
+    return rb_tree_find_node((RBTree*)tree, value) != NULL;
+}
+
+const void* engine_get_root(void* tree) {
+    return ((RBTree*)tree)->root;
+}
+
+const void* get_left(const void* node, const void* context) {
+    return ((const RBNode*)node)->left;
+}
+
+const void* get_right(const void* node, const void* context) {
+    return ((const RBNode*)node)->right;
+}
+
+int get_value(const void* node, const void* context) {
+    return ((const RBNode*)node)->value;
+}
+
+#pragma endregion
@@ -0,0 +1,244 @@
+#include "splay_tree.h"
+
+#include <stdlib.h>
+
+#pragma region Function Declarations
+static SplayNode* splay(SplayTree* tree, SplayNode* root, int value);
+
+static void* engine_create(BSTStats* stats);
+static void engine_destroy(void* tree);
+static int engine_insert(void* tree, int value);
+static int engine_remove(void* tree, int value);
+static int engine_contains(void* tree, int value);
+static const void* engine_get_root(void* tree);
+static const void* get_left(const void* node, const void* context);
+static const void* get_right(const void* node, const void* context);
+static int get_value(const void* node, const void* context);
+
+static inline void count_comparison(SplayTree* tree) {
+    if (tree->stats) {
+        ++tree->stats->comparisons;
+    }
+}
+
+static inline void count_rotation(SplayTree* tree) {
+    if (tree->stats) {
+        ++tree->stats->rotations;
+    }
+}
+#pragma endregion
+
+const BSTEngine bst_splay_engine = {
+    "splay",
+    engine_create,
+    engine_destroy,
+    engine_insert,
+    engine_remove,
+    engine_contains,
+    engine_get_root,
+    { get_left, get_right, get_value, NULL },
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    1,
+};
+
+/**
+ * @brief Initialize an empty tree.
+ * @param stats Counters to write to, or null.
+ */
+void splay_tree_init(SplayTree* tree, BSTStats* stats) {
+    tree->root = NULL;
+    tree->stats = stats;
+}
+
+/**
+ * @brief Top-down splay, bringing [value] or the last node on its search path to the root.
+ *
+ * Nodes passed on the way down are hung onto a left tree of smaller values and a right tree of
+ * greater values, which become the new root's children. Zig-zig steps rotate before linking.
+ * @return The new root.
+ */
+SplayNode* splay(SplayTree* tree, SplayNode* root, int value) {
+    if (!root) {
+        return NULL;
+    }
+    SplayNode header = { 0, NULL, NULL };
+    SplayNode* leftMax = &header;   // Largest node of the left tree, its right child is free.
+    SplayNode* rightMin = &header;  // Smallest node of the right tree, its left child is free.
+    while (1) {
+        count_comparison(tree);
+        if (value < root->value) {
+            if (!root->left) {
+                break;
+            }
+            count_comparison(tree);
+            if (value < root->left->value) {
+                SplayNode* child = root->left;
+                root->left = child->right;
+                child->right = root;
+                root = child;
+                count_rotation(tree);
+                if (!root->left) {
+                    break;
+                }
+            }
+            rightMin->left = root;
+            rightMin = root;
+            root = root->left;
+        } else if (value > root->value) {
+            // Similar implementation on the other side.
+            if (!root->right) {
+                break;
+            }
+            count_comparison(tree);
+            if (value > root->right->value) {
+                SplayNode* child = root->right;
+                root->right = child->left;
+                child->left = root;
+                root = child;
+                count_rotation(tree);
+                if (!root->right) {
+                    break;
+                }
+            }
+            leftMax->right = root;
+            leftMax = root;
+            root = root->right;
+        } else {
+            break;
+        }
+    }
+    leftMax->right = root->left;
+    rightMin->left = root->right;
+    root->left = header.right;
+    root->right = header.left;
+    return root;
+}
+
+/**
+ * @brief Find the node holding a value, which becomes the root.
+ * @return The node, or null if the value is not in the tree.
+ */
+SplayNode* splay_tree_find_node(SplayTree* tree, int value) {
+    tree->root = splay(tree, tree->root, value);
+    return tree->root && tree->root->value == value ? tree->root : NULL;
+}
+
+/**
+ * @brief Insert a value as the new root, splitting the splayed tree around it.
+ * @return 1 if the value is inserted, 0 if it already exists.
+ */
+int splay_tree_insert_node(SplayTree* tree, int value) {
+    SplayNode* root = splay(tree, tree->root, value);
+    tree->root = root;
+    if (root && root->value == value) {
+        return 0;
+    }
+    SplayNode* node = (SplayNode*)malloc(sizeof(SplayNode));
+    if (!node) {
+        return 0;
+    }
+    node->value = value;
+    if (!root) {
+        node->left = NULL;
+        node->right = NULL;
+    } else if (value < root->value) {
+        node->left = root->left;
+        node->right = root;
+        root->left = NULL;
+    } else {
+        node->right = root->right;
+        node->left = root;
+        root->right = NULL;
+    }
+    tree->root = node;
+    return 1;
+}
+
+/**
+ * @brief Remove a value, joining its subtrees by splaying the left one's maximum to its top.
+ * @return 1 if the value is removed, 0 if it is not found.
+ */
+int splay_tree_remove_node(SplayTree* tree, int value) {
+    SplayNode* root = splay_tree_find_node(tree, value);
+    if (!root) {
+        return 0;
+    }
+    if (!root->left) {
+        tree->root = root->right;
+    } else {
+        // All values on the left are smaller, so the maximum comes up without a right child.
+        tree->root = splay(tree, root->left, value);
+        tree->root->right = root->right;
+    }
+    free(root);
+    return 1;
+}
+
+/**
+ * @brief Delete all nodes without recursion, the tree is empty afterwards.
+ */
+void splay_tree_clear(SplayTree* tree) {
+    SplayNode* node = tree->root;
+    while (node) {
+        SplayNode* left = node->left;
+        if (left) {
+            node->left = left->right;
+            left->right = node;
+            node = left;
+        } else {
+            SplayNode* right = node->right;
+            free(node);
+            node = right;
+        }
+    }
+    tree->root = NULL;
+}
+
+#pragma region Engine
+
+void* engine_create(BSTStats* stats) {
+    SplayTree* tree = (SplayTree*)malloc(sizeof(SplayTree));
+    if (tree) {
+        splay_tree_init(tree, stats);
+    }
+    return tree;
+}
+
+void engine_destroy(void* tree) {
+    splay_tree_clear((SplayTree*)tree);
+    free(tree);
+}
+
+int engine_insert(void* tree, int value) {
+    return splay_tree_insert_node((SplayTree*)tree, value);
+}
+
+int engine_remove(void* tree, int value) {
+    return splay_tree_remove_node((SplayTree*)tree, value);
+}
+
+int engine_contains(void* tree, int value) {
+    return splay_tree_find_node((SplayTree*)tree, value) != NULL;
+}
+
+const void* engine_get_root(void* tree) {
+    return ((SplayTree*)tree)->root;
+}
+
+const void* get_left(const void* node, const void* context) {
+    return ((const SplayNode*)node)->left;
+}
+
+const void* get_right(const void* node, const void* context) {
+    return ((const SplayNode*)node)->right;
+}
+
+int get_value(const void* node, const void* context) {
+    return ((const SplayNode*)node)->value;
+}
+
+#pragma endregion
@@ -0,0 +1,236 @@
+#include "treap.h"
+
+#include <stdlib.h>
+
+#pragma region Function Declarations
+static unsigned int next_priority(Treap* treap);
+
+static void* engine_create(BSTStats* stats);
+static void engine_destroy(void* tree);
+static int engine_insert(void* tree, int value);
+static int engine_remove(void* tree, int value);
+static int engine_contains(void* tree, int value);
+static const void* engine_get_root(void* tree);
+static const void* get_left(const void* node, const void* context);
+static const void* get_right(const void* node, const void* context);
+static int get_value(const void* node, const void* context);
+
+static inline void count_comparison(Treap* treap) {
+    if (treap->stats) {
+        ++treap->stats->comparisons;
+    }
+}
+
+static inline void count_rotation(Treap* treap) {
+    if (treap->stats) {
+        ++treap->stats->rotations;
+    }
+}
+#pragma endregion
+
+const BSTEngine bst_treap_engine = {
+    "treap",
+    engine_create,
+    engine_destroy,
+    engine_insert,
+    engine_remove,
+    engine_contains,
+    engine_get_root,
+    { get_left, get_right, get_value, NULL },
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+};
+
+/**
+ * @brief Initialize an empty treap.
+ * @param seed Seed of the priorities, the same seed and operations give the same shape.
+ * @param stats Counters to write to, or null.
+ */
+void treap_init(Treap* treap, unsigned int seed, BSTStats* stats) {
+    treap->root = NULL;
+    treap->seed = seed ? seed : 1;
+    treap->stats = stats;
+}
+
+/**
+ * @brief Xorshift generator, good enough for priorities and cheaper than rand().
+ */
+unsigned int next_priority(Treap* treap) {
+    unsigned int x = treap->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    treap->seed = x;
+    return x;
+}
+
+/**
+ * @brief Find the node holding a value.
+ * @return The node, or null if the value is not in the treap.
+ */
+TreapNode* treap_find_node(Treap* treap, int value) {
+    TreapNode* node = treap->root;
+    while (node) {
+        count_comparison(treap);
+        if (value == node->value) {
+            return node;
+        }
+        node = value < node->value ? node->left : node->right;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Insert a value to the treap.
+ *
+ * The new node goes where its priority fits the heap order, and the subtree found there is
+ * split by value into its two children. Each step of the split stands for one rotation of the
+ * classic insertion, which brings the node up from a leaf, so it is counted as such.
+ * @return 1 if the value is inserted, 0 if it already exists.
+ */
+int treap_insert_node(Treap* treap, int value) {
+    if (treap_find_node(treap, value)) {
+        return 0;
+    }
+    TreapNode* node = (TreapNode*)malloc(sizeof(TreapNode));
+    if (!node) {
+        return 0;
+    }
+    node->value = value;
+    node->priority = next_priority(treap);
+
+    TreapNode** link = &treap->root;
+    while (*link && (*link)->priority >= node->priority) {
+        count_comparison(treap);
+        link = value < (*link)->value ? &(*link)->left : &(*link)->right;
+    }
+
+    TreapNode* subtree = *link;
+    TreapNode** leftLink = &node->left;
+    TreapNode** rightLink = &node->right;
+    while (subtree) {
+        count_comparison(treap);
+        count_rotation(treap);
+        if (subtree->value < value) {
+            *leftLink = subtree;
+            leftLink = &subtree->right;
+            subtree = subtree->right;
+        } else {
+            *rightLink = subtree;
+            rightLink = &subtree->left;
+            subtree = subtree->left;
+        }
+    }
+    *leftLink = NULL;
+    *rightLink = NULL;
+    *link = node;
+    return 1;
+}
+
+/**
+ * @brief Remove a value from the treap.
+ *
+ * The node's children are merged in heap order into its place, each step of the merge
+ * standing for one rotation of the classic deletion, which pushes the node down to a leaf.
+ * @return 1 if the value is removed, 0 if it is not found.
+ */
+int treap_remove_node(Treap* treap, int value) {
+    TreapNode** link = &treap->root;
+    while (*link) {
+        count_comparison(treap);
+        if (value == (*link)->value) {
+            break;
+        }
+        link = value < (*link)->value ? &(*link)->left : &(*link)->right;
+    }
+    TreapNode* node = *link;
+    if (!node) {
+        return 0;
+    }
+
+    TreapNode* left = node->left;
+    TreapNode* right = node->right;
+    while (left && right) {
+        count_rotation(treap);
+        if (left->priority > right->priority) {
+            *link = left;
+            link = &left->right;
+            left = left->right;
+        } else {
+            *link = right;
+            link = &right->left;
+            right = right->left;
+        }
+    }
+    *link = left ? left : right;
+    free(node);
+    return 1;
+}
+
+/**
+ * @brief Delete all nodes without recursion, the treap is empty afterwards.
+ */
+void treap_clear(Treap* treap) {
+    TreapNode* node = treap->root;
+    while (node) {
+        TreapNode* left = node->left;
+        if (left) {
+            node->left = left->right;
+            left->right = node;
+            node = left;
+        } else {
+            TreapNode* right = node->right;
+            free(node);
+            node = right;
+        }
+    }
+    treap->root = NULL;
+}
+
+#pragma region Engine
+
+void* engine_create(BSTStats* stats) {
+    Treap* treap = (Treap*)malloc(sizeof(Treap));
+    if (treap) {
+        treap_init(treap, 0x9E3779B9u, stats);
+    }
+    return treap;
+}
+
+void engine_destroy(void* tree) {
+    treap_clear((Treap*)tree);
+    free(tree);
+}
+
+int engine_insert(void* tree, int value) {
+    return treap_insert_node((Treap*)tree, value);
+}
+
+int engine_remove(void* tree, int value) {
+    return treap_remove_node((Treap*)tree, value);
+}
+
+int engine_contains(void* tree, int value) {
+    return treap_find_node((Treap*)tree, value) != NULL;
+}
+
+const void* engine_get_root(void* tree) {
+    return ((Treap*)tree)->root;
+}
+
+const void* get_left(const void* node, const void* context) {
+    return ((const TreapNode*)node)->left;
+}
+
+const void* get_right(const void* node, const void* context) {
+    return ((const TreapNode*)node)->right;
+}
+
+int get_value(const void* node, const void* context) {
+    return ((const TreapNode*)node)->value;
+}
+
+#pragma endregion
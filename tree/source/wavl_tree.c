@@ -0,0 +1,350 @@
+#include "wavl_tree.h"
+
+#include <stdlib.h>
+
+// Ranks are at most 2 log2(n), so trees of any int-sized count fit.
+#define MAX_DEPTH 128
+
+#pragma region Function Declarations
+static void* engine_create(BSTStats* stats);
+static void engine_destroy(void* tree);
+static int engine_insert(void* tree, int value);
+static int engine_remove(void* tree, int value);
+static int engine_contains(void* tree, int value);
+static const void* engine_get_root(void* tree);
+static const void* get_left(const void* node, const void* context);
+static const void* get_right(const void* node, const void* context);
+static int get_value(const void* node, const void* context);
+
+static inline int get_rank(WAVLNode* node) {
+    return node ? node->rank : -1;
+}
+
+static inline int is_leaf(WAVLNode* node) {
+    return !node->left && !node->right;
+}
+
+static inline void count_comparison(WAVLTree* tree) {
+    if (tree->stats) {
+        ++tree->stats->comparisons;
+    }
+}
+
+static inline void count_rotations(WAVLTree* tree, int count) {
+    if (tree->stats) {
+        tree->stats->rotations += count;
+    }
+}
+#pragma endregion
+
+const BSTEngine bst_wavl_engine = {
+    "wavl",
+    engine_create,
+    engine_destroy,
+    engine_insert,
+    engine_remove,
+    engine_contains,
+    engine_get_root,
+    { get_left, get_right, get_value, NULL },
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+};
+
+/**
+ * @brief Initialize an empty tree.
+ * @param stats Counters to write to, or null.
+ */
+void wavl_tree_init(WAVLTree* tree, BSTStats* stats) {
+    tree->root = NULL;
+    tree->stats = stats;
+}
+
+/**
+ * @brief Find the node holding a value.
+ * @return The node, or null if the value is not in the tree.
+ */
+WAVLNode* wavl_tree_find_node(WAVLTree* tree, int value) {
+    WAVLNode* node = tree->root;
+    while (node) {
+        count_comparison(tree);
+        if (value == node->value) {
+            return node;
+        }
+        node = value < node->value ? node->left : node->right;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Insert a value as a leaf of rank 0.
+ *
+ * A child ranked the same as its parent is fixed bottom-up: the parent is promoted while its
+ * other child is ranked 1 below, otherwise one single or double rotation ends the fixing.
+ * @return 1 if the value is inserted, 0 if it already exists.
+ */
+int wavl_tree_insert_node(WAVLTree* tree, int value) {
+    WAVLNode** links[MAX_DEPTH];
+    int depth = 0;
+    WAVLNode** link = &tree->root;
+    while (*link) {
+        count_comparison(tree);
+        if (value == (*link)->value) {
+            return 0;
+        }
+        links[depth++] = link;
+        link = value < (*link)->value ? &(*link)->left : &(*link)->right;
+    }
+
+    WAVLNode* node = (WAVLNode*)malloc(sizeof(WAVLNode));
+    if (!node) {
+        return 0;
+    }
+    node->value = value;
+    node->rank = 0;
+    node->left = NULL;
+    node->right = NULL;
+    *link = node;
+
+    WAVLNode** childLink = link;
+    for (int i = depth - 1; i >= 0; --i) {
+        WAVLNode* parent = *links[i];
+        WAVLNode* child = *childLink;
+        if (parent->rank != child->rank) {
+            break;
+        }
+        int childIsLeft = childLink == &parent->left;
+        WAVLNode* sibling = childIsLeft ? parent->right : parent->left;
+        if (parent->rank - get_rank(sibling) == 1) {
+            ++parent->rank;
+            childLink = links[i];
+            continue;
+        }
+
+        if (childIsLeft) {
+            WAVLNode* inner = child->right;
+            if (child->rank - get_rank(inner) == 2) {
+                parent->left = inner;
+                child->right = parent;
+                *links[i] = child;
+                --parent->rank;
+                count_rotations(tree, 1);
+            } else {
+                child->right = inner->left;
+                parent->left = inner->right;
+                inner->left = child;
+                inner->right = parent;
+                *links[i] = inner;
+                ++inner->rank;
+                --child->rank;
+                --parent->rank;
+                count_rotations(tree, 2);
+            }
+        } else {
+            // Similar implementation on the other side.
+            WAVLNode* inner = child->left;
+            if (child->rank - get_rank(inner) == 2) {
+                parent->right = inner;
+                child->left = parent;
+                *links[i] = child;
+                --parent->rank;
+                count_rotations(tree, 1);
+            } else {
+                child->left = inner->right;
+                parent->right = inner->left;
+                inner->right = child;
+                inner->left = parent;
+                *links[i] = inner;
+                ++inner->rank;
+                --child->rank;
+                --parent->rank;
+                count_rotations(tree, 2);
+            }
+        }
+        break;
+    }
+    return 1;
+}
+
+/**
+ * @brief Remove a value from the tree.
+ *
+ * Like avl_remove_node, a node with a left child takes over the maximum value of its left
+ * subtree, whose node is removed instead. A child ranked 3 below its parent afterwards is
+ * fixed bottom-up by demotions, and at most one single or double rotation.
+ * @return 1 if the value is removed, 0 if it is not found.
+ */
+int wavl_tree_remove_node(WAVLTree* tree, int value) {
+    WAVLNode** links[MAX_DEPTH];
+    int depth = 0;
+    WAVLNode** link = &tree->root;
+    while (*link) {
+        count_comparison(tree);
+        if (value == (*link)->value) {
+            break;
+        }
+        links[depth++] = link;
+        link = value < (*link)->value ? &(*link)->left : &(*link)->right;
+    }
+    WAVLNode* node = *link;
+    if (!node) {
+        return 0;
+    }
+
+    if (node->left) {
+        links[depth++] = link;
+        link = &node->left;
+        while ((*link)->right) {
+            links[depth++] = link;
+            link = &(*link)->right;
+        }
+        WAVLNode* max = *link;
+        node->value = max->value;
+        node = max;
+    }
+    // The removed node has at most one child, which takes its place.
+    *link = node->left ? node->left : node->right;
+    free(node);
+
+    int i = depth - 1;
+    WAVLNode** childLink = link;
+    if (i >= 0 && is_leaf(*links[i]) && (*links[i])->rank == 1) {
+        // Leaves must have rank 0.
+        --(*links[i])->rank;
+        childLink = links[i--];
+    }
+    for (; i >= 0; --i) {
+        WAVLNode* parent = *links[i];
+        WAVLNode* child = *childLink;
+        if (parent->rank - get_rank(child) != 3) {
+            break;
+        }
+        int childIsLeft = childLink == &parent->left;
+        WAVLNode* sibling = childIsLeft ? parent->right : parent->left;
+        if (parent->rank - sibling->rank == 2) {
+            --parent->rank;
+            childLink = links[i];
+            continue;
+        }
+        if (sibling->rank - get_rank(sibling->left) == 2 && sibling->rank - get_rank(sibling->right) == 2) {
+            --sibling->rank;
+            --parent->rank;
+            childLink = links[i];
+            continue;
+        }
+
+        if (childIsLeft) {
+            WAVLNode* outer = sibling->right;
+            WAVLNode* inner = sibling->left;
+            if (sibling->rank - get_rank(outer) == 1) {
+                parent->right = inner;
+                sibling->left = parent;
+                *links[i] = sibling;
+                ++sibling->rank;
+                parent->rank -= is_leaf(parent) ? 2 : 1;
+                count_rotations(tree, 1);
+            } else {
+                parent->right = inner->left;
+                sibling->left = inner->right;
+                inner->left = parent;
+                inner->right = sibling;
+                *links[i] = inner;
+                inner->rank += 2;
+                --sibling->rank;
+                parent->rank -= 2;
+                count_rotations(tree, 2);
+            }
+        } else {
+            // Similar implementation on the other side.
+            WAVLNode* outer = sibling->left;
+            WAVLNode* inner = sibling->right;
+            if (sibling->rank - get_rank(outer) == 1) {
+                parent->left = inner;
+                sibling->right = parent;
+                *links[i] = sibling;
+                ++sibling->rank;
+                parent->rank -= is_leaf(parent) ? 2 : 1;
+                count_rotations(tree, 1);
+            } else {
+                parent->left = inner->right;
+                sibling->right = inner->left;
+                inner->right = parent;
+                inner->left = sibling;
+                *links[i] = inner;
+                inner->rank += 2;
+                --sibling->rank;
+                parent->rank -= 2;
+                count_rotations(tree, 2);
+            }
+        }
+        break;
+    }
+    return 1;
+}
+
+/**
+ * @brief Delete all nodes without recursion, the tree is empty afterwards.
+ */
+void wavl_tree_clear(WAVLTree* tree) {
+    WAVLNode* node = tree->root;
+    while (node) {
+        WAVLNode* left = node->left;
+        if (left) {
+            node->left = left->right;
+            left->right = node;
+            node = left;
+        } else {
+            WAVLNode* right = node->right;
+            free(node);
+            node = right;
+        }
+    }
+    tree->root = NULL;
+}
+
+#pragma region Engine
+
+void* engine_create(BSTStats* stats) {
+    WAVLTree* tree = (WAVLTree*)malloc(sizeof(WAVLTree));
+    if (tree) {
+        wavl_tree_init(tree, stats);
+    }
+    return tree;
+}
+
+void engine_destroy(void* tree) {
+    wavl_tree_clear((WAVLTree*)tree);
+    free(tree);
+}
+
+int engine_insert(void* tree, int value) {
+    return wavl_tree_insert_node((WAVLTree*)tree, value);
+}
+
+int engine_remove(void* tree, int value) {
+    return wavl_tree_remove_node((WAVLTree*)tree, value);
+}
+
+int engine_contains(void* tree, int value) {
+    return wavl_tree_find_node((WAVLTree*)tree, value) != NULL;
+}
+
+const void* engine_get_root(void* tree) {
+    return ((WAVLTree*)tree)->root;
+}
+
+const void* get_left(const void* node, const void* context) {
+    return ((const WAVLNode*)node)->left;
+}
+
+const void* get_right(const void* node, const void* context) {
+    return ((const WAVLNode*)node)->right;
+}
+
+int get_value(const void* node, const void* context) {
+    return ((const WAVLNode*)node)->value;
+}
+
+#pragma endregion
@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "avl_tree.h"
+
+class AVLAggregateTest : public ::testing::Test {
+    protected:
+        AVLTree tree;
+
+        void SetUp() override {
+            avl_tree_init_augmented(&tree, AVL_AUGMENT_AGGREGATES);
+        }
+
+        void TearDown() override {
+            avl_tree_clear(&tree);
+        }
+
+        // Check every node's summaries against its subtree, return the subtree's node count.
+        int expect_valid_aggregates(AVLNode* node) {
+            if (!node) return 0;
+            int count = 1 + expect_valid_aggregates(node->left) + expect_valid_aggregates(node->right);
+            AVLAggregateNode* aggregate = avl_aggregate(node);
+            long long sum = node->value;
+            int min = node->value, max = node->value;
+            if (node->left) {
+                sum += avl_aggregate(node->left)->sum;
+                min = avl_aggregate(node->left)->min;
+            }
+            if (node->right) {
+                sum += avl_aggregate(node->right)->sum;
+                max = avl_aggregate(node->right)->max;
+            }
+            EXPECT_EQ(count, aggregate->count);
+            EXPECT_EQ(sum, aggregate->sum);
+            EXPECT_EQ(min, aggregate->min);
+            EXPECT_EQ(max, aggregate->max);
+            return count;
+        }
+};
+
+TEST_F(AVLAggregateTest, Insert_RotationsKeepAggregates) {
+    int values[]{10, 5, 15, 18, 12, 13, 1, 2, 3};
+    avl_tree_insert_nodes(&tree, values, 9);
+
+    AVLAggregateNode* root = avl_aggregate(tree.root);
+    EXPECT_EQ(9, root->count);
+    EXPECT_EQ(79, root->sum);
+    EXPECT_EQ(1, root->min);
+    EXPECT_EQ(18, root->max);
+    expect_valid_aggregates(tree.root);
+}
+
+TEST_F(AVLAggregateTest, RankSelectAndRanges) {
+    int values[]{40, 25, 60, 12, 30, 50, 70, 8, 27, 28, 45, 55, 65, 9, 26};
+    avl_tree_insert_nodes(&tree, values, 15);
+    avl_tree_remove_node(&tree, 40);
+
+    EXPECT_EQ(0, avl_tree_rank(&tree, 8));
+    EXPECT_EQ(1, avl_tree_rank(&tree, 9));
+    EXPECT_EQ(7, avl_tree_rank(&tree, 30));
+    EXPECT_EQ(8, avl_tree_rank(&tree, 40));
+    EXPECT_EQ(14, avl_tree_rank(&tree, 1000));
+
+    EXPECT_EQ(8, avl_tree_select(&tree, 0)->value);
+    EXPECT_EQ(30, avl_tree_select(&tree, 7)->value);
+    EXPECT_EQ(70, avl_tree_select(&tree, 13)->value);
+    EXPECT_EQ(nullptr, avl_tree_select(&tree, 14));
+    EXPECT_EQ(nullptr, avl_tree_select(&tree, -1));
+
+    EXPECT_EQ(4, avl_tree_count_range(&tree, 26, 30));
+    EXPECT_EQ(26 + 27 + 28 + 30, avl_tree_range_sum(&tree, 26, 40));
+    EXPECT_EQ(0, avl_tree_count_range(&tree, 31, 44));
+    EXPECT_EQ(0, avl_tree_count_range(&tree, 30, 26));
+    EXPECT_EQ(14, avl_tree_count_range(&tree, INT_MIN, INT_MAX));
+}
+
+TEST_F(AVLAggregateTest, RandomOperations_MatchReferenceSet) {
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> valueDistribution(-500, 500);
+    std::set<int> reference;
+
+    for (int i = 0; i < 3000; ++i) {
+        int value = valueDistribution(random);
+        if (random() % 3) {
+            EXPECT_EQ(reference.insert(value).second, (bool)avl_tree_insert_node(&tree, value));
+        } else {
+            EXPECT_EQ(reference.erase(value) == 1, (bool)avl_tree_remove_node(&tree, value));
+        }
+    }
+    EXPECT_EQ((int)reference.size(), expect_valid_aggregates(tree.root));
+
+    std::vector<int> sorted(reference.begin(), reference.end());
+    for (int i = 0; i < 200; ++i) {
+        int low = valueDistribution(random);
+        int high = low + random() % 200;
+        auto first = std::lower_bound(sorted.begin(), sorted.end(), low);
+        auto last = std::upper_bound(sorted.begin(), sorted.end(), high);
+        long long sum = 0;
+        for (auto it = first; it != last; ++it) sum += *it;
+
+        EXPECT_EQ(first - sorted.begin(), avl_tree_rank(&tree, low));
+        EXPECT_EQ(last - first, avl_tree_count_range(&tree, low, high));
+        EXPECT_EQ(sum, avl_tree_range_sum(&tree, low, high));
+    }
+    for (int i = 0; i < (int)sorted.size(); ++i) {
+        EXPECT_EQ(sorted[i], avl_tree_select(&tree, i)->value);
+    }
+}
+
+TEST_F(AVLAggregateTest, Build_HasAggregates) {
+    int values[]{9, 3, 7, 1, 5};
+    avl_tree_build(&tree, values, 5);
+
+    EXPECT_EQ(5, expect_valid_aggregates(tree.root));
+    EXPECT_EQ(25, avl_aggregate(tree.root)->sum);
+    EXPECT_EQ(7, avl_tree_select(&tree, 3)->value);
+}
+
+TEST_F(AVLAggregateTest, RemoveNodes_KeepsAggregates) {
+    std::vector<int> values;
+    for (int i = 1; i <= 1000; ++i) {
+        values.push_back(i);
+    }
+    avl_tree_build_sorted(&tree, values.data(), 1000);
+
+    // A tenth of the tree goes through the traversal, then half of it through a rebuild.
+    std::vector<int> tenth, half;
+    for (int i = 1; i <= 1000; ++i) {
+        if (i % 10 == 0) tenth.push_back(i);
+        else if (i % 2 == 0) half.push_back(i);
+    }
+    EXPECT_EQ(100, avl_tree_remove_nodes(&tree, tenth.data(), (int)tenth.size()));
+    EXPECT_EQ(900, expect_valid_aggregates(tree.root));
+    EXPECT_EQ(400, avl_tree_remove_nodes(&tree, half.data(), (int)half.size()));
+    EXPECT_EQ(500, expect_valid_aggregates(tree.root));
+    EXPECT_EQ(250000, avl_aggregate(tree.root)->sum);
+
+    // Removed nodes are reused by later insertions.
+    AVLNodePool pool = tree.pool;
+    avl_tree_insert_nodes(&tree, half.data(), (int)half.size());
+    EXPECT_EQ(pool.pages, tree.pool.pages);
+    EXPECT_EQ(pool.pageUsed, tree.pool.pageUsed);
+    EXPECT_EQ(900, expect_valid_aggregates(tree.root));
+}
+
+TEST_F(AVLAggregateTest, ImportShape_HasAggregates) {
+    BTNode nodes[] = { { 20, NULL, NULL }, { 10, NULL, NULL }, { 30, NULL, NULL }, { 25, NULL, NULL } };
+    nodes[0].left = &nodes[1];
+    nodes[0].right = &nodes[2];
+    nodes[2].left = &nodes[3];
+    ASSERT_TRUE(avl_tree_import_shape(&tree, &nodes[0], &btbox_node_accessor, 4));
+
+    EXPECT_EQ(20, tree.root->value);
+    EXPECT_EQ(25, tree.root->right->left->value);
+    EXPECT_EQ(4, expect_valid_aggregates(tree.root));
+    EXPECT_EQ(2, avl_tree_rank(&tree, 25));
+
+    // A chain is rejected and leaves the tree empty.
+    nodes[1].left = &nodes[3];
+    nodes[3] = { 5, NULL, NULL };
+    nodes[2].left = NULL;
+    nodes[3].left = new BTNode{ 1, NULL, NULL };
+    EXPECT_FALSE(avl_tree_import_shape(&tree, &nodes[0], &btbox_node_accessor, 5));
+    EXPECT_EQ(nullptr, tree.root);
+    delete nodes[3].left;
+}
+
+TEST_F(AVLAggregateTest, PlainTree_QueriesUnavailable) {
+    AVLTree plain;
+    avl_tree_init(&plain);
+    avl_tree_insert_node(&plain, 1);
+
+    EXPECT_EQ(sizeof(AVLNode), (size_t)plain.pool.nodeSize);
+    EXPECT_EQ(-1, avl_tree_rank(&plain, 1));
+    EXPECT_EQ(-1, avl_tree_count_range(&plain, 0, 2));
+    EXPECT_EQ(nullptr, avl_tree_select(&plain, 0));
+
+    avl_tree_clear(&plain);
+}
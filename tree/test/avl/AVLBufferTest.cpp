@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "avl_buffer.h"
+#include "AVLTestHelpers.h"
+
+class AVLBufferTest : public ::testing::Test {
+    protected:
+        AVLBufferedTree buffered;
+
+        void SetUp() override {
+            ASSERT_TRUE(avl_buffered_init(&buffered, 64));
+        }
+
+        void TearDown() override {
+            avl_buffered_free(&buffered);
+        }
+};
+
+TEST_F(AVLBufferTest, Changes_PendingUntilRead) {
+    for (int i = 0; i < 10; ++i) {
+        avl_buffered_insert(&buffered, i);
+    }
+    avl_buffered_remove(&buffered, 3);
+    EXPECT_EQ(nullptr, buffered.tree.root);
+    EXPECT_EQ(10, buffered.len);
+
+    // Lookups see pending changes.
+    EXPECT_TRUE(avl_buffered_contains(&buffered, 9));
+    EXPECT_FALSE(avl_buffered_contains(&buffered, 3));
+    EXPECT_FALSE(avl_buffered_contains(&buffered, 10));
+
+    AVLNode* root = avl_buffered_get_root(&buffered);
+    EXPECT_EQ(0, buffered.len);
+    std::vector<int> values;
+    collect(root, values);
+    EXPECT_EQ((std::vector<int>{ 0, 1, 2, 4, 5, 6, 7, 8, 9 }), values);
+
+    // A pending removal hides a value already in the tree.
+    avl_buffered_remove(&buffered, 5);
+    EXPECT_FALSE(avl_buffered_contains(&buffered, 5));
+    EXPECT_TRUE(avl_contains(buffered.tree.root, 5));
+    avl_buffered_insert(&buffered, 5);
+    EXPECT_TRUE(avl_buffered_contains(&buffered, 5));
+    EXPECT_EQ(1, buffered.len);
+}
+
+TEST_F(AVLBufferTest, FullBuffer_IsApplied) {
+    for (int i = 0; i < 64; ++i) {
+        avl_buffered_insert(&buffered, i);
+    }
+    EXPECT_EQ(nullptr, buffered.tree.root);
+    avl_buffered_insert(&buffered, 64);
+    EXPECT_NE(nullptr, buffered.tree.root);
+    EXPECT_EQ(1, buffered.len);
+    expect_valid_avl(avl_buffered_get_root(&buffered), LLONG_MIN, LLONG_MAX);
+}
+
+TEST_F(AVLBufferTest, RandomChanges_MatchStdSet) {
+    std::mt19937 random(21);
+    std::set<int> expected;
+    for (int step = 0; step < 100000; ++step) {
+        int value = (int)(random() % 5000);
+        switch (random() % 4) {
+            case 0:
+            case 1:
+                avl_buffered_insert(&buffered, value);
+                expected.insert(value);
+                break;
+            case 2:
+                avl_buffered_remove(&buffered, value);
+                expected.erase(value);
+                break;
+            default:
+                EXPECT_EQ(expected.count(value) > 0, (bool)avl_buffered_contains(&buffered, value));
+                break;
+        }
+        if (step % 9973 == 0) {
+            expect_valid_avl(avl_buffered_get_root(&buffered), LLONG_MIN, LLONG_MAX);
+        }
+    }
+    std::vector<int> values;
+    collect(avl_buffered_get_root(&buffered), values);
+    EXPECT_EQ(std::vector<int>(expected.begin(), expected.end()), values);
+}
+
+// Opt-in benchmark, run with --gtest_also_run_disabled_tests. Rates are recorded as test properties,
+// e.g. in --gtest_output=xml, and nothing is asserted about them: buffering about doubles the rate of
+// nearly sorted streams and does not help uniformly random ones.
+TEST_F(AVLBufferTest, DISABLED_NearlySortedStream_Throughput) {
+    const int N = 1000000;
+    std::mt19937 random(8);
+    std::vector<int> values(N);
+    for (int i = 0; i < N; ++i) {
+        values[i] = i * 4 + (int)(random() % 64);
+    }
+
+    AVLTree plain;
+    avl_tree_init(&plain);
+    auto start = std::chrono::steady_clock::now();
+    for (int value : values) {
+        avl_tree_insert_node(&plain, value);
+    }
+    double plainTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    AVLBufferedTree large;
+    ASSERT_TRUE(avl_buffered_init(&large, AVL_BUFFER_CAPACITY));
+    start = std::chrono::steady_clock::now();
+    for (int value : values) {
+        avl_buffered_insert(&large, value);
+    }
+    avl_buffered_flush(&large);
+    double bufferedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    RecordProperty("plainInsertsPerSecond", std::to_string((long long)(N / plainTime)));
+    RecordProperty("bufferedInsertsPerSecond", std::to_string((long long)(N / bufferedTime)));
+    std::vector<int> a, b;
+    collect(plain.root, a);
+    collect(large.tree.root, b);
+    EXPECT_EQ(a, b);
+
+    avl_tree_clear(&plain);
+    avl_buffered_free(&large);
+}
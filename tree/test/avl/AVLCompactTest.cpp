@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "avl_compact.h"
+#include "avl_tree.h"
+
+using std::set;
+using std::string;
+
+class AVLCompactTest : public ::testing::Test {
+    protected:
+        AVLCompactTree tree;
+
+        void SetUp() override {
+            avl_compact_init(&tree);
+        }
+
+        void TearDown() override {
+            avl_compact_free_tree(&tree);
+        }
+
+        AVLCompactNode* node(uint32_t index) {
+            return index != AVL_COMPACT_NULL ? tree.nodes + index : nullptr;
+        }
+
+        uint32_t leftOf(uint32_t index) {
+            return tree.nodes[index].left & 0x3FFFFFFFu;
+        }
+
+        int balanceOf(uint32_t index) {
+            return (int)(tree.nodes[index].left >> 30) - 1;
+        }
+
+        // Return height of the subtree, failing if the stored balance factors or the order are wrong.
+        int verify(uint32_t index, long long low, long long high) {
+            if (index == AVL_COMPACT_NULL) {
+                return 0;
+            }
+            int value = tree.nodes[index].value;
+            EXPECT_GT(value, low);
+            EXPECT_LT(value, high);
+            int leftHeight = verify(leftOf(index), low, value);
+            int rightHeight = verify(tree.nodes[index].right, value, high);
+            EXPECT_EQ(balanceOf(index), rightHeight - leftHeight);
+            return 1 + (leftHeight > rightHeight ? leftHeight : rightHeight);
+        }
+
+        void collect(uint32_t index, std::vector<int>& values) {
+            if (index == AVL_COMPACT_NULL) {
+                return;
+            }
+            collect(leftOf(index), values);
+            values.push_back(tree.nodes[index].value);
+            collect(tree.nodes[index].right, values);
+        }
+
+        BTNode* toBTNode(uint32_t index) {
+            if (index == AVL_COMPACT_NULL) {
+                return nullptr;
+            }
+            BTNode* result = btbox_create_node(tree.nodes[index].value);
+            result->left = toBTNode(leftOf(index));
+            result->right = toBTNode(tree.nodes[index].right);
+            return result;
+        }
+};
+
+string printToString(BTBox* box) {
+    FILE* file = tmpfile();
+    btbox_print(file, box);
+    rewind(file);
+    string output;
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        output.append(buffer, read);
+    }
+    fclose(file);
+    return output;
+}
+
+TEST_F(AVLCompactTest, NodeSize) {
+    EXPECT_EQ(12u, sizeof(AVLCompactNode));
+}
+
+TEST_F(AVLCompactTest, EmptyTree) {
+    EXPECT_EQ(nullptr, avl_compact_get_root(&tree));
+    EXPECT_EQ(0, avl_compact_get_height(&tree));
+    EXPECT_EQ(0, avl_compact_contains(&tree, 1));
+    EXPECT_EQ(nullptr, avl_compact_lower_bound(&tree, 1));
+    EXPECT_EQ(0, avl_compact_remove_node(&tree, 1));
+}
+
+// Pre-order dump of values where missing children are written as '.'.
+void dumpShape(const AVLNode* node, string& output) {
+    if (!node) {
+        output += ". ";
+        return;
+    }
+    output += std::to_string(node->value) + " ";
+    dumpShape(node->left, output);
+    dumpShape(node->right, output);
+}
+
+TEST_F(AVLCompactTest, InsertRemove_SameShapeAsAVLNode) {
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> distribution(0, 300);
+    AVLNode* expect = nullptr;
+    for (int i = 0; i < 2000; ++i) {
+        int value = distribution(random);
+        if (i % 3 == 2) {
+            avl_compact_remove_node(&tree, value);
+            avl_remove_node(&expect, value);
+        } else {
+            avl_compact_insert_node(&tree, value);
+            avl_insert_node(&expect, value);
+        }
+
+        BTNode* actualNodes = toBTNode(tree.root);
+        string actualShape, expectShape;
+        dumpShape(expect, expectShape);
+        std::function<void(const BTNode*)> dump = [&](const BTNode* node) {
+            if (!node) {
+                actualShape += ". ";
+                return;
+            }
+            actualShape += std::to_string(node->value) + " ";
+            dump(node->left);
+            dump(node->right);
+        };
+        dump(actualNodes);
+        btbox_free_node(actualNodes);
+        ASSERT_EQ(expectShape, actualShape) << "at operation " << i;
+    }
+    avl_free_tree(&expect);
+}
+
+TEST_F(AVLCompactTest, RandomOperations_MatchStdSet) {
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> distribution(-5000, 5000);
+    set<int> expect;
+    for (int i = 0; i < 20000; ++i) {
+        int value = distribution(random);
+        if (random() % 5 < 2) {
+            EXPECT_EQ((int)expect.erase(value), avl_compact_remove_node(&tree, value));
+        } else {
+            EXPECT_EQ((int)expect.insert(value).second, avl_compact_insert_node(&tree, value));
+        }
+    }
+    EXPECT_EQ((int)expect.size(), tree.size);
+
+    int height = verify(tree.root, INT64_MIN, INT64_MAX);
+    EXPECT_EQ(height, avl_compact_get_height(&tree));
+
+    std::vector<int> values;
+    collect(tree.root, values);
+    EXPECT_EQ(std::vector<int>(expect.begin(), expect.end()), values);
+
+    for (int value = -5010; value <= 5010; value += 7) {
+        auto lower = expect.lower_bound(value);
+        AVLCompactNode* actual = avl_compact_lower_bound(&tree, value);
+        if (lower == expect.end()) {
+            EXPECT_EQ(nullptr, actual);
+        } else {
+            ASSERT_NE(nullptr, actual);
+            EXPECT_EQ(*lower, actual->value);
+        }
+        auto upper = expect.upper_bound(value);
+        actual = avl_compact_upper_bound(&tree, value);
+        if (upper == expect.end()) {
+            EXPECT_EQ(nullptr, actual);
+        } else {
+            ASSERT_NE(nullptr, actual);
+            EXPECT_EQ(*upper, actual->value);
+        }
+        EXPECT_EQ((int)expect.count(value), avl_compact_contains(&tree, value));
+    }
+}
+
+TEST_F(AVLCompactTest, Remove_ReusesReleasedSlots) {
+    for (int i = 0; i < 100; ++i) {
+        avl_compact_insert_node(&tree, i);
+    }
+    uint32_t used = tree.used;
+    for (int i = 0; i < 50; ++i) {
+        avl_compact_remove_node(&tree, i * 2);
+    }
+    for (int i = 0; i < 50; ++i) {
+        avl_compact_insert_node(&tree, 1000 + i);
+    }
+    EXPECT_EQ(used, tree.used);
+    EXPECT_EQ(100, tree.size);
+    verify(tree.root, INT64_MIN, INT64_MAX);
+}
+
+TEST_F(AVLCompactTest, Accessor_PrintsSameAsBTNode) {
+    for (int i = 0; i < 40; ++i) {
+        avl_compact_insert_node(&tree, (i * 37) % 101);
+    }
+    BTNodeAccessor accessor = avl_compact_accessor(&tree);
+    BTBox* actualBox = btbox_create_tree_with(avl_compact_get_root(&tree), &accessor);
+    BTNode* expectNodes = toBTNode(tree.root);
+    BTBox* expectBox = btbox_create_tree(expectNodes);
+
+    EXPECT_EQ(printToString(expectBox), printToString(actualBox));
+
+    btbox_free_tree(actualBox);
+    btbox_free_tree(expectBox);
+    btbox_free_node(expectNodes);
+}
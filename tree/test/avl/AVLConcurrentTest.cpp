@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "avl_concurrent.h"
+
+using std::atomic;
+using std::set;
+using std::thread;
+using std::vector;
+
+class AVLConcurrentTest : public ::testing::Test {
+    protected:
+        AVLConcurrentTree tree;
+
+        void SetUp() override {
+            avl_concurrent_init(&tree);
+        }
+
+        void TearDown() override {
+            avl_concurrent_free_tree(&tree);
+        }
+
+        // Check order and heights of the subtree, return its height.
+        int expect_valid_tree(AVLNode* node, long long low, long long high) {
+            if (!node) return 0;
+            EXPECT_GT(node->value, low);
+            EXPECT_LT(node->value, high);
+            int left = expect_valid_tree(node->left, low, node->value);
+            int right = expect_valid_tree(node->right, node->value, high);
+            EXPECT_LE(std::abs(left - right), 1);
+            EXPECT_EQ(1 + std::max(left, right), node->height);
+            return node->height;
+        }
+
+        // Insert even values from 0 up to [count] * 2, which stay in the tree.
+        void insert_stable_values(int count) {
+            for (int i = 0; i < count; ++i) {
+                avl_concurrent_insert_node(&tree, i * 2);
+            }
+        }
+
+        // Insert and remove odd values until [stop] is set.
+        void churn(atomic<bool>& stop, int count, unsigned int seed) {
+            std::mt19937 random(seed);
+            std::uniform_int_distribution<int> distribution(0, count - 1);
+            while (!stop.load()) {
+                int value = distribution(random) * 2 + 1;
+                if (random() & 1) {
+                    avl_concurrent_insert_node(&tree, value);
+                } else {
+                    avl_concurrent_remove_node(&tree, value);
+                }
+            }
+        }
+};
+
+TEST_F(AVLConcurrentTest, SingleThread_MatchStdSet) {
+    int reader = avl_concurrent_add_reader(&tree);
+    ASSERT_EQ(0, reader);
+
+    std::mt19937 random(5);
+    std::uniform_int_distribution<int> distribution(0, 3000);
+    set<int> expect;
+    for (int i = 0; i < 20000; ++i) {
+        int value = distribution(random);
+        if (random() % 3 == 0) {
+            EXPECT_EQ((int)expect.erase(value), avl_concurrent_remove_node(&tree, value));
+        } else {
+            EXPECT_EQ((int)expect.insert(value).second, avl_concurrent_insert_node(&tree, value));
+        }
+    }
+    EXPECT_EQ((int)expect.size(), tree.size);
+    expect_valid_tree(tree.holder.node.right, LLONG_MIN, LLONG_MAX);
+
+    for (int value = -1; value <= 3001; ++value) {
+        EXPECT_EQ((int)expect.count(value), avl_concurrent_contains(&tree, reader, value));
+        auto lower = expect.lower_bound(value);
+        int result = 0;
+        EXPECT_EQ(lower != expect.end(), avl_concurrent_lower_bound(&tree, reader, value, &result));
+        if (lower != expect.end()) {
+            EXPECT_EQ(*lower, result);
+        }
+    }
+}
+
+TEST_F(AVLConcurrentTest, Readers_RegisterUpToLimit) {
+    for (int i = 0; i < AVL_CONCURRENT_MAX_READERS; ++i) {
+        EXPECT_EQ(i, avl_concurrent_add_reader(&tree));
+    }
+    EXPECT_EQ(-1, avl_concurrent_add_reader(&tree));
+}
+
+TEST_F(AVLConcurrentTest, Stress_ReadersSeeStableValues) {
+    const int count = 2000;
+    insert_stable_values(count);
+
+    atomic<bool> stop(false);
+    atomic<long long> errors(0);
+    atomic<long long> lookups(0);
+    vector<thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&, t]() {
+            int reader = avl_concurrent_add_reader(&tree);
+            std::mt19937 random(100 + t);
+            std::uniform_int_distribution<int> distribution(0, count - 1);
+            long long done = 0;
+            while (!stop.load()) {
+                int value = distribution(random) * 2;
+                errors += !avl_concurrent_contains(&tree, reader, value);
+                // Never inserted.
+                errors += avl_concurrent_contains(&tree, reader, -value - 1);
+                // The next stable value is at most one step away.
+                int result = -1;
+                int found = avl_concurrent_lower_bound(&tree, reader, value - 1, &result);
+                errors += !found || (result != value - 1 && result != value);
+                ++done;
+            }
+            lookups += done;
+        });
+    }
+    vector<thread> writers;
+    for (int t = 0; t < 2; ++t) {
+        writers.emplace_back([&, t]() { churn(stop, count, 7 + t); });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    stop = true;
+    for (thread& reader : readers) reader.join();
+    for (thread& writer : writers) writer.join();
+
+    EXPECT_EQ(0, errors.load());
+    EXPECT_GT(lookups.load(), 0);
+    expect_valid_tree(tree.holder.node.right, LLONG_MIN, LLONG_MAX);
+
+    int reader = avl_concurrent_add_reader(&tree);
+    int size = 0;
+    for (int value = 0; value < count * 2; ++value) {
+        size += avl_concurrent_contains(&tree, reader, value);
+    }
+    EXPECT_EQ(tree.size, size);
+}
+
+// Opt-in benchmark, run with --gtest_also_run_disabled_tests. Lookup rates per reader count are
+// recorded as test properties, e.g. in --gtest_output=xml.
+TEST_F(AVLConcurrentTest, DISABLED_Benchmark_ReadThroughput) {
+    const int count = 100000;
+    insert_stable_values(count);
+
+    int maxThreads = std::max(2u, std::min(8u, thread::hardware_concurrency()));
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        atomic<bool> stop(false);
+        atomic<long long> lookups(0);
+        vector<thread> readers;
+        for (int t = 0; t < threads; ++t) {
+            readers.emplace_back([&, t]() {
+                int reader = avl_concurrent_add_reader(&tree);
+                std::mt19937 random(t);
+                std::uniform_int_distribution<int> distribution(0, count * 2);
+                long long done = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    done += avl_concurrent_contains(&tree, reader, distribution(random)) >= 0;
+                }
+                lookups += done;
+            });
+        }
+        thread writer([&]() { churn(stop, count, 1); });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        stop = true;
+        for (thread& reader : readers) reader.join();
+        writer.join();
+
+        RecordProperty("lookupsPerSecondWith" + std::to_string(threads) + "Readers", std::to_string((long long)(lookups.load() / 0.2)));
+        EXPECT_GT(lookups.load(), 0);
+    }
+}
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <climits>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "avl_tree.h"
+#include "AVLTestHelpers.h"
+
+class AVLCursorTest : public ::testing::Test {
+    protected:
+        AVLTree tree;
+        AVLCursor cursor;
+
+        void SetUp() override {
+            avl_tree_init(&tree);
+            avl_cursor_init(&cursor, &tree);
+        }
+
+        void TearDown() override {
+            avl_tree_clear(&tree);
+        }
+};
+
+TEST_F(AVLCursorTest, Insert_SortedStream) {
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_TRUE(avl_cursor_insert(&cursor, i));
+        ASSERT_NE(nullptr, avl_cursor_get(&cursor));
+        EXPECT_EQ(i, avl_cursor_get(&cursor)->value);
+    }
+    EXPECT_FALSE(avl_cursor_insert(&cursor, 5000));
+    EXPECT_EQ(5000, avl_cursor_get(&cursor)->value);
+
+    expect_valid_avl(tree.root, LLONG_MIN, LLONG_MAX);
+    std::vector<int> values;
+    collect(tree.root, values);
+    ASSERT_EQ(10000, (int)values.size());
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_EQ(i, values[i]);
+    }
+}
+
+TEST_F(AVLCursorTest, Insert_NearSortedStreamComparesLess) {
+    BSTStats fromRoot = {};
+    BSTStats fromCursor = {};
+    AVLTree other;
+    avl_tree_init(&other);
+    other.stats = &fromRoot;
+    tree.stats = &fromCursor;
+
+    // Timestamps arriving slightly out of order.
+    std::mt19937 random(3);
+    for (int i = 0; i < 100000; ++i) {
+        int value = i * 4 + (int)(random() % 8);
+        avl_tree_insert_node(&other, value);
+        avl_cursor_insert(&cursor, value);
+    }
+    EXPECT_LT(fromCursor.comparisons * 2, fromRoot.comparisons);
+    expect_valid_avl(tree.root, LLONG_MIN, LLONG_MAX);
+
+    tree.stats = NULL;
+    avl_tree_clear(&other);
+}
+
+TEST_F(AVLCursorTest, Find_MovesFinger) {
+    for (int i = 0; i < 100; i += 2) {
+        avl_tree_insert_node(&tree, i);
+    }
+    ASSERT_NE(nullptr, avl_cursor_find(&cursor, 40));
+    EXPECT_EQ(40, avl_cursor_get(&cursor)->value);
+    EXPECT_EQ(nullptr, avl_cursor_find(&cursor, 41));
+    EXPECT_EQ(nullptr, avl_cursor_get(&cursor));
+    ASSERT_NE(nullptr, avl_cursor_find(&cursor, 98));
+    ASSERT_NE(nullptr, avl_cursor_find(&cursor, 0));
+    EXPECT_EQ(nullptr, avl_cursor_find(&cursor, -1));
+    EXPECT_EQ(nullptr, avl_cursor_find(&cursor, 1000));
+}
+
+TEST_F(AVLCursorTest, Remove_AtCursor) {
+    for (int i = 0; i < 1000; ++i) {
+        avl_tree_insert_node(&tree, i);
+    }
+    EXPECT_FALSE(avl_cursor_remove(&cursor));
+
+    // Drain the tree in order, each removal starting next to the previous one.
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_NE(nullptr, avl_cursor_find(&cursor, i));
+        EXPECT_TRUE(avl_cursor_remove(&cursor));
+        EXPECT_EQ(nullptr, avl_cursor_get(&cursor));
+        EXPECT_FALSE(avl_cursor_remove(&cursor));
+        if (i % 97 == 0) {
+            expect_valid_avl(tree.root, i, LLONG_MAX);
+        }
+    }
+    EXPECT_EQ(nullptr, tree.root);
+}
+
+TEST_F(AVLCursorTest, RandomOperations_MatchStdSet) {
+    std::mt19937 random(11);
+    std::set<int> expected;
+    int position = 0;
+    for (int step = 0; step < 50000; ++step) {
+        // Walk around the key space in small steps, like a finger would be used.
+        position += (int)(random() % 41) - 20;
+        int operation = random() % 3;
+        if (operation == 0) {
+            EXPECT_EQ(expected.insert(position).second, (bool)avl_cursor_insert(&cursor, position));
+        } else if (operation == 1) {
+            AVLNode* node = avl_cursor_find(&cursor, position);
+            EXPECT_EQ(expected.count(position) > 0, node != nullptr);
+            if (node) {
+                EXPECT_TRUE(avl_cursor_remove(&cursor));
+                expected.erase(position);
+            }
+        } else {
+            AVLNode* node = avl_cursor_find(&cursor, position);
+            EXPECT_EQ(expected.count(position) > 0, node != nullptr);
+        }
+    }
+    expect_valid_avl(tree.root, LLONG_MIN, LLONG_MAX);
+    std::vector<int> values;
+    collect(tree.root, values);
+    EXPECT_EQ(std::vector<int>(expected.begin(), expected.end()), values);
+}
+
+TEST_F(AVLCursorTest, OtherChanges_ResetCursor) {
+    for (int i = 0; i < 100; ++i) {
+        avl_cursor_insert(&cursor, i);
+    }
+    ASSERT_NE(nullptr, avl_cursor_find(&cursor, 50));
+
+    // Changes made without the cursor may rotate nodes on its path.
+    avl_tree_remove_node(&tree, 50);
+    EXPECT_EQ(nullptr, avl_cursor_get(&cursor));
+    EXPECT_FALSE(avl_cursor_remove(&cursor));
+    EXPECT_EQ(nullptr, avl_cursor_find(&cursor, 50));
+    EXPECT_NE(nullptr, avl_cursor_find(&cursor, 51));
+
+    avl_tree_clear(&tree);
+    EXPECT_EQ(nullptr, avl_cursor_find(&cursor, 51));
+    EXPECT_TRUE(avl_cursor_insert(&cursor, 51));
+    EXPECT_EQ(51, tree.root->value);
+}
+
+TEST_F(AVLCursorTest, Insert_KeepsAggregates) {
+    avl_tree_clear(&tree);
+    avl_tree_init_augmented(&tree, AVL_AUGMENT_AGGREGATES);
+    avl_cursor_init(&cursor, &tree);
+    for (int i = 0; i < 2000; ++i) {
+        avl_cursor_insert(&cursor, i);
+    }
+    for (int i = 0; i < 2000; i += 2) {
+        avl_cursor_find(&cursor, i);
+        avl_cursor_remove(&cursor);
+    }
+    EXPECT_EQ(1000, avl_aggregate(tree.root)->count);
+    EXPECT_EQ(1, avl_aggregate(tree.root)->min);
+    EXPECT_EQ(1999, avl_aggregate(tree.root)->max);
+    EXPECT_EQ(500, avl_tree_rank(&tree, 1000));
+}
+
+TEST_F(AVLCursorTest, DegenerateTree_DeeperThanCursor) {
+    // A root with a right-leaning chain of even values as its left subtree, deeper than a cursor can record.
+    const int N = 1000;
+    tree.root = avl_tree_create_node(&tree, N * 2);
+    tree.root->height = N + 1;
+    AVLNode** link = &tree.root->left;
+    for (int i = 0; i < N; ++i) {
+        *link = avl_tree_create_node(&tree, i * 2);
+        (*link)->height = N - i;
+        link = &(*link)->right;
+    }
+
+    ASSERT_NE(nullptr, avl_cursor_find(&cursor, 20));
+    EXPECT_EQ(20, avl_cursor_get(&cursor)->value);
+    ASSERT_NE(nullptr, avl_cursor_find(&cursor, 1800));
+    EXPECT_EQ(1800, avl_cursor_find(&cursor, 1800)->value);
+    EXPECT_EQ(nullptr, avl_cursor_get(&cursor));
+    EXPECT_EQ(nullptr, avl_cursor_find(&cursor, 1801));
+
+    EXPECT_FALSE(avl_cursor_insert(&cursor, 1600));
+    EXPECT_TRUE(avl_cursor_insert(&cursor, 1601));
+    EXPECT_TRUE(avl_contains(tree.root, 1601));
+
+    // The maximum of the root's left subtree is beyond the cursor's depth.
+    ASSERT_NE(nullptr, avl_cursor_find(&cursor, N * 2));
+    EXPECT_TRUE(avl_cursor_remove(&cursor));
+    EXPECT_FALSE(avl_contains(tree.root, N * 2));
+    EXPECT_TRUE(avl_contains(tree.root, N * 2 - 2));
+    EXPECT_TRUE(avl_contains(tree.root, 0));
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "avl_tree.h"
+
+using std::map;
+using std::pair;
+using std::vector;
+
+typedef vector<pair<int, int>> Intervals;
+
+class AVLIntervalTest : public ::testing::TestWithParam<int> {
+    protected:
+        AVLTree tree;
+
+        void SetUp() override {
+            avl_tree_init_augmented(&tree, GetParam());
+        }
+
+        void TearDown() override {
+            avl_tree_clear(&tree);
+        }
+
+        static void collect_interval(int low, int high, void* context) {
+            ((Intervals*)context)->push_back({ low, high });
+        }
+
+        Intervals overlap(int low, int high) {
+            Intervals result;
+            int visited = avl_tree_overlap(&tree, low, high, collect_interval, &result);
+            EXPECT_EQ(visited, (int)result.size());
+            return result;
+        }
+
+        Intervals stab(int point) {
+            Intervals result;
+            int visited = avl_tree_stab(&tree, point, collect_interval, &result);
+            EXPECT_EQ(visited, (int)result.size());
+            return result;
+        }
+
+        // Check every node's largest high end against its subtree, return it.
+        int expect_valid_intervals(AVLNode* node) {
+            if (!node) return INT_MIN;
+            AVLInterval* interval = avl_interval(&tree, node);
+            EXPECT_LE(node->value, interval->high);
+            int maxHigh = std::max({ interval->high, expect_valid_intervals(node->left), expect_valid_intervals(node->right) });
+            EXPECT_EQ(maxHigh, interval->maxHigh);
+            return maxHigh;
+        }
+
+        static Intervals brute_overlap(const map<int, int>& intervals, int low, int high) {
+            Intervals result;
+            for (auto& interval : intervals) {
+                if (interval.first <= high && interval.second >= low) {
+                    result.push_back(interval);
+                }
+            }
+            return result;
+        }
+};
+
+TEST_P(AVLIntervalTest, InsertInterval_RejectsInvalid) {
+    EXPECT_TRUE(avl_tree_insert_interval(&tree, 3, 9));
+    EXPECT_FALSE(avl_tree_insert_interval(&tree, 3, 4));
+    EXPECT_FALSE(avl_tree_insert_interval(&tree, 10, 9));
+    EXPECT_TRUE(avl_tree_insert_interval(&tree, 10, 10));
+
+    // Plain insertions are intervals of one point.
+    EXPECT_TRUE(avl_tree_insert_node(&tree, 20));
+    EXPECT_EQ((Intervals{ { 20, 20 } }), stab(20));
+    EXPECT_EQ((Intervals{ { 3, 9 } }), stab(5));
+    EXPECT_EQ((Intervals{ { 3, 9 }, { 10, 10 } }), overlap(9, 19));
+    EXPECT_TRUE(overlap(11, 19).empty());
+    EXPECT_TRUE(overlap(9, 3).empty());
+    expect_valid_intervals(tree.root);
+}
+
+TEST_P(AVLIntervalTest, RandomOperations_MatchBruteForce) {
+    std::mt19937 random(20);
+    map<int, int> expected;
+    for (int step = 0; step < 50000; ++step) {
+        int low = (int)(random() % 10000);
+        int high = low + (int)(random() % (random() % 8 ? 50 : 2000));
+        switch (random() % 4) {
+            case 0:
+                EXPECT_EQ((int)expected.erase(low), avl_tree_remove_node(&tree, low));
+                break;
+            case 1:
+                EXPECT_EQ(brute_overlap(expected, low, high), overlap(low, high));
+                EXPECT_EQ(brute_overlap(expected, low, low), stab(low));
+                break;
+            default:
+                EXPECT_EQ(expected.insert({ low, high }).second, (bool)avl_tree_insert_interval(&tree, low, high));
+        }
+        if (step % 5000 == 0) {
+            expect_valid_intervals(tree.root);
+        }
+    }
+    expect_valid_intervals(tree.root);
+    EXPECT_EQ(Intervals(expected.begin(), expected.end()), overlap(INT_MIN, INT_MAX));
+
+    // Batch removals rebuild or join subtrees, the largest high ends must follow.
+    vector<int> lows;
+    for (auto& interval : expected) {
+        if (interval.first % 3 == 0) lows.push_back(interval.first);
+    }
+    avl_tree_remove_nodes(&tree, lows.data(), (int)lows.size());
+    for (int low : lows) expected.erase(low);
+    expect_valid_intervals(tree.root);
+    EXPECT_EQ(brute_overlap(expected, 4000, 4100), overlap(4000, 4100));
+}
+
+TEST_P(AVLIntervalTest, Print_IntervalLabels) {
+    avl_tree_insert_interval(&tree, 3, 9);
+    avl_tree_insert_interval(&tree, -2, 40);
+    avl_tree_insert_interval(&tree, 15, 16);
+
+    BTNodeAccessor accessor = avl_tree_interval_accessor(&tree);
+    FILE* file = tmpfile();
+    ASSERT_NE(nullptr, file);
+    btbox_print_with(file, tree.root, &accessor);
+
+    std::string output(4096, '\0');
+    rewind(file);
+    output.resize(fread(&output[0], 1, output.size(), file));
+    fclose(file);
+    EXPECT_NE(std::string::npos, output.find("| [3, 9] |"));
+    EXPECT_NE(std::string::npos, output.find("| [-2, 40] |"));
+    EXPECT_NE(std::string::npos, output.find("| [15, 16] |"));
+}
+
+INSTANTIATE_TEST_SUITE_P(Augments, AVLIntervalTest,
+    ::testing::Values(AVL_AUGMENT_INTERVALS, AVL_AUGMENT_INTERVALS | AVL_AUGMENT_AGGREGATES));
+
+TEST(AVLIntervalPlainTest, Queries_NeedIntervals) {
+    AVLTree tree;
+    avl_tree_init(&tree);
+    EXPECT_FALSE(avl_tree_insert_interval(&tree, 1, 2));
+    EXPECT_EQ(-1, avl_tree_stab(&tree, 1, nullptr, nullptr));
+    avl_tree_clear(&tree);
+}
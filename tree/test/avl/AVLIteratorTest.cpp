@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include <climits>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "avl_iterator.h"
+
+class AVLIteratorTest : public ::testing::Test {
+    protected:
+        AVLTree tree;
+
+        void SetUp() override {
+            avl_tree_init(&tree);
+        }
+
+        void TearDown() override {
+            avl_tree_clear(&tree);
+        }
+
+        std::vector<int> walk(AVLIterator* iterator) {
+            std::vector<int> result;
+            for (AVLNode* node = avl_iterator_next(iterator); node; node = avl_iterator_next(iterator)) {
+                result.push_back(node->value);
+            }
+            return result;
+        }
+};
+
+TEST_F(AVLIteratorTest, Walk_ForwardAndReverse) {
+    std::mt19937 random(5);
+    std::set<int> expected;
+    for (int i = 0; i < 5000; ++i) {
+        int value = (int)(random() % 20000) - 10000;
+        expected.insert(value);
+        avl_tree_insert_node(&tree, value);
+    }
+
+    AVLIterator iterator;
+    avl_iterator_init(&iterator, tree.root, 0);
+    EXPECT_EQ(std::vector<int>(expected.begin(), expected.end()), walk(&iterator));
+    EXPECT_EQ(nullptr, avl_iterator_next(&iterator));
+
+    avl_iterator_init(&iterator, tree.root, 1);
+    EXPECT_EQ(std::vector<int>(expected.rbegin(), expected.rend()), walk(&iterator));
+}
+
+TEST_F(AVLIteratorTest, Walk_EmptyAndSingleNode) {
+    AVLIterator iterator;
+    avl_iterator_init(&iterator, NULL, 0);
+    EXPECT_EQ(nullptr, avl_iterator_next(&iterator));
+
+    avl_tree_insert_node(&tree, INT_MAX);
+    avl_iterator_init(&iterator, tree.root, 1);
+    EXPECT_EQ(std::vector<int>{INT_MAX}, walk(&iterator));
+    avl_iterator_range(&iterator, tree.root, INT_MIN, INT_MAX, 0);
+    EXPECT_EQ(std::vector<int>{INT_MAX}, walk(&iterator));
+}
+
+TEST_F(AVLIteratorTest, Range_MatchesStdSet) {
+    std::set<int> expected;
+    for (int i = 0; i < 3000; i += 3) {
+        expected.insert(i);
+        avl_tree_insert_node(&tree, i);
+    }
+
+    const int bounds[][2] = { { 0, 2999 }, { 1, 2 }, { 3, 3 }, { 100, 200 }, { -50, 10 }, { 2990, 5000 }, { 50, 40 } };
+    for (const auto& bound : bounds) {
+        std::vector<int> forward;
+        if (bound[0] <= bound[1]) {
+            forward.assign(expected.lower_bound(bound[0]), expected.upper_bound(bound[1]));
+        }
+        std::vector<int> backward(forward.rbegin(), forward.rend());
+
+        AVLIterator iterator;
+        avl_iterator_range(&iterator, tree.root, bound[0], bound[1], 0);
+        EXPECT_EQ(forward, walk(&iterator)) << bound[0] << ", " << bound[1];
+        avl_iterator_range(&iterator, tree.root, bound[0], bound[1], 1);
+        EXPECT_EQ(backward, walk(&iterator)) << bound[0] << ", " << bound[1];
+    }
+}
+
+TEST_F(AVLIteratorTest, Walk_DegenerateTreeDeeperThanStack) {
+    // A chain is no valid AVL tree, but walks over it must still be complete and in order.
+    const int N = AVL_ITERATOR_DEPTH * 5;
+    std::vector<AVLNode> nodes(N);
+    for (int i = 0; i < N; ++i) {
+        nodes[i] = AVLNode{ i % 2 ? N - 1 - i / 2 : i / 2, 1, NULL, NULL };
+    }
+    // Zig-zag chain: 0 -> N-1 -> 1 -> N-2 -> ... so that both directions fill the stack.
+    for (int i = 0; i + 1 < N; ++i) {
+        if (i % 2) nodes[i].left = &nodes[i + 1];
+        else nodes[i].right = &nodes[i + 1];
+    }
+
+    std::vector<int> expected;
+    for (int i = 0; i < N; ++i) expected.push_back(i);
+    AVLIterator iterator;
+    avl_iterator_init(&iterator, &nodes[0], 0);
+    EXPECT_EQ(expected, walk(&iterator));
+
+    std::vector<int> reversed(expected.rbegin(), expected.rend());
+    avl_iterator_init(&iterator, &nodes[0], 1);
+    EXPECT_EQ(reversed, walk(&iterator));
+
+    avl_iterator_range(&iterator, &nodes[0], 10, N - 10, 0);
+    EXPECT_EQ(std::vector<int>(expected.begin() + 10, expected.end() - 9), walk(&iterator));
+
+    // A left-leaning chain keeps every node pending on a forward walk.
+    for (int i = 0; i < N; ++i) {
+        nodes[i] = AVLNode{ N - 1 - i, 1, i + 1 < N ? &nodes[i + 1] : NULL, NULL };
+    }
+    avl_iterator_init(&iterator, &nodes[0], 0);
+    EXPECT_EQ(expected, walk(&iterator));
+}
+
+TEST_F(AVLIteratorTest, SuccessorAndPredecessor) {
+    int values[]{ 10, 20, 30, 40 };
+    avl_tree_insert_nodes(&tree, values, 4);
+
+    EXPECT_EQ(10, avl_successor(tree.root, 5)->value);
+    EXPECT_EQ(30, avl_successor(tree.root, 20)->value);
+    EXPECT_EQ(nullptr, avl_successor(tree.root, 40));
+    EXPECT_EQ(nullptr, avl_predecessor(tree.root, 10));
+    EXPECT_EQ(10, avl_predecessor(tree.root, 20)->value);
+    EXPECT_EQ(40, avl_predecessor(tree.root, 100)->value);
+    EXPECT_EQ(nullptr, avl_predecessor(NULL, 1));
+}
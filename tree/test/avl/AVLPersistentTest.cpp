@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "avl_persistent.h"
+
+using std::set;
+using std::vector;
+
+class AVLPersistentTest : public ::testing::Test {
+    protected:
+        vector<AVLNode*> versions;
+
+        void TearDown() override {
+            for (AVLNode* version : versions) {
+                avl_persistent_release(version);
+            }
+        }
+
+        vector<int> values_of(AVLNode* root) {
+            vector<int> values;
+            std::function<void(AVLNode*)> collect = [&](AVLNode* node) {
+                if (!node) return;
+                collect(node->left);
+                values.push_back(node->value);
+                collect(node->right);
+            };
+            collect(root);
+            return values;
+        }
+
+        void collect_nodes(AVLNode* node, set<AVLNode*>& nodes) {
+            if (!node) return;
+            nodes.insert(node);
+            collect_nodes(node->left, nodes);
+            collect_nodes(node->right, nodes);
+        }
+
+        int expect_balanced(AVLNode* node) {
+            if (!node) return 0;
+            int left = expect_balanced(node->left);
+            int right = expect_balanced(node->right);
+            EXPECT_LE(std::abs(left - right), 1);
+            EXPECT_EQ(1 + std::max(left, right), node->height);
+            return node->height;
+        }
+
+        std::string shape_of(AVLNode* node) {
+            if (!node) return ".";
+            return "(" + shape_of(node->left) + std::to_string(node->value) + shape_of(node->right) + ")";
+        }
+};
+
+TEST_F(AVLPersistentTest, Versions_KeepTheirContent) {
+    std::mt19937 random(3);
+    std::uniform_int_distribution<int> distribution(0, 500);
+    vector<set<int>> expects;
+    AVLNode* current = nullptr;
+    set<int> expect;
+    for (int i = 0; i < 1000; ++i) {
+        int value = distribution(random);
+        if (random() % 3 == 0) {
+            current = avl_persistent_remove_node(current, value);
+            expect.erase(value);
+        } else {
+            current = avl_persistent_insert_node(current, value);
+            expect.insert(value);
+        }
+        versions.push_back(current);
+        expects.push_back(expect);
+    }
+
+    for (size_t i = 0; i < versions.size(); ++i) {
+        ASSERT_EQ(vector<int>(expects[i].begin(), expects[i].end()), values_of(versions[i])) << "version " << i;
+        expect_balanced(versions[i]);
+    }
+}
+
+TEST_F(AVLPersistentTest, SameShapesAsAVLTree) {
+    std::mt19937 random(9);
+    std::uniform_int_distribution<int> distribution(0, 200);
+    AVLNode* expect = nullptr;
+    AVLNode* current = nullptr;
+    for (int i = 0; i < 2000; ++i) {
+        int value = distribution(random);
+        AVLNode* next;
+        if (random() % 3 == 0) {
+            next = avl_persistent_remove_node(current, value);
+            avl_remove_node(&expect, value);
+        } else {
+            next = avl_persistent_insert_node(current, value);
+            avl_insert_node(&expect, value);
+        }
+        avl_persistent_release(current);
+        current = next;
+        ASSERT_EQ(shape_of(expect), shape_of(current)) << "operation " << i;
+    }
+    versions.push_back(current);
+    avl_free_tree(&expect);
+}
+
+TEST_F(AVLPersistentTest, Insert_SharesUntouchedSubtrees) {
+    AVLNode* current = nullptr;
+    for (int i = 0; i < 10000; ++i) {
+        AVLNode* next = avl_persistent_insert_node(current, i * 2);
+        avl_persistent_release(current);
+        current = next;
+    }
+    versions.push_back(current);
+
+    AVLNode* inserted = avl_persistent_insert_node(current, 5001);
+    versions.push_back(inserted);
+    AVLNode* removed = avl_persistent_remove_node(current, 8000);
+    versions.push_back(removed);
+
+    set<AVLNode*> oldNodes, insertedNodes, removedNodes;
+    collect_nodes(current, oldNodes);
+    collect_nodes(inserted, insertedNodes);
+    collect_nodes(removed, removedNodes);
+    int newOnInsert = 0, newOnRemove = 0;
+    for (AVLNode* node : insertedNodes) newOnInsert += !oldNodes.count(node);
+    for (AVLNode* node : removedNodes) newOnRemove += !oldNodes.count(node);
+
+    // The copied path and a few nodes for rotations.
+    EXPECT_LE(newOnInsert, current->height + 3);
+    EXPECT_LE(newOnRemove, 2 * current->height + 3);
+    EXPECT_EQ(10001u, insertedNodes.size());
+    EXPECT_EQ(9999u, removedNodes.size());
+}
+
+TEST_F(AVLPersistentTest, Release_KeepsOtherVersionsIntact) {
+    AVLNode* base = nullptr;
+    for (int i = 0; i < 100; ++i) {
+        AVLNode* next = avl_persistent_insert_node(base, i);
+        avl_persistent_release(base);
+        base = next;
+    }
+    AVLNode* a = avl_persistent_remove_node(base, 50);
+    AVLNode* b = avl_persistent_insert_node(base, 1000);
+    avl_persistent_release(base);
+    versions.push_back(b);
+
+    vector<int> expect;
+    for (int i = 0; i < 100; ++i) expect.push_back(i);
+    expect.erase(expect.begin() + 50);
+    EXPECT_EQ(expect, values_of(a));
+    avl_persistent_release(a);
+
+    expect.insert(expect.begin() + 50, 50);
+    expect.push_back(1000);
+    EXPECT_EQ(expect, values_of(b));
+
+    // Once b is the only version left, none of its nodes is shared anymore.
+    set<AVLNode*> nodes;
+    collect_nodes(b, nodes);
+    for (AVLNode* node : nodes) {
+        EXPECT_EQ(1, ((AVLPersistentNode*)node)->refCount);
+    }
+}
+
+TEST_F(AVLPersistentTest, UnchangedVersion_IsRetained) {
+    AVLNode* root = avl_persistent_insert_node(nullptr, 1);
+    AVLNode* same = avl_persistent_insert_node(root, 1);
+    AVLNode* notRemoved = avl_persistent_remove_node(root, 2);
+    EXPECT_EQ(root, same);
+    EXPECT_EQ(root, notRemoved);
+    EXPECT_EQ(3, ((AVLPersistentNode*)root)->refCount);
+    versions.push_back(root);
+    versions.push_back(same);
+    versions.push_back(notRemoved);
+
+    AVLNode* empty = avl_persistent_remove_node(root, 1);
+    EXPECT_EQ(nullptr, empty);
+}
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+
+#include "avl_tree.h"
+#include "avl_pool.h"
+
+class AVLPoolTest : public ::testing::Test {
+    protected:
+        AVLNodePool pool;
+        AVLTree tree;
+
+        void SetUp() override {
+            avl_pool_init(&pool, sizeof(AVLNode));
+            avl_tree_init(&tree);
+        }
+
+        void TearDown() override {
+            avl_pool_free(&pool);
+            avl_tree_clear(&tree);
+        }
+};
+
+TEST_F(AVLPoolTest, Alloc_ContiguousNodes) {
+    AVLNode* first = avl_pool_alloc(&pool);
+    AVLNode* second = avl_pool_alloc(&pool);
+    AVLNode* third = avl_pool_alloc(&pool);
+
+    ASSERT_NE(nullptr, first);
+    EXPECT_EQ(first + 1, second);
+    EXPECT_EQ(second + 1, third);
+}
+
+TEST_F(AVLPoolTest, Release_NodeIsReused) {
+    AVLNode* first = avl_pool_alloc(&pool);
+    AVLNode* second = avl_pool_alloc(&pool);
+
+    avl_pool_release(&pool, first);
+    avl_pool_release(&pool, second);
+
+    // Released nodes are handed out again, most recently released first.
+    EXPECT_EQ(second, avl_pool_alloc(&pool));
+    EXPECT_EQ(first, avl_pool_alloc(&pool));
+    EXPECT_EQ(second + 1, avl_pool_alloc(&pool));
+}
+
+TEST_F(AVLPoolTest, Free_ManyPages) {
+    for (int i = 0; i < 100000; ++i) {
+        ASSERT_NE(nullptr, avl_pool_alloc(&pool));
+    }
+
+    avl_pool_free(&pool);
+
+    EXPECT_EQ(nullptr, pool.pages);
+    EXPECT_EQ(nullptr, pool.freeList);
+}
+
+TEST_F(AVLPoolTest, Tree_SameShapeAsHeapTree) {
+    int values[]{10, 5, 45, 7, 40, 6, 25, 30, 4, 8, 44, 22, 28, 35};
+    AVLNode* heapRoot = avl_create_tree(values, 14);
+    avl_tree_insert_nodes(&tree, values, 14);
+    avl_remove_node(&heapRoot, 44);
+    avl_tree_remove_node(&tree, 44);
+
+    std::function<void(AVLNode*, AVLNode*)> expect_same = [&](AVLNode* expected, AVLNode* actual) {
+        if (!expected) {
+            EXPECT_EQ(nullptr, actual);
+            return;
+        }
+        ASSERT_NE(nullptr, actual);
+        EXPECT_EQ(expected->value, actual->value);
+        EXPECT_EQ(expected->height, actual->height);
+        expect_same(expected->left, actual->left);
+        expect_same(expected->right, actual->right);
+    };
+    expect_same(heapRoot, tree.root);
+
+    avl_free_tree(&heapRoot);
+}
+
+TEST_F(AVLPoolTest, Tree_RemovedNodeIsReused) {
+    int values[]{20, 10, 30};
+    avl_tree_insert_nodes(&tree, values, 3);
+    AVLNode* removed = tree.root->right;
+
+    EXPECT_TRUE(avl_tree_remove_node(&tree, 30));
+    EXPECT_TRUE(avl_tree_insert_node(&tree, 25));
+
+    EXPECT_EQ(removed, tree.root->right);
+    EXPECT_EQ(25, tree.root->right->value);
+}
+
+TEST_F(AVLPoolTest, Tree_InsertIntoEmptyTree) {
+    EXPECT_TRUE(avl_tree_insert_node(&tree, 1));
+    EXPECT_FALSE(avl_tree_insert_node(&tree, 1));
+    EXPECT_FALSE(avl_tree_remove_node(&tree, 2));
+    EXPECT_TRUE(avl_tree_remove_node(&tree, 1));
+    EXPECT_EQ(nullptr, tree.root);
+    EXPECT_FALSE(avl_tree_remove_node(&tree, 1));
+}
+
+TEST_F(AVLPoolTest, Tree_Build_ReplacesContent) {
+    avl_tree_insert_node(&tree, 100);
+    int values[]{3, 1, 2, 3};
+
+    EXPECT_TRUE(avl_tree_build(&tree, values, 4));
+
+    EXPECT_EQ(2, tree.root->value);
+    EXPECT_EQ(1, tree.root->left->value);
+    EXPECT_EQ(3, tree.root->right->value);
+    EXPECT_EQ(2, tree.root->height);
+
+    int sorted[]{10, 20};
+    EXPECT_TRUE(avl_tree_build_sorted(&tree, sorted, 2));
+
+    EXPECT_EQ(10, tree.root->value);
+    EXPECT_EQ(20, tree.root->right->value);
+    EXPECT_EQ(nullptr, tree.root->left);
+}
+
+TEST_F(AVLPoolTest, Tree_DegenerateTree_NoStackOverflow) {
+    // A right-leaning chain as deep as an imported unbalanced diagram could be.
+    const int N = 1000000;
+    AVLNode** link = &tree.root;
+    for (int i = 0; i < N; ++i) {
+        *link = avl_tree_create_node(&tree, i);
+        (*link)->height = N - i;
+        link = &(*link)->right;
+    }
+
+    // Rotation at the bottom keeps the height, so rebalancing stops right there.
+    EXPECT_TRUE(avl_tree_insert_node(&tree, N));
+    EXPECT_EQ(N, tree.root->height);
+    EXPECT_TRUE(avl_contains(tree.root, N));
+
+    EXPECT_TRUE(avl_tree_remove_node(&tree, N - 2));
+    EXPECT_FALSE(avl_tree_remove_node(&tree, N - 2));
+    EXPECT_TRUE(avl_tree_remove_node(&tree, 0));
+    EXPECT_EQ(1, tree.root->value);
+    EXPECT_FALSE(avl_tree_insert_node(&tree, N - 1));
+}
+
+TEST_F(AVLPoolTest, Tree_Clear) {
+    for (int i = 0; i < 1000; ++i) {
+        avl_tree_insert_node(&tree, i);
+    }
+    EXPECT_EQ(10, tree.root->height);
+
+    avl_tree_clear(&tree);
+
+    EXPECT_EQ(nullptr, tree.root);
+    EXPECT_EQ(nullptr, tree.pool.pages);
+    EXPECT_TRUE(avl_tree_insert_node(&tree, 1));
+}
@@ -0,0 +1,313 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <climits>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "avl_tree.h"
+#include "AVLTestHelpers.h"
+
+class AVLSetOpsTest : public ::testing::TestWithParam<int> {
+    protected:
+        AVLTree tree;
+        AVLTree other;
+
+        void SetUp() override {
+            avl_tree_init(&tree);
+            avl_tree_init(&other);
+        }
+
+        void TearDown() override {
+            avl_tree_clear(&tree);
+            avl_tree_clear(&other);
+        }
+
+        std::vector<int> values(AVLNode* root) {
+            std::vector<int> result;
+            collect(root, result);
+            return result;
+        }
+
+        std::vector<int> random_values(std::mt19937& random, int count, int range) {
+            std::vector<int> result(count);
+            std::uniform_int_distribution<int> distribution(0, range);
+            for (int& value : result) {
+                value = distribution(random);
+            }
+            return result;
+        }
+
+        void fill(AVLTree* target, const std::vector<int>& source) {
+            avl_tree_insert_nodes(target, source.data(), (int)source.size());
+        }
+};
+
+TEST_F(AVLSetOpsTest, Join_DifferentHeights) {
+    std::vector<int> small = { 1, 2, 3 };
+    std::vector<int> large;
+    for (int i = 10; i < 1000; ++i) {
+        large.push_back(i);
+    }
+    fill(&tree, small);
+    fill(&other, large);
+
+    AVLNode* middle = avl_tree_create_node(&tree, 5);
+    AVLNode* root = avl_tree_join(NULL, tree.root, middle, other.root);
+    expect_valid_avl(root, LLONG_MIN, LLONG_MAX);
+
+    std::vector<int> expected = small;
+    expected.push_back(5);
+    expected.insert(expected.end(), large.begin(), large.end());
+    EXPECT_EQ(expected, values(root));
+
+    // Give the nodes back to their trees before clearing them.
+    AVLNode* left = NULL;
+    AVLNode* right = NULL;
+    AVLNode* found = avl_tree_split(NULL, root, 5, &left, &right);
+    ASSERT_EQ(middle, found);
+    tree.root = left;
+    other.root = right;
+    EXPECT_EQ(small, values(tree.root));
+    EXPECT_EQ(large, values(other.root));
+}
+
+TEST_F(AVLSetOpsTest, Split_DegenerateChain) {
+    // A heap tree as imported from a diagram of sorted insertions, deeper than any AVL tree.
+    const int N = 300;
+    AVLNode* root = avl_create_node(0);
+    AVLNode* node = root;
+    for (int i = 1; i < N; ++i) {
+        node->right = avl_create_node(i);
+        node = node->right;
+    }
+    avl_update_tree_height(root);
+
+    AVLNode* left = NULL;
+    AVLNode* right = NULL;
+    AVLNode* found = avl_tree_split(NULL, root, 250, &left, &right);
+    ASSERT_NE(nullptr, found);
+    EXPECT_EQ(250, found->value);
+    // The parts passed on the way down are joined balanced, the chain below the pivot stays as it is.
+    expect_valid_avl(left, LLONG_MIN, 250);
+    EXPECT_EQ(250, (int)values(left).size());
+    std::vector<int> upper = values(right);
+    ASSERT_EQ(N - 251, (int)upper.size());
+    EXPECT_EQ(251, upper.front());
+    avl_free_tree(&left);
+    avl_free_tree(&right);
+    avl_free_tree(&found);
+}
+
+TEST_F(AVLSetOpsTest, RemoveNodes_JoinsDegenerateChain) {
+    // Removing the root joins a right-leaning chain below it with the other side.
+    const int N = 300;
+    AVLNode* root = avl_create_node(1000);
+    root->right = avl_create_node(2000);
+    root->left = avl_create_node(0);
+    AVLNode* node = root->left;
+    for (int i = 1; i < N; ++i) {
+        node->right = avl_create_node(i);
+        node = node->right;
+    }
+    avl_update_tree_height(root);
+
+    std::vector<int> removed{ 1000 };
+    for (int i = 0; i < 40; ++i) removed.push_back(3000 + i);
+    EXPECT_EQ(1, avl_remove_nodes(&root, removed.data(), (int)removed.size()));
+    std::vector<int> remaining = values(root);
+    ASSERT_EQ(N + 1, (int)remaining.size());
+    EXPECT_EQ(N - 1, remaining[N - 1]);
+    EXPECT_EQ(2000, remaining[N]);
+    avl_free_tree(&root);
+}
+
+TEST_F(AVLSetOpsTest, Join_DegenerateChains) {
+    // Both sides walk a spine deeper than any AVL tree down to the lower tree's height.
+    const int N = 300;
+    AVLNode* low = avl_create_node(0);
+    AVLNode* high = avl_create_node(3 * N);
+    AVLNode* lowNode = low;
+    AVLNode* highNode = high;
+    for (int i = 1; i < N; ++i) {
+        lowNode->right = avl_create_node(i);
+        lowNode = lowNode->right;
+        highNode->left = avl_create_node(3 * N - i);
+        highNode = highNode->left;
+    }
+    avl_update_tree_height(low);
+    avl_update_tree_height(high);
+
+    AVLNode* root = avl_tree_join(NULL, low, avl_create_node(N), avl_create_node(N + 1));
+    root = avl_tree_join(NULL, root, avl_create_node(N + 2), avl_create_node(N + 3));
+    root = avl_tree_join(NULL, avl_create_node(N - 1000), avl_create_node(N - 999), root);
+    root = avl_tree_join(NULL, root, avl_create_node(N + 4), high);
+    std::vector<int> joined = values(root);
+    ASSERT_EQ(2 * N + 7, (int)joined.size());
+    EXPECT_TRUE(std::is_sorted(joined.begin(), joined.end()));
+    avl_free_tree(&root);
+}
+
+TEST_F(AVLSetOpsTest, Split_EveryValue) {
+    std::vector<int> expected;
+    for (int i = 0; i < 200; i += 2) {
+        expected.push_back(i);
+    }
+
+    for (int pivot = -1; pivot <= 200; ++pivot) {
+        avl_tree_clear(&tree);
+        fill(&tree, expected);
+        AVLNode* left = NULL;
+        AVLNode* right = NULL;
+        AVLNode* found = avl_tree_split(&tree, tree.root, pivot, &left, &right);
+        tree.root = NULL;
+
+        EXPECT_EQ(pivot >= 0 && pivot < 200 && pivot % 2 == 0, found != NULL);
+        if (found) {
+            EXPECT_EQ(pivot, found->value);
+            EXPECT_EQ(1, found->height);
+        }
+        expect_valid_avl(left, LLONG_MIN, pivot);
+        expect_valid_avl(right, pivot, LLONG_MAX);
+        std::vector<int> joined = values(left);
+        std::vector<int> upper = values(right);
+        for (int value : joined) EXPECT_LT(value, pivot);
+        for (int value : upper) EXPECT_GT(value, pivot);
+        if (found) joined.push_back(pivot);
+        joined.insert(joined.end(), upper.begin(), upper.end());
+        EXPECT_EQ(expected, joined);
+
+        tree.root = found ? avl_tree_join(&tree, left, found, right) : left;
+    }
+}
+
+TEST_P(AVLSetOpsTest, Union_MatchesStdSet) {
+    std::mt19937 random(12);
+    for (int size : { 0, 1, 10, 1000, 40000 }) {
+        avl_tree_clear(&tree);
+        std::vector<int> a = random_values(random, size, size * 2);
+        std::vector<int> b = random_values(random, size / 2 + 3, size * 2);
+        fill(&tree, a);
+        fill(&other, b);
+        std::set<int> setA(a.begin(), a.end()), setB(b.begin(), b.end());
+        std::vector<int> expected;
+        std::set_union(setA.begin(), setA.end(), setB.begin(), setB.end(), std::back_inserter(expected));
+
+        ASSERT_TRUE(avl_tree_union(&tree, &other, GetParam()));
+        EXPECT_EQ(nullptr, other.root);
+        expect_valid_avl(tree.root, LLONG_MIN, LLONG_MAX);
+        EXPECT_EQ(expected, values(tree.root));
+    }
+}
+
+TEST_P(AVLSetOpsTest, Intersection_MatchesStdSet) {
+    std::mt19937 random(34);
+    for (int size : { 0, 1, 10, 1000, 40000 }) {
+        avl_tree_clear(&tree);
+        std::vector<int> a = random_values(random, size, size * 2);
+        std::vector<int> b = random_values(random, size * 2 + 1, size * 2);
+        fill(&tree, a);
+        fill(&other, b);
+        std::set<int> setA(a.begin(), a.end()), setB(b.begin(), b.end());
+        std::vector<int> expected;
+        std::set_intersection(setA.begin(), setA.end(), setB.begin(), setB.end(), std::back_inserter(expected));
+
+        ASSERT_TRUE(avl_tree_intersection(&tree, &other, GetParam()));
+        EXPECT_EQ(nullptr, other.root);
+        expect_valid_avl(tree.root, LLONG_MIN, LLONG_MAX);
+        EXPECT_EQ(expected, values(tree.root));
+    }
+}
+
+TEST_P(AVLSetOpsTest, Difference_MatchesStdSet) {
+    std::mt19937 random(56);
+    for (int size : { 0, 1, 10, 1000, 40000 }) {
+        avl_tree_clear(&tree);
+        std::vector<int> a = random_values(random, size, size * 2);
+        std::vector<int> b = random_values(random, size, size * 2);
+        fill(&tree, a);
+        fill(&other, b);
+        std::set<int> setA(a.begin(), a.end()), setB(b.begin(), b.end());
+        std::vector<int> expected;
+        std::set_difference(setA.begin(), setA.end(), setB.begin(), setB.end(), std::back_inserter(expected));
+
+        ASSERT_TRUE(avl_tree_difference(&tree, &other, GetParam()));
+        EXPECT_EQ(nullptr, other.root);
+        expect_valid_avl(tree.root, LLONG_MIN, LLONG_MAX);
+        EXPECT_EQ(expected, values(tree.root));
+    }
+}
+
+TEST_P(AVLSetOpsTest, Operations_ReuseDroppedNodes) {
+    std::vector<int> a, b;
+    for (int i = 0; i < 5000; ++i) {
+        a.push_back(i);
+        b.push_back(i + 2500);
+    }
+    fill(&tree, a);
+    fill(&other, b);
+    ASSERT_TRUE(avl_tree_intersection(&tree, &other, GetParam()));
+    ASSERT_EQ(2500, (int)values(tree.root).size());
+
+    // 7500 nodes were dropped, new insertions are served from them.
+    AVLNodePool pagesBefore = tree.pool;
+    for (int i = 0; i < 7500; ++i) {
+        avl_tree_insert_node(&tree, -1 - i);
+    }
+    EXPECT_EQ(pagesBefore.pages, tree.pool.pages);
+    EXPECT_EQ(pagesBefore.pageUsed, tree.pool.pageUsed);
+    EXPECT_EQ(nullptr, tree.pool.freeList);
+}
+
+TEST_P(AVLSetOpsTest, Union_KeepsAggregates) {
+    avl_tree_clear(&tree);
+    avl_tree_clear(&other);
+    avl_tree_init_augmented(&tree, AVL_AUGMENT_AGGREGATES);
+    avl_tree_init_augmented(&other, AVL_AUGMENT_AGGREGATES);
+
+    std::mt19937 random(78);
+    std::vector<int> a = random_values(random, 30000, 100000);
+    std::vector<int> b = random_values(random, 30000, 100000);
+    fill(&tree, a);
+    fill(&other, b);
+    std::set<int> expected(a.begin(), a.end());
+    expected.insert(b.begin(), b.end());
+
+    ASSERT_TRUE(avl_tree_union(&tree, &other, GetParam()));
+    EXPECT_EQ((int)expected.size(), avl_aggregate(tree.root)->count);
+    EXPECT_EQ(*expected.begin(), avl_aggregate(tree.root)->min);
+    EXPECT_EQ(*expected.rbegin(), avl_aggregate(tree.root)->max);
+    EXPECT_EQ((int)std::distance(expected.begin(), expected.lower_bound(50000)), avl_tree_rank(&tree, 50000));
+    EXPECT_EQ(*std::next(expected.begin(), 1234), avl_tree_select(&tree, 1234)->value);
+}
+
+TEST_F(AVLSetOpsTest, Union_CountsStats) {
+    BSTStats stats = {};
+    tree.stats = &stats;
+    std::vector<int> a, b;
+    for (int i = 0; i < 50000; ++i) {
+        a.push_back(i * 2);
+        b.push_back(i * 2 + 1);
+    }
+    fill(&tree, a);
+    fill(&other, b);
+    stats = {};
+
+    ASSERT_TRUE(avl_tree_union(&tree, &other, 4));
+    EXPECT_GT(stats.comparisons, 0);
+    EXPECT_EQ(100000, (int)values(tree.root).size());
+    tree.stats = NULL;
+}
+
+TEST_F(AVLSetOpsTest, Operations_RejectIncompatibleTrees) {
+    avl_tree_clear(&other);
+    avl_tree_init_augmented(&other, AVL_AUGMENT_AGGREGATES);
+    avl_tree_insert_node(&other, 1);
+
+    EXPECT_FALSE(avl_tree_union(&tree, &other, 1));
+    EXPECT_FALSE(avl_tree_union(&tree, &tree, 1));
+    EXPECT_NE(nullptr, other.root);
+}
+
+INSTANTIATE_TEST_SUITE_P(Threads, AVLSetOpsTest, ::testing::Values(1, 4));
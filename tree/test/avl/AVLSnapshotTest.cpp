@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <climits>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "avl_snapshot.h"
+
+using std::set;
+using std::vector;
+
+class AVLSnapshotTest : public ::testing::Test {
+    protected:
+        AVLSnapshot snapshot = { nullptr, 0 };
+        AVLNode* tree = nullptr;
+
+        void TearDown() override {
+            avl_snapshot_free(&snapshot);
+            avl_free_tree(&tree);
+        }
+
+        vector<int> scan() {
+            vector<int> values;
+            for (int slot = avl_snapshot_first(&snapshot); slot != AVL_SNAPSHOT_NONE; slot = avl_snapshot_next(&snapshot, slot)) {
+                values.push_back(snapshot.keys[slot]);
+            }
+            return values;
+        }
+};
+
+TEST_F(AVLSnapshotTest, EmptyTree) {
+    avl_snapshot_build(&snapshot, nullptr);
+    EXPECT_EQ(0, snapshot.size);
+    EXPECT_EQ(AVL_SNAPSHOT_NONE, avl_snapshot_first(&snapshot));
+    EXPECT_EQ(AVL_SNAPSHOT_NONE, avl_snapshot_lower_bound(&snapshot, 0));
+    EXPECT_EQ(0, avl_snapshot_contains(&snapshot, 0));
+    EXPECT_EQ(0, avl_snapshot_rank(&snapshot, 0));
+    EXPECT_EQ(0, avl_snapshot_count_range(&snapshot, INT_MIN, INT_MAX));
+}
+
+TEST_F(AVLSnapshotTest, Build_EytzingerOrder) {
+    int values[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+    tree = avl_build_sorted_tree(values, 10);
+    avl_snapshot_build(&snapshot, tree);
+
+    // Slots in BFS order of the complete tree over 10 values.
+    int expect[] = { 7, 4, 9, 2, 6, 8, 10, 1, 3, 5 };
+    ASSERT_EQ(10, snapshot.size);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(expect[i], snapshot.keys[i + 1]) << "slot " << i + 1;
+    }
+    EXPECT_EQ(vector<int>(values, values + 10), scan());
+}
+
+TEST_F(AVLSnapshotTest, Lookups_MatchLiveTree) {
+    std::mt19937 random(11);
+    std::uniform_int_distribution<int> distribution(-100000, 100000);
+    set<int> expect;
+    for (int i = 0; i < 5000; ++i) {
+        int value = distribution(random);
+        expect.insert(value);
+        avl_insert_node(&tree, value);
+    }
+    avl_snapshot_build(&snapshot, tree);
+    ASSERT_EQ((int)expect.size(), snapshot.size);
+    EXPECT_EQ(vector<int>(expect.begin(), expect.end()), scan());
+
+    vector<int> queries;
+    for (int i = 0; i < 3000; ++i) {
+        queries.push_back(distribution(random));
+    }
+    queries.push_back(INT_MIN);
+    queries.push_back(INT_MAX);
+    queries.push_back(*expect.begin());
+    queries.push_back(*expect.rbegin());
+
+    vector<int> batch(queries.size());
+    avl_snapshot_find_values(&snapshot, queries.data(), (int)queries.size(), batch.data());
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+        int value = queries[i];
+        AVLNode* lower = avl_lower_bound(tree, value);
+        int slot = avl_snapshot_lower_bound(&snapshot, value);
+        EXPECT_EQ(lower ? lower->value : INT_MIN, slot ? snapshot.keys[slot] : INT_MIN);
+
+        AVLNode* upper = avl_upper_bound(tree, value);
+        slot = avl_snapshot_upper_bound(&snapshot, value);
+        EXPECT_EQ(upper ? upper->value : INT_MIN, slot ? snapshot.keys[slot] : INT_MIN);
+
+        EXPECT_EQ(avl_contains(tree, value), avl_snapshot_contains(&snapshot, value));
+        EXPECT_EQ(avl_snapshot_find(&snapshot, value), batch[i]);
+        EXPECT_EQ((int)std::distance(expect.begin(), expect.lower_bound(value)), avl_snapshot_rank(&snapshot, value));
+    }
+}
+
+TEST_F(AVLSnapshotTest, CountRange) {
+    vector<int> values;
+    for (int i = 0; i < 1000; ++i) {
+        values.push_back(i * 3);
+    }
+    avl_snapshot_build_sorted(&snapshot, values.data(), (int)values.size());
+
+    EXPECT_EQ(1000, avl_snapshot_count_range(&snapshot, INT_MIN, INT_MAX));
+    EXPECT_EQ(4, avl_snapshot_count_range(&snapshot, 3, 12));
+    EXPECT_EQ(3, avl_snapshot_count_range(&snapshot, 4, 12));
+    EXPECT_EQ(0, avl_snapshot_count_range(&snapshot, 4, 5));
+    EXPECT_EQ(0, avl_snapshot_count_range(&snapshot, 12, 3));
+    EXPECT_EQ(1, avl_snapshot_count_range(&snapshot, 2997, INT_MAX));
+}
+
+TEST_F(AVLSnapshotTest, RangeScan_FromLowerBound) {
+    for (int i = 0; i < 100; ++i) {
+        avl_insert_node(&tree, i * 2);
+    }
+    avl_snapshot_build(&snapshot, tree);
+
+    vector<int> values;
+    for (int slot = avl_snapshot_lower_bound(&snapshot, 51); slot && snapshot.keys[slot] <= 61; slot = avl_snapshot_next(&snapshot, slot)) {
+        values.push_back(snapshot.keys[slot]);
+    }
+    EXPECT_EQ(vector<int>({ 52, 54, 56, 58, 60 }), values);
+}
+
+TEST_F(AVLSnapshotTest, AllSizes_ScanInOrder) {
+    for (int len = 1; len <= 70; ++len) {
+        vector<int> values;
+        for (int i = 0; i < len; ++i) {
+            values.push_back(i);
+        }
+        avl_snapshot_build_sorted(&snapshot, values.data(), len);
+        EXPECT_EQ(values, scan()) << "size " << len;
+        for (int i = 0; i < len; ++i) {
+            ASSERT_EQ(i, snapshot.keys[avl_snapshot_find(&snapshot, i)]);
+            ASSERT_EQ(i, avl_snapshot_rank(&snapshot, i));
+        }
+        avl_snapshot_free(&snapshot);
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef AVL_TEST_HELPERS_H
+#define AVL_TEST_HELPERS_H
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "avl_tree.h"
+
+// Check ordering and balance of the subtree, return its height.
+inline int expect_valid_avl(const AVLNode* node, long long low, long long high) {
+    if (!node) return 0;
+    EXPECT_GT(node->value, low);
+    EXPECT_LT(node->value, high);
+    int left = expect_valid_avl(node->left, low, node->value);
+    int right = expect_valid_avl(node->right, node->value, high);
+    EXPECT_LE(std::abs(left - right), 1);
+    EXPECT_EQ(1 + std::max(left, right), node->height);
+    return 1 + std::max(left, right);
+}
+
+// Append the subtree's values in order.
+inline void collect(const AVLNode* node, std::vector<int>& values) {
+    if (!node) return;
+    collect(node->left, values);
+    values.push_back(node->value);
+    collect(node->right, values);
+}
+
+#endif
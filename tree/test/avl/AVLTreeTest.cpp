@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
 
+#include <climits>
+#include <functional>
+#include <set>
+#include <vector>
+
 #include "avl_tree.h"
 
 class AVLTreeTest : public ::testing::Test {
@@ -467,6 +472,235 @@ TEST_F(AVLTreeTest, UpdateTreeHeight_HeightTenTree) {
     EXPECT_EQ(1, root->right->right->right->right->right->right->right->right->right->height); // rightmost leaf
 }
 
+TEST_F(AVLTreeTest, BuildSorted_CompleteTree) {
+    int values[]{1, 2, 3, 4, 5, 6, 7};
+    root = avl_build_sorted_tree(values, 7);
+
+    EXPECT_EQ(4, root->value);
+    EXPECT_EQ(2, root->left->value);
+    EXPECT_EQ(6, root->right->value);
+    EXPECT_EQ(1, root->left->left->value);
+    EXPECT_EQ(3, root->left->right->value);
+    EXPECT_EQ(5, root->right->left->value);
+    EXPECT_EQ(7, root->right->right->value);
+    EXPECT_EQ(3, root->height);
+    EXPECT_EQ(2, root->left->height);
+    EXPECT_EQ(1, root->right->right->height);
+}
+
+TEST_F(AVLTreeTest, Build_UnsortedWithDuplicates) {
+    int values[]{5, -3, 9, 5, 0, -3, 2147483647, -2147483647 - 1, 9};
+    root = avl_build_tree(values, 9);
+
+    std::vector<int> inOrder;
+    std::function<void(AVLNode*)> collect = [&](AVLNode* node) {
+        if (!node) return;
+        collect(node->left);
+        inOrder.push_back(node->value);
+        collect(node->right);
+    };
+    collect(root);
+
+    EXPECT_EQ((std::vector<int>{-2147483647 - 1, -3, 0, 5, 9, 2147483647}), inOrder);
+    EXPECT_EQ(3, root->height);
+}
+
+TEST_F(AVLTreeTest, Build_Empty) {
+    EXPECT_EQ(nullptr, avl_build_tree(nullptr, 0));
+    EXPECT_EQ(nullptr, avl_build_sorted_tree(nullptr, 0));
+}
+
+TEST_F(AVLTreeTest, Build_LargeTree_Balanced) {
+    const int N = 100000;
+    std::vector<int> values(N);
+    for (int i = 0; i < N; ++i) {
+        values[i] = (i * 7919) % N - N / 2;
+    }
+    root = avl_build_tree(values.data(), N);
+
+    int count = 0;
+    int previous = INT_MIN;
+    std::function<int(AVLNode*)> check = [&](AVLNode* node) -> int {
+        if (!node) return 0;
+        int leftHeight = check(node->left);
+        EXPECT_LT(previous, node->value);
+        previous = node->value;
+        ++count;
+        int rightHeight = check(node->right);
+        EXPECT_LE(abs(leftHeight - rightHeight), 1);
+        EXPECT_EQ(std::max(leftHeight, rightHeight) + 1, node->height);
+        return node->height;
+    };
+    check(root);
+
+    EXPECT_EQ(N, count);
+    EXPECT_EQ(17, root->height);
+
+    // The built tree keeps working as a regular AVL tree.
+    EXPECT_FALSE(avl_insert_node(&root, 0));
+    EXPECT_TRUE(avl_remove_node(&root, 0));
+    EXPECT_TRUE(avl_insert_node(&root, N));
+}
+
+TEST_F(AVLTreeTest, Find_ExistingAndMissingValues) {
+    int values[]{20, 10, 30, 5, 15, 25, 35};
+    root = avl_create_tree(values, 7);
+
+    EXPECT_EQ(root->left->right, avl_find_node(root, 15));
+    EXPECT_EQ(root, avl_find_node(root, 20));
+    EXPECT_EQ(nullptr, avl_find_node(root, 16));
+    EXPECT_TRUE(avl_contains(root, 35));
+    EXPECT_FALSE(avl_contains(root, 36));
+    EXPECT_FALSE(avl_contains(nullptr, 1));
+}
+
+TEST_F(AVLTreeTest, LowerAndUpperBound) {
+    int values[]{20, 10, 30, 5, 15, 25, 35};
+    root = avl_create_tree(values, 7);
+
+    EXPECT_EQ(15, avl_lower_bound(root, 15)->value);
+    EXPECT_EQ(20, avl_upper_bound(root, 15)->value);
+    EXPECT_EQ(25, avl_lower_bound(root, 21)->value);
+    EXPECT_EQ(25, avl_upper_bound(root, 21)->value);
+    EXPECT_EQ(5, avl_lower_bound(root, -100)->value);
+    EXPECT_EQ(35, avl_lower_bound(root, 35)->value);
+    EXPECT_EQ(nullptr, avl_upper_bound(root, 35));
+    EXPECT_EQ(nullptr, avl_lower_bound(root, 36));
+    EXPECT_EQ(nullptr, avl_lower_bound(nullptr, 0));
+}
+
+TEST_F(AVLTreeTest, FindNodes_MatchesSingleLookups) {
+    const int N = 5000;
+    std::vector<int> values;
+    for (int i = 0; i < N; ++i) {
+        values.push_back(i * 3);
+    }
+    root = avl_build_sorted_tree(values.data(), N);
+
+    // Not a multiple of the batch width, with hits, misses and out-of-range keys.
+    const int M = 1003;
+    std::vector<int> keys(M);
+    for (int i = 0; i < M; ++i) {
+        keys[i] = (i * 37) % (N * 3 + 10) - 5;
+    }
+    std::vector<AVLNode*> found(M);
+    avl_find_nodes(root, keys.data(), M, found.data());
+
+    for (int i = 0; i < M; ++i) {
+        EXPECT_EQ(avl_find_node(root, keys[i]), found[i]) << "key " << keys[i];
+    }
+}
+
+TEST_F(AVLTreeTest, FindNodes_EmptyTree) {
+    int keys[]{1, 2, 3};
+    AVLNode dummy{};
+    AVLNode* found[3]{&dummy, &dummy, &dummy};
+    avl_find_nodes(nullptr, keys, 3, found);
+
+    EXPECT_EQ(nullptr, found[0]);
+    EXPECT_EQ(nullptr, found[1]);
+    EXPECT_EQ(nullptr, found[2]);
+}
+
+TEST_F(AVLTreeTest, InsertNodes_BatchMergedIntoTree) {
+    std::vector<int> values;
+    for (int i = 0; i < 3000; i += 3) {
+        values.push_back(i);
+    }
+    avl_insert_nodes(&root, values.data(), (int)values.size());
+
+    // Overlapping batch, with duplicates inside and against the tree, in no particular order.
+    std::vector<int> batch;
+    for (int i = 0; i < 4000; ++i) {
+        batch.push_back((i * 7919) % 5000 - 500);
+    }
+    avl_insert_nodes(&root, batch.data(), (int)batch.size());
+
+    std::vector<int> collected;
+    std::function<int(AVLNode*)> check = [&](AVLNode* node) -> int {
+        if (!node) return 0;
+        int leftHeight = check(node->left);
+        collected.push_back(node->value);
+        int rightHeight = check(node->right);
+        EXPECT_LE(abs(leftHeight - rightHeight), 1);
+        EXPECT_EQ(std::max(leftHeight, rightHeight) + 1, node->height);
+        return node->height;
+    };
+    check(root);
+
+    std::set<int> expected(values.begin(), values.end());
+    expected.insert(batch.begin(), batch.end());
+    EXPECT_EQ(std::vector<int>(expected.begin(), expected.end()), collected);
+}
+
+TEST_F(AVLTreeTest, InsertNodes_SmallBatchKeepsInsertionOrder) {
+    int values[]{10, 5, 15, 3, 7, 1};
+    avl_insert_nodes(&root, values, 6);
+
+    // Same rotation as inserting the values one by one.
+    EXPECT_EQ(5, root->value);
+    EXPECT_EQ(3, root->left->value);
+    EXPECT_EQ(10, root->right->value);
+    EXPECT_EQ(1, root->left->left->value);
+}
+
+TEST_F(AVLTreeTest, RemoveNodes_SmallAndLargeBatches) {
+    std::set<int> expected;
+    std::vector<int> values;
+    for (int i = 0; i < 20000; ++i) {
+        values.push_back(i * 2);
+        expected.insert(i * 2);
+    }
+    root = avl_build_sorted_tree(values.data(), (int)values.size());
+
+    // Batch sizes below and above the rebuild share, with duplicates and missing keys.
+    for (int batch : { 10, 100, 2000, 15000 }) {
+        std::vector<int> keys;
+        int removed = 0;
+        for (int i = 0; i < batch; ++i) {
+            int key = (int)(((long long)i * 7919 + batch) % 45000) - 1000;
+            keys.push_back(key);
+            keys.push_back(key);
+            removed += (int)expected.erase(key);
+        }
+        EXPECT_EQ(removed, avl_remove_nodes(&root, keys.data(), (int)keys.size())) << batch;
+
+        std::vector<int> collected;
+        std::function<int(AVLNode*)> check = [&](AVLNode* node) -> int {
+            if (!node) return 0;
+            int leftHeight = check(node->left);
+            collected.push_back(node->value);
+            int rightHeight = check(node->right);
+            EXPECT_LE(abs(leftHeight - rightHeight), 1);
+            EXPECT_EQ(std::max(leftHeight, rightHeight) + 1, node->height);
+            return node->height;
+        };
+        check(root);
+        EXPECT_EQ(std::vector<int>(expected.begin(), expected.end()), collected) << batch;
+    }
+
+    std::vector<int> all(expected.begin(), expected.end());
+    EXPECT_EQ((int)all.size(), avl_remove_nodes(&root, all.data(), (int)all.size()));
+    EXPECT_EQ(nullptr, root);
+}
+
+TEST_F(AVLTreeTest, UpdateTreeHeight_10MillionLevels) {
+    // Nodes linked by hand into one zigzagging chain, as deep as a tree can get.
+    const int depth = 10000000;
+    root = avl_create_node(0);
+    AVLNode* node = root;
+    for (int i = 1; i < depth; ++i) {
+        AVLNode* child = avl_create_node(i);
+        (i % 2 ? node->right : node->left) = child;
+        node = child;
+    }
+
+    avl_update_tree_height(root);
+    EXPECT_EQ(depth, root->height);
+    EXPECT_EQ(depth - 1, root->right->height);
+    EXPECT_EQ(1, node->height);
+}
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include <climits>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "bplus_tree.h"
+
+using std::set;
+using std::vector;
+
+class BPlusTreeTest : public ::testing::Test {
+    protected:
+        BPlusTree tree;
+        BSTStats stats = {};
+
+        void SetUp() override {
+            bplus_tree_init(&tree, &stats);
+        }
+
+        void TearDown() override {
+            bplus_tree_clear(&tree);
+        }
+
+        static void collect_value(int value, void* context) {
+            ((vector<int>*)context)->push_back(value);
+        }
+
+        vector<int> range(int low, int high) {
+            vector<int> result;
+            int visited = bplus_tree_range(&tree, low, high, collect_value, &result);
+            EXPECT_EQ(visited, (int)result.size());
+            return result;
+        }
+
+        // Check fill, key order and depth of every node, and that the leaves are linked in order.
+        void expect_valid() {
+            if (!tree.root) {
+                EXPECT_EQ(0, tree.height);
+                return;
+            }
+            vector<const BPlusNode*> leaves;
+            expect_node(tree.root, 1, LLONG_MIN, LLONG_MAX, leaves);
+            for (size_t i = 0; i < leaves.size(); ++i) {
+                EXPECT_EQ(i + 1 < leaves.size() ? leaves[i + 1] : nullptr, leaves[i]->next);
+            }
+        }
+
+        void expect_node(const BPlusNode* node, int level, long long low, long long high, vector<const BPlusNode*>& leaves) {
+            EXPECT_EQ(0u, (uintptr_t)node % 64);
+            EXPECT_LE(node->count, BPLUS_MAX_KEYS);
+            EXPECT_GE(node->count, node == tree.root ? 1 : BPLUS_MIN_KEYS);
+            for (int i = 0; i < node->count; ++i) {
+                EXPECT_GE(node->keys[i], low);
+                EXPECT_LT(node->keys[i], high);
+                if (i) EXPECT_LT(node->keys[i - 1], node->keys[i]);
+            }
+            if (level == tree.height) {
+                EXPECT_EQ(nullptr, node->children[0]);
+                leaves.push_back(node);
+                return;
+            }
+            for (int i = 0; i <= node->count; ++i) {
+                ASSERT_NE(nullptr, node->children[i]);
+                expect_node(node->children[i], level + 1, i ? node->keys[i - 1] : low, i < node->count ? node->keys[i] : high, leaves);
+            }
+        }
+};
+
+TEST_F(BPlusTreeTest, SortedInsertions_SplitUpwards) {
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_TRUE(bplus_tree_insert_node(&tree, i));
+    }
+    EXPECT_FALSE(bplus_tree_insert_node(&tree, 5000));
+    expect_valid();
+    EXPECT_GE(tree.height, 3);
+    EXPECT_GT(stats.rotations, 0);
+
+    vector<int> expected;
+    for (int i = 0; i < 10000; ++i) expected.push_back(i);
+    EXPECT_EQ(expected, range(INT_MIN, INT_MAX));
+}
+
+TEST_F(BPlusTreeTest, RandomOperations_MatchStdSet) {
+    std::mt19937 random(19);
+    set<int> expected;
+    for (int step = 0; step < 200000; ++step) {
+        int value = (int)(random() % 20000) - 10000;
+        switch (random() % 3) {
+            case 0:
+                EXPECT_EQ((int)expected.erase(value), bplus_tree_remove_node(&tree, value));
+                break;
+            case 1:
+                EXPECT_EQ((int)expected.count(value), bplus_tree_contains(&tree, value));
+                break;
+            default:
+                EXPECT_EQ((int)expected.insert(value).second, bplus_tree_insert_node(&tree, value));
+        }
+        if (step % 20000 == 0) {
+            expect_valid();
+        }
+    }
+    expect_valid();
+    EXPECT_EQ(vector<int>(expected.begin(), expected.end()), range(INT_MIN, INT_MAX));
+
+    for (int value : expected) {
+        ASSERT_TRUE(bplus_tree_remove_node(&tree, value));
+    }
+    EXPECT_EQ(nullptr, tree.root);
+    EXPECT_EQ(0, tree.height);
+}
+
+TEST_F(BPlusTreeTest, Range_FollowsLeaves) {
+    for (int i = 0; i < 3000; i += 3) {
+        bplus_tree_insert_node(&tree, i);
+    }
+    EXPECT_EQ(vector<int>({ 3, 6, 9 }), range(1, 10));
+    EXPECT_EQ(vector<int>({ 2997 }), range(2997, 5000));
+    EXPECT_TRUE(range(1, 2).empty());
+    EXPECT_TRUE(range(10, 1).empty());
+    EXPECT_EQ(1000u, range(INT_MIN, INT_MAX).size());
+    EXPECT_EQ(400u, range(600, 1799).size());
+}
+
+TEST_F(BPlusTreeTest, Build_FillsEveryNode) {
+    for (int len : { 0, 1, 15, 16, 17, 240, 241, 5000, 100000 }) {
+        vector<int> values;
+        std::mt19937 random(len);
+        for (int i = 0; i < len; ++i) values.push_back((int)(random() % (2 * len + 1)));
+        set<int> expected(values.begin(), values.end());
+
+        ASSERT_TRUE(bplus_tree_build(&tree, values.data(), len));
+        expect_valid();
+        EXPECT_EQ(vector<int>(expected.begin(), expected.end()), range(INT_MIN, INT_MAX)) << len;
+
+        // Built trees keep changing like any other.
+        for (int i = 0; i < len; i += 2) {
+            bplus_tree_remove_node(&tree, values[i]);
+            bplus_tree_insert_node(&tree, -1 - i);
+        }
+        expect_valid();
+    }
+}
@@ -0,0 +1,449 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "avl_buffer.h"
+#include "avl_tree.h"
+#include "bplus_tree.h"
+#include "bst_engine.h"
+#include "rb_tree.h"
+#include "splay_tree.h"
+#include "treap.h"
+#include "wavl_tree.h"
+
+using std::set;
+using std::string;
+using std::vector;
+
+class BSTEngineTest : public ::testing::TestWithParam<string> {
+    protected:
+        BSTree tree;
+
+        void SetUp() override {
+            ASSERT_TRUE(bst_init(&tree, bst_find_engine(GetParam().c_str())));
+        }
+
+        void TearDown() override {
+            bst_free_tree(&tree);
+        }
+
+        vector<int> collect() {
+            vector<int> result(bst_count_nodes(&tree));
+            bst_collect_values(&tree, result.data());
+            return result;
+        }
+
+        // Check the balancing rules of the tree's current engine.
+        void expect_balanced() {
+            const string& name = tree.engine->name;
+            if (name == "avl" || name == "buffered") {
+                expect_avl((const AVLNode*)bst_get_root(&tree));
+            } else if (name == "rb") {
+                const RBNode* root = (const RBNode*)bst_get_root(&tree);
+                EXPECT_TRUE(!root || !root->red);
+                expect_rb(root, nullptr);
+            } else if (name == "treap") {
+                expect_treap((const TreapNode*)bst_get_root(&tree));
+            } else if (name == "wavl") {
+                expect_wavl((const WAVLNode*)bst_get_root(&tree));
+            } else if (name == "bplus") {
+                const BPlusNode* root = (const BPlusNode*)bst_get_root(&tree);
+                expect_bplus(root, root, LLONG_MIN, LLONG_MAX);
+            }
+        }
+
+        // Check key order and fill, return the number of levels which must be equal for all leaves.
+        int expect_bplus(const BPlusNode* node, const BPlusNode* root, long long low, long long high) {
+            if (!node) return 0;
+            EXPECT_LE(node->count, BPLUS_MAX_KEYS);
+            EXPECT_GE(node->count, node == root ? 1 : BPLUS_MIN_KEYS);
+            for (int i = 0; i < node->count; ++i) {
+                EXPECT_GE(node->keys[i], low);
+                EXPECT_LT(node->keys[i], high);
+                if (i) EXPECT_LT(node->keys[i - 1], node->keys[i]);
+            }
+            if (!node->children[0]) return 1;
+            int height = expect_bplus(node->children[0], root, low, node->keys[0]);
+            for (int i = 1; i <= node->count; ++i) {
+                EXPECT_EQ(height, expect_bplus(node->children[i], root, node->keys[i - 1], i < node->count ? node->keys[i] : high));
+            }
+            return 1 + height;
+        }
+
+        int expect_avl(const AVLNode* node) {
+            if (!node) return 0;
+            int left = expect_avl(node->left);
+            int right = expect_avl(node->right);
+            EXPECT_LE(std::abs(left - right), 1);
+            return 1 + std::max(left, right);
+        }
+
+        // Return the black height.
+        int expect_rb(const RBNode* node, const RBNode* parent) {
+            if (!node) return 1;
+            EXPECT_EQ(parent, node->parent);
+            if (node->red) {
+                EXPECT_TRUE(!node->left || !node->left->red);
+                EXPECT_TRUE(!node->right || !node->right->red);
+            }
+            int left = expect_rb(node->left, node);
+            int right = expect_rb(node->right, node);
+            EXPECT_EQ(left, right);
+            return left + !node->red;
+        }
+
+        static string print(BTBox* box) {
+            FILE* file = tmpfile();
+            btbox_print(file, box);
+            string output(ftell(file), '\0');
+            rewind(file);
+            output.resize(fread(&output[0], 1, output.size(), file));
+            fclose(file);
+            return output;
+        }
+
+        static int count_dirty(BTBox* box) {
+            if (!box || !box->dirty) return 0;
+            int count = 1 + count_dirty(box->left) + count_dirty(box->right);
+            for (int i = 1; i < box->keyCount; ++i) count += count_dirty(box->children[i]);
+            return count;
+        }
+
+        void expect_treap(const TreapNode* node) {
+            if (!node) return;
+            if (node->left) EXPECT_GE(node->priority, node->left->priority);
+            if (node->right) EXPECT_GE(node->priority, node->right->priority);
+            expect_treap(node->left);
+            expect_treap(node->right);
+        }
+
+        void expect_wavl(const WAVLNode* node) {
+            if (!node) return;
+            int left = node->left ? node->left->rank : -1;
+            int right = node->right ? node->right->rank : -1;
+            EXPECT_TRUE(node->rank - left == 1 || node->rank - left == 2);
+            EXPECT_TRUE(node->rank - right == 1 || node->rank - right == 2);
+            if (!node->left && !node->right) EXPECT_EQ(0, node->rank);
+            expect_wavl(node->left);
+            expect_wavl(node->right);
+        }
+};
+
+TEST_P(BSTEngineTest, RandomOperations_MatchStdSet) {
+    std::mt19937 random(17);
+    std::uniform_int_distribution<int> distribution(0, 2000);
+    set<int> expect;
+    for (int i = 0; i < 10000; ++i) {
+        int value = distribution(random);
+        switch (random() % 4) {
+            case 0:
+                EXPECT_EQ((int)expect.erase(value), bst_remove_node(&tree, value));
+                break;
+            case 1:
+                EXPECT_EQ((int)expect.count(value), bst_contains(&tree, value));
+                break;
+            default:
+                EXPECT_EQ((int)expect.insert(value).second, bst_insert_node(&tree, value));
+        }
+        if (i % 500 == 0) {
+            expect_balanced();
+        }
+    }
+    expect_balanced();
+    EXPECT_EQ(vector<int>(expect.begin(), expect.end()), collect());
+
+    // Remove everything.
+    for (int value : expect) {
+        EXPECT_EQ(1, bst_remove_node(&tree, value));
+    }
+    EXPECT_EQ(nullptr, bst_get_root(&tree));
+}
+
+TEST_P(BSTEngineTest, Stats_CountWork) {
+    for (int i = 0; i < 100; ++i) {
+        bst_insert_node(&tree, i);
+    }
+    // Sorted insertions need rotations, except for the splay tree which keeps a path
+    // and the buffered engine which merges them into the tree as one batch.
+    EXPECT_GT(tree.stats.comparisons, 0);
+    if (string(tree.engine->name) != "splay" && string(tree.engine->name) != "buffered") {
+        EXPECT_GT(tree.stats.rotations, 0);
+    }
+    bst_reset_stats(&tree);
+    EXPECT_EQ(0, tree.stats.comparisons);
+    bst_contains(&tree, 50);
+    EXPECT_GT(tree.stats.comparisons, 0);
+}
+
+TEST_P(BSTEngineTest, FindValues) {
+    int values[] = { 5, 1, 9, 3 };
+    bst_insert_nodes(&tree, values, 4);
+    int queries[] = { 1, 2, 3, 4, 5, 9, 10 };
+    int found[7];
+    bst_find_values(&tree, queries, 7, found);
+    EXPECT_EQ(vector<int>({ 1, 0, 1, 0, 1, 1, 0 }), vector<int>(found, found + 7));
+}
+
+TEST_P(BSTEngineTest, Build_ReplacesContent) {
+    bst_insert_node(&tree, 1000);
+    int values[] = { 4, 2, 8, 2, 6 };
+    EXPECT_TRUE(bst_build(&tree, values, 5));
+    EXPECT_EQ(vector<int>({ 2, 4, 6, 8 }), collect());
+    expect_balanced();
+}
+
+TEST_P(BSTEngineTest, SwitchEngine_KeepsValues) {
+    for (int i = 0; i < 300; ++i) {
+        bst_insert_node(&tree, (i * 7919) % 1000);
+    }
+    vector<int> before = collect();
+    for (int i = 0; bst_get_engine(i); ++i) {
+        ASSERT_TRUE(bst_switch_engine(&tree, bst_get_engine(i)));
+        EXPECT_EQ(bst_get_engine(i), tree.engine);
+        EXPECT_EQ(before, collect());
+        expect_balanced();
+    }
+}
+
+TEST_P(BSTEngineTest, DegenerateTree_WalkWithoutRecursion) {
+    // Sorted insertions leave a splay tree as a path, deeper than the inline walk stack.
+    for (int i = 0; i < 5000; ++i) {
+        bst_insert_node(&tree, i);
+    }
+    vector<int> result = collect();
+    ASSERT_EQ(5000u, result.size());
+    EXPECT_TRUE(std::is_sorted(result.begin(), result.end()));
+}
+
+TEST_P(BSTEngineTest, CreateBox_PrintsTree) {
+    int values[] = { 2, 1, 3 };
+    bst_insert_nodes(&tree, values, 3);
+    BTBox* box = bst_create_box(&tree);
+    ASSERT_NE(nullptr, box);
+    FILE* file = tmpfile();
+    btbox_print(file, box);
+    EXPECT_GT(ftell(file), 0);
+    fclose(file);
+    btbox_free_tree(box);
+}
+
+TEST_P(BSTEngineTest, Print_MatchesCreatedBox) {
+    for (int i = 0; i < 500; ++i) {
+        bst_insert_node(&tree, (i * 7919) % 1009 - 500);
+    }
+    BTBox* box = bst_create_box(&tree);
+    FILE* file = tmpfile();
+    bst_print(file, &tree);
+    string output(ftell(file), '\0');
+    rewind(file);
+    output.resize(fread(&output[0], 1, output.size(), file));
+    fclose(file);
+    EXPECT_EQ(print(box), output);
+    btbox_free_tree(box);
+}
+
+TEST_P(BSTEngineTest, UpdateBox_MatchesCreatedBox) {
+    std::mt19937 random(21);
+    BTBox* box = nullptr;
+    for (int step = 0; step < 600; ++step) {
+        // Mostly single values, sometimes a batch large enough to be merged in one pass.
+        int values[40];
+        int len = step % 10 == 9 ? 40 : 1 + (int)(random() % 3);
+        for (int i = 0; i < len; ++i) values[i] = (int)(random() % 400);
+        switch (random() % 4) {
+            case 0:
+                bst_remove_nodes(&tree, values, len);
+                break;
+            case 1: {
+                // Lookups change the shape of splay trees.
+                int found[40];
+                bst_find_values(&tree, values, len, found);
+                break;
+            }
+            default:
+                bst_insert_nodes(&tree, values, len);
+        }
+        box = bst_update_box(&tree, box, values, len);
+        BTBox* created = bst_create_box(&tree);
+        ASSERT_EQ(print(created), print(box)) << step;
+        btbox_free_tree(created);
+    }
+    btbox_free_tree(box);
+}
+
+TEST_P(BSTEngineTest, UpdateBox_AfterRebuildingBatch) {
+    BTBox* box = nullptr;
+    for (int value = 0; value <= 306; value += 2) {
+        bst_insert_node(&tree, value);
+        box = bst_update_box(&tree, box, &value, 1);
+    }
+    // Removing this share of the tree rebuilds AVL trees as a whole, far from the removed values too.
+    vector<int> values;
+    for (int value = 292; value <= 656; value += 2) values.push_back(value);
+    bst_remove_nodes(&tree, values.data(), (int)values.size());
+    box = bst_update_box(&tree, box, values.data(), (int)values.size());
+
+    BTBox* created = bst_create_box(&tree);
+    EXPECT_EQ(print(created), print(box));
+    btbox_free_tree(created);
+    btbox_free_tree(box);
+}
+
+TEST_P(BSTEngineTest, UpdateBox_MeasuresChangedPathOnly) {
+    for (int i = 0; i < 4000; ++i) {
+        bst_insert_node(&tree, (i * 7919) % 10007);
+    }
+    BTBox* box = bst_create_box(&tree);
+    print(box);
+    int value = 5003;
+    bst_insert_node(&tree, value);
+    box = bst_update_box(&tree, box, &value, 1);
+    if (string(tree.engine->name) != "splay" && string(tree.engine->name) != "bplus") {
+        EXPECT_LT(count_dirty(box), 60);
+    }
+    BTBox* created = bst_create_box(&tree);
+    EXPECT_EQ(print(created), print(box));
+    EXPECT_EQ(0, count_dirty(box));
+    btbox_free_tree(created);
+    btbox_free_tree(box);
+}
+
+TEST_P(BSTEngineTest, Import_RebuildsDegenerateTree) {
+    // A right-leaning chain, as a diagram of sorted insertions into a plain BST would look.
+    const int N = 3000;
+    vector<BTNode> chain(N);
+    for (int i = 0; i < N; ++i) {
+        chain[i] = BTNode{ i, NULL, i + 1 < N ? &chain[i + 1] : NULL };
+    }
+    EXPECT_EQ(BST_IMPORT_REBUILT, bst_import(&tree, &chain[0], &btbox_node_accessor, 1));
+    expect_balanced();
+    vector<int> result = collect();
+    ASSERT_EQ((size_t)N, result.size());
+    EXPECT_EQ(0, result.front());
+    EXPECT_EQ(N - 1, result.back());
+}
+
+TEST_P(BSTEngineTest, Import_SortsUnorderedTree) {
+    BTNode left{ 9, NULL, NULL };
+    BTNode right{ 1, NULL, NULL };
+    BTNode root{ 5, &left, &right };
+    left.right = new BTNode{ 5, NULL, NULL };
+    EXPECT_EQ(BST_IMPORT_UNORDERED, bst_import(&tree, &root, &btbox_node_accessor, 1));
+    EXPECT_EQ(vector<int>({ 1, 5, 9 }), collect());
+    delete left.right;
+}
+
+TEST_P(BSTEngineTest, Import_KeepsBalancedShapeIfEngineCan) {
+    BTNode nodes[] = { { 4, NULL, NULL }, { 2, NULL, NULL }, { 6, NULL, NULL }, { 1, NULL, NULL } };
+    nodes[0].left = &nodes[1];
+    nodes[0].right = &nodes[2];
+    nodes[1].left = &nodes[3];
+
+    int result = bst_import(&tree, &nodes[0], &btbox_node_accessor, 1);
+    EXPECT_EQ(vector<int>({ 1, 2, 4, 6 }), collect());
+    expect_balanced();
+    if (tree.engine == &bst_avl_engine || tree.engine == &bst_buffered_engine) {
+        EXPECT_EQ(BST_IMPORT_SHAPE_KEPT, result);
+        const AVLNode* root = (const AVLNode*)bst_get_root(&tree);
+        EXPECT_EQ(4, root->value);
+        EXPECT_EQ(1, root->left->left->value);
+        EXPECT_EQ(3, root->height);
+    } else {
+        EXPECT_EQ(BST_IMPORT_REBUILT, result);
+    }
+
+    // Empty trees import as empty trees.
+    EXPECT_NE(BST_IMPORT_FAILED, bst_import(&tree, NULL, &btbox_node_accessor, 1));
+    EXPECT_TRUE(collect().empty());
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, BSTEngineTest, ::testing::Values("avl", "rb", "treap", "splay", "wavl", "buffered", "bplus"),
+    [](const ::testing::TestParamInfo<string>& info) { return info.param; });
+
+TEST(BSTEngineRegistryTest, FindEngine) {
+    EXPECT_EQ(&bst_avl_engine, bst_find_engine("avl"));
+    EXPECT_EQ(&bst_wavl_engine, bst_find_engine("wavl"));
+    EXPECT_EQ(nullptr, bst_find_engine("b-tree"));
+    EXPECT_EQ(nullptr, bst_get_engine(-1));
+}
+
+TEST(BSTEngineImportTest, BPlus_RoundtripKeepsShape) {
+    BSTree source;
+    ASSERT_TRUE(bst_init(&source, &bst_bplus_engine));
+    for (int i = 0; i < 600; ++i) bst_insert_node(&source, (i * 7919) % 1009);
+    // Removals leave routing keys which are no longer values of any leaf.
+    for (int i = 0; i < 1009; i += 3) bst_remove_node(&source, i);
+    vector<int> values(bst_count_nodes(&source));
+    bst_collect_values(&source, values.data());
+
+    FILE* file = tmpfile();
+    bst_print(file, &source);
+    string exported(ftell(file), '\0');
+    rewind(file);
+    exported.resize(fread(&exported[0], 1, exported.size(), file));
+    rewind(file);
+    BTNode* restored = btbox_restore_tree(file);
+    fclose(file);
+    ASSERT_NE(nullptr, restored);
+
+    BSTree bplus;
+    ASSERT_TRUE(bst_init(&bplus, &bst_bplus_engine));
+    EXPECT_EQ(BST_IMPORT_SHAPE_KEPT, bst_import(&bplus, restored, &btbox_node_accessor, 1));
+    vector<int> imported(bst_count_nodes(&bplus));
+    bst_collect_values(&bplus, imported.data());
+    EXPECT_EQ(values, imported);
+    file = tmpfile();
+    bst_print(file, &bplus);
+    string printed(ftell(file), '\0');
+    rewind(file);
+    printed.resize(fread(&printed[0], 1, printed.size(), file));
+    fclose(file);
+    EXPECT_EQ(exported, printed);
+
+    // Engines with single-key nodes take the leaves' values only.
+    BSTree avl;
+    ASSERT_TRUE(bst_init(&avl, &bst_avl_engine));
+    EXPECT_EQ(BST_IMPORT_REBUILT, bst_import(&avl, restored, &btbox_node_accessor, 1));
+    imported.assign(bst_count_nodes(&avl), 0);
+    bst_collect_values(&avl, imported.data());
+    EXPECT_EQ(values, imported);
+
+    btbox_free_node(restored);
+    bst_free_tree(&avl);
+    bst_free_tree(&bplus);
+    bst_free_tree(&source);
+}
+
+TEST(BSTEngineRegistryTest, WAVL_SameShapeAsAVLOnInsertions) {
+    AVLNode* avl = nullptr;
+    WAVLTree wavl;
+    wavl_tree_init(&wavl, nullptr);
+    std::mt19937 random(1);
+    for (int i = 0; i < 2000; ++i) {
+        int value = random() % 5000;
+        avl_insert_node(&avl, value);
+        wavl_tree_insert_node(&wavl, value);
+    }
+    vector<const AVLNode*> avlNodes = { avl };
+    vector<const WAVLNode*> wavlNodes = { wavl.root };
+    while (!avlNodes.empty()) {
+        const AVLNode* a = avlNodes.back();
+        const WAVLNode* w = wavlNodes.back();
+        avlNodes.pop_back();
+        wavlNodes.pop_back();
+        ASSERT_EQ(a == nullptr, w == nullptr);
+        if (!a) continue;
+        ASSERT_EQ(a->value, w->value);
+        avlNodes.push_back(a->left);
+        avlNodes.push_back(a->right);
+        wavlNodes.push_back(w->left);
+        wavlNodes.push_back(w->right);
+    }
+    avl_free_tree(&avl);
+    wavl_tree_clear(&wavl);
+}
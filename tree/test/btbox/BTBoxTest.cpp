@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <fstream>
 #include <string>
 
@@ -19,6 +20,20 @@ class BSTBoxTest : public ::testing::Test {
             btbox_free_node(tree);
             btbox_free_tree(box);
         }
+
+        // Create a node holding several keys, with children added by add_children.
+        BTNode* create_keys_node(std::initializer_list<int> keys) {
+            BTNode* node = btbox_create_node(*keys.begin());
+            node->keyCount = (int)keys.size();
+            node->keys = (int*)malloc(sizeof(int) * keys.size());
+            std::copy(keys.begin(), keys.end(), node->keys);
+            return node;
+        }
+
+        void add_children(BTNode* node, std::initializer_list<BTNode*> children) {
+            node->children = (BTNode**)malloc(sizeof(BTNode*) * children.size());
+            std::copy(children.begin(), children.end(), node->children);
+        }
 };
 
 TEST_F(BSTBoxTest, Print_Valid_CompleteTree_2Levels) {
@@ -395,6 +410,92 @@ TEST_F(BSTBoxTest, RestoreTree_Valid_MissingMidLevels) {
     EXPECT_EQ(tree->right->left->value, -3);
 }
 
+TEST_F(BSTBoxTest, Print_MultiKeyNodes) {
+    tree = create_keys_node({ 10, 20 });
+    BTNode* right = create_keys_node({ 25, 30, 35 });
+    add_children(tree, { create_keys_node({ -5, 1 }), btbox_create_node(15), right });
+    add_children(right, { btbox_create_node(21), btbox_create_node(26), create_keys_node({ 31, 32 }), btbox_create_node(40) });
+
+    box = btbox_create_tree(tree);
+    char outputPath[] = "Print_MultiKeyNodes.output";
+    FILE *outputFile = fopen(outputPath, "w");
+
+    btbox_print(outputFile, box);
+
+    string output = readFileContent(outputPath);
+    string expect = readFileContent("../tree/test/btbox/Print_MultiKeyNodes.expect");
+
+    EXPECT_EQ(output, expect);
+
+    fclose(outputFile);
+    remove(outputPath);
+}
+
+TEST_F(BSTBoxTest, RestoreTree_Valid_MultiKeyNodes) {
+    const char* inputPath = "../tree/test/btbox/Print_MultiKeyNodes.expect";
+
+    FILE* inputFile = fopen(inputPath, "r");
+    ASSERT_NE(inputFile, nullptr) << "Failed to open input file";
+
+    tree = btbox_restore_tree(inputFile);
+    fclose(inputFile);
+
+    ASSERT_NE(tree, nullptr);
+    ASSERT_EQ(tree->keyCount, 2);
+    EXPECT_EQ(tree->keys[0], 10);
+    EXPECT_EQ(tree->keys[1], 20);
+    EXPECT_EQ(tree->left, nullptr);
+    ASSERT_NE(tree->children, nullptr);
+    EXPECT_EQ(tree->children[0]->keyCount, 2);
+    EXPECT_EQ(tree->children[0]->keys[0], -5);
+    EXPECT_EQ(tree->children[0]->keys[1], 1);
+    EXPECT_EQ(tree->children[0]->children, nullptr);
+    EXPECT_EQ(tree->children[1]->keyCount, 0);
+    EXPECT_EQ(tree->children[1]->value, 15);
+
+    BTNode* right = tree->children[2];
+    ASSERT_EQ(right->keyCount, 3);
+    EXPECT_EQ(right->keys[2], 35);
+    ASSERT_NE(right->children, nullptr);
+    EXPECT_EQ(right->children[0]->value, 21);
+    EXPECT_EQ(right->children[1]->value, 26);
+    EXPECT_EQ(right->children[2]->keyCount, 2);
+    EXPECT_EQ(right->children[2]->keys[1], 32);
+    EXPECT_EQ(right->children[3]->value, 40);
+
+    // Printing the restored tree gives the same text again.
+    box = btbox_create_tree(tree);
+    char outputPath[] = "RestoreTree_Valid_MultiKeyNodes.output";
+    FILE *outputFile = fopen(outputPath, "w");
+    btbox_print(outputFile, box);
+    fclose(outputFile);
+    EXPECT_EQ(readFileContent(outputPath), readFileContent(inputPath));
+    remove(outputPath);
+}
+
+TEST_F(BSTBoxTest, CreateTree_10MillionLevels) {
+    // A tree restored from a diagram can be a chain of any length, here one zigzagging down.
+    const int depth = 10000000;
+    tree = btbox_create_node(0);
+    BTNode* node = tree;
+    for (int i = 1; i < depth; ++i) {
+        BTNode* child = btbox_create_node(i);
+        (i % 2 ? node->right : node->left) = child;
+        node = child;
+    }
+
+    box = btbox_create_tree(tree);
+    ASSERT_NE(box, nullptr);
+    int levels = 1;
+    BTBox* last = box;
+    while (last->left || last->right) {
+        last = last->left ? last->left : last->right;
+        ++levels;
+    }
+    EXPECT_EQ(levels, depth);
+    EXPECT_EQ(last->value, depth - 1);
+}
+
 string readFileContent(const std::string& path) {
     std::ifstream file(path);
     if (!file.is_open()) {
@@ -406,4 +507,4 @@ string readFileContent(const std::string& path) {
     file.close();
 
     return buffer.str();
-}
\ No newline at end of file
+}